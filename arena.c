@@ -0,0 +1,232 @@
+#include "compilador.h"
+
+/*
+ * Arena de una compilacion: la memoria se pide al sistema en bloques grandes
+ * y se reparte avanzando un indice. Nada se libera por separado; al terminar
+ * la compilacion resetArena vuelve todos los bloques al inicio y la siguiente
+ * compilacion los reutiliza sin volver a pedir memoria.
+ */
+
+/* Memoria de la compilacion actual (simbolos, tokens, indice de lineas) */
+Arena compilationArena = {NULL, NULL, {0, 0, 0, 0, 0}};
+
+/* Tamano minimo de un bloque pedido al sistema */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/* Desde este tamano una reserva ocupa un bloque propio, que puede crecer en
+   el lugar (los arreglos que se duplican no dejan copias viejas) */
+#define ARENA_LARGE_SIZE (16 * 1024)
+
+/* Alineacion de cada reserva (suficiente para cualquier tipo basico) */
+#define ARENA_ALIGNMENT 16
+
+/* Bloque de memoria pedido al sistema */
+struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;           // Bytes utiles del bloque
+    size_t used;           // Bytes ya repartidos
+    size_t padding;        // Mantiene data alineado a ARENA_ALIGNMENT
+    char data[];
+};
+
+/**
+ * Redondea un tamano al multiplo de la alineacion
+ * @param size: Tamano pedido
+ * @return: Tamano alineado
+ */
+static inline size_t alignArenaSize(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * Registra bytes repartidos y actualiza el pico
+ * @param arena: Arena
+ * @param bytes: Bytes agregados
+ */
+static inline void countArenaBytes(Arena* arena, size_t bytes) {
+    arena->stats.bytesInUse += bytes;
+    if (arena->stats.bytesInUse > arena->stats.peakBytes) {
+        arena->stats.peakBytes = arena->stats.bytesInUse;
+    }
+}
+
+/**
+ * Obtiene un bloque sin uso de al menos size bytes: el mas chico de los que
+ * quedaron libres despues de un resetArena y si no hay, uno nuevo del sistema
+ * @param arena: Arena
+ * @param size: Bytes necesarios (ya alineados)
+ * @param minimum: Tamano minimo de un bloque nuevo
+ * @return: Bloque vacio, o NULL si no hubo memoria
+ */
+static ArenaBlock* takeArenaBlock(Arena* arena, size_t size, size_t minimum) {
+    ArenaBlock* best = NULL;
+    for (ArenaBlock* block = arena->first; block != NULL; block = block->next) {
+        if (block->used == 0 && block != arena->current && block->size >= size &&
+            (best == NULL || block->size < best->size)) {
+            best = block;
+        }
+    }
+    if (best != NULL) {
+        return best;
+    }
+
+    size_t blockSize = size > minimum ? size : minimum;
+    ArenaBlock* fresh = (ArenaBlock*)malloc(sizeof(ArenaBlock) + blockSize);
+    if (fresh == NULL) {
+        return NULL;
+    }
+    fresh->size = blockSize;
+    fresh->used = 0;
+    fresh->next = arena->first;
+    arena->first = fresh;
+    arena->stats.systemAllocations++;
+    arena->stats.reservedBytes += blockSize;
+    return fresh;
+}
+
+/**
+ * Reserva memoria en la arena (sin inicializar)
+ * @param arena: Arena
+ * @param size: Bytes a reservar
+ * @return: Puntero alineado, o NULL si no hubo memoria
+ */
+void* arenaAlloc(Arena* arena, size_t size) {
+    size_t aligned = alignArenaSize(size ? size : 1);
+    ArenaBlock* block = arena->current;
+
+    if (aligned >= ARENA_LARGE_SIZE) {
+        // Bloque propio, fuera del que se reparte de a poco
+        block = takeArenaBlock(arena, aligned, aligned);
+    } else if (block == NULL || block->size - block->used < aligned) {
+        block = takeArenaBlock(arena, aligned, ARENA_BLOCK_SIZE);
+        if (block != NULL) {
+            arena->current = block;
+        }
+    }
+    if (block == NULL) {
+        return NULL;
+    }
+
+    void* memory = block->data + block->used;
+    block->used += aligned;
+    arena->stats.allocations++;
+    countArenaBytes(arena, aligned);
+    return memory;
+}
+
+/**
+ * Agranda una reserva sin copiarla cuando se puede: si es la ultima del
+ * bloque actual o si ocupa un bloque propio. Si no, se copia a una reserva
+ * nueva y la anterior queda sin uso hasta el proximo resetArena.
+ * @param arena: Arena
+ * @param memory: Reserva anterior (NULL para reservar por primera vez)
+ * @param oldSize: Tamano de la reserva anterior
+ * @param newSize: Tamano nuevo (mayor que oldSize)
+ * @return: Reserva agrandada, o NULL si no hubo memoria (la anterior sigue valida)
+ */
+void* arenaResize(Arena* arena, void* memory, size_t oldSize, size_t newSize) {
+    size_t oldAligned = alignArenaSize(oldSize ? oldSize : 1);
+    size_t newAligned = alignArenaSize(newSize);
+    ArenaBlock* current = arena->current;
+
+    if (memory == NULL) {
+        return arenaAlloc(arena, newSize);
+    }
+
+    // Ultima reserva del bloque que se reparte de a poco
+    if (current != NULL && (char*)memory + oldAligned == current->data + current->used &&
+        current->used - oldAligned + newAligned <= current->size) {
+        current->used += newAligned - oldAligned;
+        countArenaBytes(arena, newAligned - oldAligned);
+        return memory;
+    }
+
+    // Reserva sola en su bloque: crece dentro del bloque, se muda a un bloque
+    // libre mas grande (el suyo queda libre) o crece con realloc
+    ArenaBlock** link = &arena->first;
+    while (*link != NULL && (*link)->data != (char*)memory) {
+        link = &(*link)->next;
+    }
+    ArenaBlock* block = *link;
+    if (block != NULL && block != current && block->used == oldAligned) {
+        ArenaBlock* spare = NULL;
+        for (ArenaBlock* other = arena->first; other != NULL; other = other->next) {
+            if (other->used == 0 && other != current && other->size >= newAligned &&
+                (spare == NULL || other->size < spare->size)) {
+                spare = other;
+            }
+        }
+        if (newAligned > block->size && spare != NULL) {
+            memcpy(spare->data, memory, oldSize);
+            spare->used = newAligned;
+            block->used = 0;
+            countArenaBytes(arena, newAligned - oldAligned);
+            return spare->data;
+        }
+        if (newAligned > block->size) {
+            ArenaBlock* grown = (ArenaBlock*)realloc(block, sizeof(ArenaBlock) + newAligned);
+            if (grown == NULL) {
+                return NULL;
+            }
+            arena->stats.systemAllocations++;
+            arena->stats.reservedBytes += newAligned - grown->size;
+            grown->size = newAligned;
+            *link = block = grown;
+        }
+        block->used = newAligned;
+        countArenaBytes(arena, newAligned - oldAligned);
+        return block->data;
+    }
+
+    void* grown = arenaAlloc(arena, newSize);
+    if (grown != NULL) {
+        memcpy(grown, memory, oldSize);
+    }
+    return grown;
+}
+
+/**
+ * Copia un texto a la arena agregando el '\0' final
+ * @param arena: Arena
+ * @param text: Texto a copiar (no necesita terminar en '\0')
+ * @param length: Longitud del texto
+ * @return: Copia terminada en '\0', o NULL si no hubo memoria
+ */
+char* arenaCopyText(Arena* arena, const char* text, size_t length) {
+    char* copy = (char*)arenaAlloc(arena, length + 1);
+    if (copy != NULL) {
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+/**
+ * Vuelve todos los bloques al inicio conservandolos para la proxima
+ * compilacion. Las estadisticas de uso comienzan de nuevo.
+ * @param arena: Arena a reiniciar
+ */
+void resetArena(Arena* arena) {
+    for (ArenaBlock* block = arena->first; block != NULL; block = block->next) {
+        block->used = 0;
+    }
+    arena->current = NULL;
+    arena->stats.allocations = 0;
+    arena->stats.systemAllocations = 0;
+    arena->stats.bytesInUse = 0;
+    arena->stats.peakBytes = 0;
+}
+
+/**
+ * Devuelve todos los bloques al sistema
+ * @param arena: Arena a liberar
+ */
+void freeArena(Arena* arena) {
+    ArenaBlock* block = arena->first;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    memset(arena, 0, sizeof(Arena));
+}
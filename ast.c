@@ -0,0 +1,425 @@
+#include "compilador.h"
+
+/*
+ * Arbol sintactico en un arreglo contiguo. El parser agrega los nodos en el
+ * orden en que los encuentra, que es el preorden del arbol: un nodo va seguido
+ * de su primer hijo y los hermanos se enlazan por indice de 32 bits. Los
+ * recorridos de las fases siguientes avanzan por el arreglo sin saltar por
+ * punteros.
+ */
+
+/* Arbol del programa actual */
+Ast programAst = {NULL, 0, 0};
+
+/* Indice que no corresponde a ningun nodo (no hubo memoria) */
+#define AST_NONE 0xFFFFFFFFu
+
+/* Nodo abierto: el parser todavia le esta agregando hijos */
+typedef struct {
+    unsigned int node;
+    unsigned int lastChild;    // AST_NONE mientras no tenga hijos
+} AstOpenNode;
+
+/* Pila de nodos abiertos (de la raiz al nodo actual) */
+static AstOpenNode* openNodes = NULL;
+static unsigned int openCount = 0;
+static unsigned int openCapacity = 0;
+
+/* Niveles de sangria de --arbol; los nodos mas profundos muestran su nivel */
+#define AST_PRINT_MAX_INDENT 64
+
+/* Espacio de trabajo para pasar subarboles de postorden a preorden (los
+   subarboles de hasta AST_LOCAL_PLACEMENT nodos usan la pila) */
+#define AST_LOCAL_PLACEMENT 64
+static unsigned int* placement = NULL;
+static unsigned int placementCapacity = 0;
+
+/**
+ * Vacia el arbol (la memoria vuelve con la arena de la compilacion)
+ */
+void initAst() {
+    memset(&programAst, 0, sizeof(Ast));
+    openNodes = NULL;
+    openCount = openCapacity = 0;
+    placement = NULL;
+    placementCapacity = 0;
+}
+
+/**
+ * Asegura lugar para mas nodos en el arreglo
+ * @param extra: Cantidad de nodos que se van a agregar
+ * @return: 1 si hay lugar, 0 si no hubo memoria (se informa una sola vez)
+ */
+static int reserveAstNodes(unsigned int extra) {
+    if (programAst.count + extra <= programAst.capacity) {
+        return 1;
+    }
+
+    unsigned int capacity = programAst.capacity ? programAst.capacity * 2 : 256;
+    while (capacity < programAst.count + extra) {
+        capacity *= 2;
+    }
+    AstNode* grown = (AstNode*)arenaResize(&compilationArena, programAst.nodes,
+                                           (size_t)programAst.capacity * sizeof(AstNode),
+                                           (size_t)capacity * sizeof(AstNode));
+    if (grown == NULL) {
+        if (!hasError) printf("ERROR CRITICO: No se pudo asignar memoria para el arbol sintactico\n");
+        hasError = 1;
+        return 0;
+    }
+    programAst.nodes = grown;
+    programAst.capacity = capacity;
+    return 1;
+}
+
+/**
+ * Abre un nodo: los nodos que se agreguen hasta endAstNode son sus hijos
+ * @param node: Indice del nodo (AST_NONE si no se pudo crear)
+ * @param lastChild: Ultimo hijo que ya tiene (AST_NONE si ninguno)
+ */
+static void pushOpenNode(unsigned int node, unsigned int lastChild) {
+    if (openCount == openCapacity) {
+        unsigned int capacity = openCapacity ? openCapacity * 2 : 64;
+        AstOpenNode* grown = (AstOpenNode*)arenaResize(&compilationArena, openNodes,
+                                                       (size_t)openCapacity * sizeof(AstOpenNode),
+                                                       (size_t)capacity * sizeof(AstOpenNode));
+        if (grown == NULL) {
+            if (!hasError) printf("ERROR CRITICO: No se pudo asignar memoria para el arbol sintactico\n");
+            hasError = 1;
+            // Sin lugar en la pila el nodo queda cerrado; endAstNode no lo encontrara
+            return;
+        }
+        openNodes = grown;
+        openCapacity = capacity;
+    }
+    openNodes[openCount].node = node;
+    openNodes[openCount].lastChild = lastChild;
+    openCount++;
+}
+
+/**
+ * Enlaza un nodo ya ubicado en el arreglo como ultimo hijo del nodo abierto
+ * @param index: Indice del nodo
+ */
+static void linkAstChild(unsigned int index) {
+    if (openCount > 0) {
+        AstOpenNode* parent = &openNodes[openCount - 1];
+        if (parent->node != AST_NONE) {
+            if (parent->lastChild != AST_NONE) {
+                programAst.nodes[parent->lastChild].nextSibling = index;
+            }
+            programAst.nodes[parent->node].childCount++;
+            parent->lastChild = index;
+        }
+    }
+}
+
+/**
+ * Agrega un nodo al final del arreglo como ultimo hijo del nodo abierto
+ * @param kind: Clase de nodo
+ * @param token: Token que origina el nodo (posicion, valor y operador)
+ * @return: Indice del nodo, o AST_NONE si no hubo memoria
+ */
+static unsigned int appendAstNode(AstKind kind, Token token) {
+    if (!reserveAstNodes(1)) {
+        return AST_NONE;
+    }
+
+    unsigned int index = programAst.count++;
+    AstNode* node = &programAst.nodes[index];
+    node->kind = (unsigned char)kind;
+    node->op = (unsigned char)token.type;
+    node->dataType = (unsigned char)(kind == AST_INT_LITERAL ? TYPE_ENTERO :
+                                     kind == AST_REAL_LITERAL ? TYPE_REAL :
+                                     kind == AST_CHAR_LITERAL ? TYPE_CARACTER : TYPE_ERROR);
+    node->flags = 0;
+    node->childCount = 0;
+    node->nextSibling = 0;
+    node->value = token.value;
+    node->offset = token.offset;
+
+    linkAstChild(index);
+    return index;
+}
+
+/**
+ * Agrega un nodo y lo deja abierto para recibir hijos
+ * @param kind: Clase de nodo
+ * @param token: Token que origina el nodo
+ * @return: Indice del nodo
+ */
+unsigned int beginAstNode(AstKind kind, Token token) {
+    unsigned int index = appendAstNode(kind, token);
+    pushOpenNode(index, AST_NONE);
+    return index;
+}
+
+/**
+ * Cierra el nodo abierto mas reciente
+ */
+void endAstNode() {
+    if (openCount > 0) {
+        openCount--;
+    }
+}
+
+/**
+ * Agrega un nodo sin hijos
+ * @param kind: Clase de nodo
+ * @param token: Token que origina el nodo
+ * @return: Indice del nodo
+ */
+unsigned int addAstLeaf(AstKind kind, Token token) {
+    return appendAstNode(kind, token);
+}
+
+/**
+ * Espacio de trabajo de addAstPostorder para subarboles grandes, reutilizado
+ * entre llamadas
+ * @param count: Cantidad de nodos del subarbol
+ * @return: Arreglo de count posiciones, o NULL si no hubo memoria
+ */
+static unsigned int* reservePlacement(unsigned int count) {
+    if (count > placementCapacity) {
+        unsigned int capacity = placementCapacity ? placementCapacity : 256;
+        while (capacity < count) {
+            capacity *= 2;
+        }
+        unsigned int* grown = (unsigned int*)arenaResize(&compilationArena, placement,
+                                                         (size_t)placementCapacity * sizeof(unsigned int),
+                                                         (size_t)capacity * sizeof(unsigned int));
+        if (grown == NULL) {
+            if (!hasError) printf("ERROR CRITICO: No se pudo asignar memoria para el arbol sintactico\n");
+            hasError = 1;
+            return NULL;
+        }
+        placement = grown;
+        placementCapacity = capacity;
+    }
+    return placement;
+}
+
+/**
+ * Agrega un subarbol armado en postorden (cada nodo despues de sus hijos,
+ * como lo produce el analisis de expresiones con pilas) como ultimo hijo del
+ * nodo abierto, pasandolo a preorden sin recursion. Un padre va antes que
+ * sus hijos en preorden, asi que recorriendo el postorden hacia atras cada
+ * nodo ya tiene su posicion cuando se lo visita: el subarbol de un hijo
+ * termina donde empieza el de su hermano siguiente.
+ * @param nodes: Nodos en postorden con childCount y, en nextSibling, la
+ *               cantidad de nodos de su subarbol; el ultimo es la raiz
+ * @param count: Cantidad de nodos (0 = no hay subarbol)
+ * @return: Indice de la raiz en programAst, o AST_NONE si no hay subarbol
+ */
+unsigned int addAstPostorder(const AstNode* nodes, unsigned int count) {
+    unsigned int local[AST_LOCAL_PLACEMENT];
+    unsigned int* preorder = count <= AST_LOCAL_PLACEMENT ? local : reservePlacement(count);
+
+    if (count == 0 || preorder == NULL || !reserveAstNodes(count)) {
+        return AST_NONE;
+    }
+
+    // La raiz se ubica primero; cada hijo se ubica al visitar a su padre
+    unsigned int base = programAst.count;
+    AstNode* placed = programAst.nodes;
+    preorder[count - 1] = base;
+    placed[base] = nodes[count - 1];
+    placed[base].nextSibling = 0;
+    for (unsigned int p = count; p-- > 0;) {
+        unsigned int end = preorder[p] + nodes[p].nextSibling;
+        unsigned int next = 0, child = p;
+        for (unsigned int c = 0; c < nodes[p].childCount; c++) {
+            unsigned int last = child - 1;
+            unsigned int position = end - nodes[last].nextSibling;
+            preorder[last] = position;
+            placed[position] = nodes[last];
+            placed[position].nextSibling = next;
+            next = end = position;
+            child -= nodes[last].nextSibling;
+        }
+    }
+    programAst.count += count;
+
+    linkAstChild(base);
+    return base;
+}
+
+/**
+ * Marca todos los nodos abiertos: se informo un error mientras se analizaban
+ */
+void markAstError() {
+    for (unsigned int i = 0; i < openCount; i++) {
+        if (openNodes[i].node != AST_NONE) {
+            programAst.nodes[openNodes[i].node].flags |= AST_FLAG_ERROR;
+        }
+    }
+}
+
+/**
+ * Obtiene el nombre de una clase de nodo
+ * @param kind: Clase de nodo
+ * @return: Nombre para listados
+ */
+const char* astKindName(AstKind kind) {
+    static const char* names[] = {
+        "PROGRAMA", "DECLARACION", "ASIGNACION", "SI", "MIENTRAS", "REPETIR", "LEER",
+        "ESCRIBIR", "BLOQUE", "OPERACION", "NO", "VARIABLE", "ENTERO", "REAL", "CARACTER"
+    };
+    return (kind >= AST_PROGRAM && kind <= AST_CHAR_LITERAL) ? names[kind] : "DESCONOCIDO";
+}
+
+/**
+ * Arma un token con la posicion de un nodo, para ubicarlo en el codigo fuente
+ * @param node: Nodo del arbol
+ * @return: Token con el offset del nodo
+ */
+static Token astNodeToken(unsigned int node) {
+    Token token;
+    memset(&token, 0, sizeof(Token));
+    token.offset = programAst.nodes[node].offset;
+    return token;
+}
+
+/**
+ * Obtiene la linea de un nodo del arbol
+ * @param node: Nodo
+ * @return: Linea del codigo fuente
+ */
+int astNodeLine(unsigned int node) {
+    return getTokenLine(astNodeToken(node));
+}
+
+/**
+ * Obtiene la columna de un nodo del arbol
+ * @param node: Nodo
+ * @return: Columna del codigo fuente (comenzando en 1)
+ */
+int astNodeColumn(unsigned int node) {
+    return getTokenColumn(astNodeToken(node));
+}
+
+/**
+ * Obtiene el texto de un operador
+ * @param op: Tipo de token del operador
+ * @return: Operador como aparece en el codigo fuente
+ */
+static const char* astOperatorText(TokenType op) {
+    switch (op) {
+        case TOKEN_PLUS: return "+";
+        case TOKEN_MINUS: return "-";
+        case TOKEN_MULTIPLY: return "*";
+        case TOKEN_DIVIDE: return "/";
+        case TOKEN_MOD: return "%";
+        case TOKEN_EQUAL: return "=";
+        case TOKEN_NOT_EQUAL: return "<>";
+        case TOKEN_LESS: return "<";
+        case TOKEN_LESS_EQUAL: return "<=";
+        case TOKEN_GREATER: return ">";
+        case TOKEN_GREATER_EQUAL: return ">=";
+        case TOKEN_AND: return "y";
+        case TOKEN_OR: return "o";
+        case TOKEN_NOT: return "no";
+        default: return "?";
+    }
+}
+
+/**
+ * Muestra el nombre de la variable de un nodo: el del simbolo resuelto o,
+ * si no estaba declarada, el identificador tal como aparece en el codigo
+ * @param node: Nodo con nombre (declaracion, asignacion, lectura o variable)
+ */
+static void printAstName(const AstNode* node) {
+    if (node->value.intValue >= 0) {
+        printf(" %s", symbolTable.entries[node->value.intValue].name);
+        return;
+    }
+    const char* name = sourceCode + node->offset;
+    int length = 0;
+    while (isalnum((unsigned char)name[length]) || name[length] == '_') {
+        length++;
+    }
+    printf(" %.*s", length, name);
+}
+
+/**
+ * Muestra un nodo con sangria segun la profundidad. Pasado
+ * AST_PRINT_MAX_INDENT niveles la sangria no crece y se indica el nivel.
+ * @param index: Indice del nodo
+ * @param depth: Profundidad del nodo
+ */
+static void printAstNode(unsigned int index, unsigned int depth) {
+    const AstNode* node = &programAst.nodes[index];
+    char typeStr[15];
+
+    if (depth > AST_PRINT_MAX_INDENT) {
+        printf("%6u  %*s[nivel %u] %s", index, AST_PRINT_MAX_INDENT * 2, "", depth,
+               astKindName((AstKind)node->kind));
+    } else {
+        printf("%6u  %*s%s", index, (int)depth * 2, "", astKindName((AstKind)node->kind));
+    }
+    switch (node->kind) {
+        case AST_DECLARATION:
+        case AST_ASSIGN:
+        case AST_READ:
+        case AST_VARIABLE:
+            printAstName(node);
+            break;
+        case AST_BINARY:
+            printf(" %s", astOperatorText((TokenType)node->op));
+            break;
+        case AST_INT_LITERAL:
+            printf(" %d", node->value.intValue);
+            break;
+        case AST_REAL_LITERAL:
+            printf(" %g", node->value.realValue);
+            break;
+        case AST_CHAR_LITERAL:
+            printf(" '%c'", node->value.charValue);
+            break;
+        default:
+            break;
+    }
+    if (node->dataType != TYPE_ERROR) {
+        dataTypeToString((DataType)node->dataType, typeStr);
+        printf(" : %s", typeStr);
+    }
+    if (node->flags & AST_FLAG_FOLDED) {
+        printf("  [plegado]");
+    }
+    printf(node->flags & AST_FLAG_ERROR ? "  [error]\n" : "\n");
+}
+
+/**
+ * Muestra el arbol sintactico completo y su tamano
+ */
+void printAst() {
+    printf("\n=== ARBOL SINTACTICO ===\n");
+    if (programAst.count > 0) {
+        // Hijos que faltan mostrar de cada nodo abierto, de la raiz al actual:
+        // los nodos estan en preorden, asi que basta recorrer el arreglo
+        unsigned int* pending = (unsigned int*)arenaAlloc(&compilationArena,
+                                                          ((size_t)programAst.count + 1) * sizeof(unsigned int));
+        unsigned int levels = 1, index = 0;
+        if (pending == NULL) {
+            printf("ERROR CRITICO: No se pudo asignar memoria para mostrar el arbol sintactico\n");
+            levels = 0;
+        } else {
+            pending[0] = 1;
+        }
+        while (levels > 0) {
+            const AstNode* node = &programAst.nodes[index];
+            printAstNode(index, levels - 1);
+            pending[levels - 1]--;
+            if (node->childCount > 0) {
+                pending[levels++] = node->childCount;
+            }
+            while (levels > 0 && pending[levels - 1] == 0) {
+                levels--;
+            }
+            index++;
+        }
+    }
+    printf("========================\n");
+    printf("Nodos: %u | Bytes por nodo: %lu | Total: %.1f KB\n", programAst.count,
+           (unsigned long)sizeof(AstNode), programAst.count * (double)sizeof(AstNode) / 1024.0);
+}
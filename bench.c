@@ -0,0 +1,891 @@
+#define _POSIX_C_SOURCE 200809L
+#include "compilador.h"
+#include <time.h>
+
+/* ========== GENERACION DE PROGRAMAS DE PRUEBA ========== */
+
+/* Buffer dinamico para construir programas generados */
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} TextBuffer;
+
+/**
+ * Agrega texto al final de un buffer dinamico
+ * @param buffer: Buffer destino
+ * @param text: Texto a agregar
+ */
+static void appendText(TextBuffer* buffer, const char* text) {
+    size_t length = strlen(text);
+
+    if (buffer->length + length + 1 > buffer->capacity) {
+        size_t newCapacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        while (newCapacity < buffer->length + length + 1) newCapacity *= 2;
+
+        char* newData = (char*)realloc(buffer->data, newCapacity);
+        if (newData == NULL) {
+            printf("ERROR CRITICO: No se pudo asignar memoria para el programa de prueba\n");
+            exit(1);
+        }
+        buffer->data = newData;
+        buffer->capacity = newCapacity;
+    }
+
+    memcpy(buffer->data + buffer->length, text, length + 1);
+    buffer->length += length;
+}
+
+/**
+ * Entrega el contenido de un buffer dinamico como codigo fuente, agregando
+ * el relleno en cero que espera el analizador lexico
+ * @param buffer: Buffer con el texto generado (queda vacio)
+ * @param source: Codigo fuente resultante
+ * @return: 1 si se pudo completar, 0 en caso contrario
+ */
+static int finishSourceBuffer(TextBuffer* buffer, SourceBuffer* source) {
+    char* data = (char*)realloc(buffer->data, buffer->length + SOURCE_PADDING);
+    if (data == NULL) {
+        free(buffer->data);
+        return 0;
+    }
+
+    memset(data + buffer->length, 0, SOURCE_PADDING);
+    source->data = data;
+    source->length = buffer->length;
+    source->mappedSize = 0;
+
+    buffer->data = NULL;
+    buffer->length = buffer->capacity = 0;
+    return 1;
+}
+
+/**
+ * Generador pseudoaleatorio determinista (congruencial lineal)
+ * @param seed: Estado del generador, se actualiza en cada llamada
+ * @return: Numero pseudoaleatorio
+ */
+static unsigned int nextRandom(unsigned int* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (*seed >> 16) & 0x7FFF;
+}
+
+/**
+ * Agrega el relleno propio de cada estilo de programa generado
+ * @param buffer: Buffer destino
+ * @param style: Estilo del programa
+ * @param value: Valor pseudoaleatorio para variar el relleno
+ */
+static void appendStylePadding(TextBuffer* buffer, BenchmarkStyle style, int value) {
+    if (style == BENCH_STYLE_WHITESPACE) {
+        // Lineas en blanco con espacios finales y sangria profunda
+        appendText(buffer, "\n    \t    \r\n\n                                        \t\t");
+        if (value % 2) appendText(buffer, "                                \n\t\t\t\t\t\t\t\t");
+    } else if (style == BENCH_STYLE_COMMENTS) {
+        appendText(buffer, "// Comentario extenso: describe la sentencia siguiente con bastante detalle\n");
+        appendText(buffer, "// para que los cuerpos de comentario dominen el tamano del codigo fuente.\n");
+        if (value % 2) appendText(buffer, "// (linea adicional de comentario con simbolos := <> ; { } 'x' \"y\")\n");
+    }
+}
+
+/**
+ * Genera un programa sintacticamente valido para medir rendimiento
+ * @param statementCount: Cantidad de sentencias a generar
+ * @param seed: Semilla del generador (mismos valores producen el mismo programa)
+ * @param style: Estilo del programa (mixto, con muchos blancos, con muchos
+ *               comentarios o con muchas variables)
+ * @param source: Buffer donde se deja el programa (liberar con releaseSource)
+ * @return: 1 si se genero correctamente, 0 en caso contrario
+ */
+int generateBenchmarkProgram(int statementCount, unsigned int seed, BenchmarkStyle style, SourceBuffer* source) {
+    TextBuffer buffer = {NULL, 0, 0};
+    char line[256];
+    int variables = (style == BENCH_STYLE_VARIABLES) ? 20000 : 64;
+
+    appendText(&buffer, "// Programa generado para medicion de rendimiento\n");
+    for (int i = 0; i < variables; i++) {
+        sprintf(line, "%s v%d;\n", (i % 4 == 3) ? "real" : "entero", i);
+        appendText(&buffer, line);
+    }
+
+    for (int i = 0; i < statementCount; i++) {
+        int a = (int)(nextRandom(&seed) % (unsigned int)variables);
+        int b = (int)(nextRandom(&seed) % (unsigned int)variables);
+        int c = (int)(nextRandom(&seed) % (unsigned int)variables);
+        int value = nextRandom(&seed) % 1000;
+
+        appendStylePadding(&buffer, style, value);
+        switch (nextRandom(&seed) % 6) {
+            case 0:
+                sprintf(line, "v%d := v%d + v%d * %d;\n", a, b, c, value);
+                break;
+            case 1:
+                sprintf(line, "si (v%d <= %d) {\n    v%d := v%d - 1;\n} sino {\n    v%d := (v%d + %d) %% 7;\n}\n",
+                        a, value, b, b, c, a, value);
+                break;
+            case 2:
+                sprintf(line, "mientras (v%d < %d y v%d <> 0) {\n    v%d := v%d + 1;\n}\n", a, value, b, a, a);
+                break;
+            case 3:
+                sprintf(line, "// Comentario de relleno numero %d\nescribir(v%d);\n", value, a);
+                break;
+            case 4:
+                sprintf(line, "repetir {\n    v%d := v%d / 2;\n} hasta (v%d >= %d.%d);\n", a, a, a, value, c);
+                break;
+            default:
+                sprintf(line, "leer(v%d);\n", a);
+                break;
+        }
+        appendText(&buffer, line);
+    }
+
+    return finishSourceBuffer(&buffer, source);
+}
+
+/**
+ * Genera un programa con muchos bloques que declaran variables, ocultando en
+ * cada uno la variable exterior x
+ * @param blockCount: Cantidad de bloques
+ * @param nested: 1 para anidar cada bloque dentro del anterior, 0 para
+ *                ponerlos uno despues del otro
+ * @param source: Buffer donde se deja el programa (liberar con releaseSource)
+ * @return: 1 si se genero correctamente, 0 en caso contrario
+ */
+static int generateScopeProgram(int blockCount, int nested, SourceBuffer* source) {
+    TextBuffer buffer = {NULL, 0, 0};
+    char line[128];
+
+    appendText(&buffer, "entero x, total;\nx := 0;\ntotal := 0;\n");
+    for (int i = 0; i < blockCount; i++) {
+        sprintf(line, "mientras (x < %d) {\n    entero x, t%d;\n    real r;\n    t%d := total + %d;\n    x := t%d;\n",
+                i, i % 100, i % 100, i, i % 100);
+        appendText(&buffer, line);
+        if (!nested) {
+            appendText(&buffer, "}\n");
+        }
+    }
+    if (nested) {
+        for (int i = 0; i < blockCount; i++) {
+            appendText(&buffer, "}\n");
+        }
+    }
+    appendText(&buffer, "total := x + 1;\n");
+
+    return finishSourceBuffer(&buffer, source);
+}
+
+/**
+ * Genera un programa de sentencias si, mientras y repetir anidadas cada una
+ * dentro de la anterior. x se lee, asi ninguna condicion se conoce al compilar.
+ * @param depth: Cantidad de sentencias anidadas
+ * @param source: Buffer donde se deja el programa (liberar con releaseSource)
+ * @return: 1 si se genero correctamente, 0 en caso contrario
+ */
+static int generateNestedControlProgram(int depth, SourceBuffer* source) {
+    TextBuffer buffer = {NULL, 0, 0};
+    char line[128];
+
+    appendText(&buffer, "entero x, total;\nleer(x);\ntotal := 0;\n");
+    for (int i = 0; i < depth; i++) {
+        if (i % 3 == 0) {
+            sprintf(line, "si (x > %d) {\n    total := total + %d;\n", i, i);
+        } else if (i % 3 == 1) {
+            sprintf(line, "mientras (x < %d) {\n    x := x + 1;\n", i);
+        } else {
+            sprintf(line, "repetir {\n    total := total - %d;\n", i);
+        }
+        appendText(&buffer, line);
+    }
+    for (int i = depth - 1; i >= 0; i--) {
+        if (i % 3 == 2) {
+            sprintf(line, "} hasta (total < %d);\n", i);
+            appendText(&buffer, line);
+        } else {
+            appendText(&buffer, "}\n");
+        }
+    }
+    appendText(&buffer, "x := total + 1;\n");
+
+    return finishSourceBuffer(&buffer, source);
+}
+
+/* ========== MEDICIONES ========== */
+
+/**
+ * Obtiene el tiempo actual de un reloj monotono
+ * @return: Tiempo en segundos
+ */
+double getCurrentSeconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Mide el rendimiento del analizador lexico sobre un codigo fuente
+ * @param name: Nombre descriptivo del corpus
+ * @param source: Codigo fuente a tokenizar
+ * @param repetitions: Cantidad de pasadas completas sobre el codigo
+ */
+void benchmarkLexer(const char* name, SourceBuffer* source, int repetitions) {
+    long tokenCount = 0;
+    unsigned long checksum = 0;
+    size_t length = source->length;
+    double start = getCurrentSeconds();
+
+    for (int r = 0; r < repetitions; r++) {
+        initLexer(source->data, source->length);
+        tokenCount++;
+        while (currentToken.type != TOKEN_EOF) {
+            currentToken = getNextToken();
+            checksum = checksum * 31u + currentToken.type + currentToken.offset + (unsigned int)currentToken.value.intValue;
+            tokenCount++;
+        }
+    }
+
+    double elapsed = getCurrentSeconds() - start;
+    printf("%-22s %10ld tokens %8.3f s %8.2f Mtok/s %8.1f MB/s  [%08lx]\n", name, tokenCount, elapsed,
+           tokenCount / elapsed / 1e6, (double)length * repetitions / elapsed / 1e6, checksum & 0xFFFFFFFFul);
+}
+
+/**
+ * Compara los nucleos de busqueda (escalar, SSE2, AVX2) sobre programas
+ * dominados por blancos y por comentarios. La suma de control final debe
+ * coincidir entre niveles.
+ */
+void benchmarkScanKernels() {
+    static const BenchmarkStyle styles[] = {BENCH_STYLE_WHITESPACE, BENCH_STYLE_COMMENTS};
+    static const char* styleNames[] = {"blancos", "comentarios"};
+    ScanKernelLevel best = detectScanKernelLevel();
+    char name[64];
+
+    for (int s = 0; s < 2; s++) {
+        SourceBuffer program;
+        if (!generateBenchmarkProgram(100000, 777u, styles[s], &program)) {
+            return;
+        }
+
+        for (int level = SCAN_SCALAR; level <= (int)best; level++) {
+            selectScanKernels((ScanKernelLevel)level);
+            sprintf(name, "%s/%s", styleNames[s], scanKernelLevelName((ScanKernelLevel)level));
+            benchmarkLexer(name, &program, 5);
+        }
+        releaseSource(&program);
+    }
+
+    selectScanKernels(best);
+}
+
+/**
+ * Suma de control de una secuencia de tokens (tipo, posicion y valor)
+ * @param tokens: Tokens a resumir
+ * @return: Suma de control
+ */
+static unsigned long tokenChecksum(const TokenArray* tokens) {
+    unsigned long checksum = 0;
+    for (size_t i = 0; i < tokens->count; i++) {
+        checksum = checksum * 31u + tokens->types[i] + tokens->offsets[i] + (unsigned int)tokens->values[i].intValue;
+    }
+    return checksum;
+}
+
+/**
+ * Mide el analisis lexico por adelantado con 1, 2, 4, 8... hilos y verifica
+ * que la secuencia unida coincida con la del analisis secuencial
+ * @param name: Nombre descriptivo del corpus
+ * @param source: Codigo fuente a tokenizar
+ */
+void benchmarkParallelLexer(const char* name, SourceBuffer* source) {
+    const int repetitions = 5;
+    int processors = detectProcessorCount();
+    int maxThreads = processors > 8 ? processors : 8;
+    double singleThreadTime = 0.0;
+    unsigned long expected = 0;
+    char label[64];
+
+    initLexer(source->data, source->length);
+    for (;;) {
+        expected = expected * 31u + currentToken.type + currentToken.offset + (unsigned int)currentToken.value.intValue;
+        if (currentToken.type == TOKEN_EOF) break;
+        currentToken = getNextToken();
+    }
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        TokenArray tokens;
+        double start = getCurrentSeconds();
+
+        for (int r = 0; r < repetitions; r++) {
+            resetArena(&compilationArena);
+            if (!tokenizeSource(source, threads, &tokens)) {
+                return;
+            }
+        }
+        double elapsed = getCurrentSeconds() - start;
+
+        unsigned long checksum = tokenChecksum(&tokens);
+        if (threads == 1) {
+            singleThreadTime = elapsed;
+        }
+
+        sprintf(label, "%s/%d hilos", name, threads);
+        printf("%-22s %10ld tokens %8.3f s %8.2f Mtok/s  x%.2f  [%08lx] %s\n", label,
+               (long)tokens.count * repetitions, elapsed, tokens.count * (double)repetitions / elapsed / 1e6,
+               singleThreadTime / elapsed, checksum & 0xFFFFFFFFul,
+               checksum == expected ? "coincide" : "DIFIERE del analisis secuencial");
+        freeTokenArray(&tokens);
+    }
+    resetArena(&compilationArena);
+}
+
+/**
+ * Muestra el uso de memoria de la compilacion actual (arena de la
+ * compilacion mas la de la tabla de nombres)
+ * @param label: Descripcion de la compilacion
+ */
+static void printArenaUsage(const char* label) {
+    const ArenaStats* compilation = &compilationArena.stats;
+    const ArenaStats* names = &identifierNames.storage.stats;
+
+    printf("%-22s %8lu reservas %4lu bloques nuevos  pico %8.1f KB  reservado %8.1f KB\n", label,
+           (unsigned long)(compilation->allocations + names->allocations),
+           (unsigned long)(compilation->systemAllocations + names->systemAllocations),
+           (compilation->peakBytes + names->peakBytes) / 1024.0,
+           (compilation->reservedBytes + names->reservedBytes) / 1024.0);
+}
+
+/**
+ * Mide la memoria de dos compilaciones seguidas de un codigo fuente (con el
+ * analisis lexico intercalado y por adelantado). La segunda reutiliza los
+ * bloques que dejo la primera.
+ * @param name: Nombre descriptivo del corpus
+ * @param source: Codigo fuente a compilar
+ */
+void benchmarkMemory(const char* name, SourceBuffer* source) {
+    char label[64];
+
+    // La primera compilacion parte sin bloques
+    freeInternTable(&identifierNames);
+    freeArena(&compilationArena);
+    progressMessages = 0;
+    for (int pass = 1; pass <= 2; pass++) {
+        initSemantic();
+        initParser();
+        initLexer(source->data, source->length);
+        parseProgram();
+        sprintf(label, "%s/intercalado %d", name, pass);
+        printArenaUsage(label);
+        if (pass == 1) {
+            printf("%-22s %8u nodos del arbol x %lu bytes = %.1f KB\n", "", programAst.count,
+                   (unsigned long)sizeof(AstNode), programAst.count * (double)sizeof(AstNode) / 1024.0);
+        }
+        cleanup();
+    }
+
+    freeInternTable(&identifierNames);
+    freeArena(&compilationArena);
+    for (int pass = 1; pass <= 2; pass++) {
+        TokenArray tokens;
+        initSemantic();
+        initParser();
+        if (!tokenizeSource(source, 1, &tokens)) {
+            break;
+        }
+        useTokenStream(&tokens);
+        parseProgram();
+        sprintf(label, "%s/adelantado %d", name, pass);
+        printArenaUsage(label);
+        freeTokenArray(&tokens);
+        cleanup();
+    }
+    progressMessages = 1;
+}
+
+/**
+ * Mide la compilacion intercalada (el parser pide cada token al lexer), la
+ * compilacion con todos los tokens reconocidos por adelantado, separando el
+ * tiempo del analisis lexico del sintactico y semantico, y la tuberia con el
+ * lexer en otro hilo
+ * @param name: Nombre descriptivo del corpus
+ * @param source: Codigo fuente a compilar
+ */
+void benchmarkPhases(const char* name, SourceBuffer* source) {
+    const int repetitions = 3;
+    double interleavedTime = 0.0, lexTime = 0.0, parseTime = 0.0, pipelineTime = 0.0;
+    size_t tokenCount = 0;
+    int errors = 0;
+
+    progressMessages = 0;
+    for (int r = 0; r < repetitions; r++) {
+        TokenArray tokens;
+        double start = getCurrentSeconds();
+        initSemantic();
+        initParser();
+        initLexer(source->data, source->length);
+        parseProgram();
+        interleavedTime += getCurrentSeconds() - start;
+        errors += hasError;
+        cleanup();
+
+        start = getCurrentSeconds();
+        if (!tokenizeSource(source, 1, &tokens)) {
+            break;
+        }
+        lexTime += getCurrentSeconds() - start;
+
+        start = getCurrentSeconds();
+        initSemantic();
+        initParser();
+        useTokenStream(&tokens);
+        parseProgram();
+        parseTime += getCurrentSeconds() - start;
+        errors += hasError;
+        cleanup();
+
+        tokenCount = tokens.count;
+        freeTokenArray(&tokens);
+
+        start = getCurrentSeconds();
+        initSemantic();
+        initParser();
+        TokenPipeline* pipeline = startTokenPipeline(source);
+        if (pipeline == NULL) {
+            initLexer(source->data, source->length);
+        } else {
+            useTokenPipeline(pipeline);
+        }
+        parseProgram();
+        stopTokenPipeline(pipeline);
+        pipelineTime += getCurrentSeconds() - start;
+        errors += hasError;
+        cleanup();
+    }
+    progressMessages = 1;
+
+    double tokens = (double)tokenCount * repetitions;
+    printf("%-22s intercalado:  %8.3f s %8.2f Mtok/s\n", name, interleavedTime, tokens / interleavedTime / 1e6);
+    printf("%-22s por adelantado: lexico %8.3f s + sintactico %8.3f s = %8.3f s (%.2f Mtok/s)%s\n", "",
+           lexTime, parseTime, lexTime + parseTime, tokens / (lexTime + parseTime) / 1e6,
+           errors ? "  [con errores]" : "");
+    printf("%-22s tuberia:      %8.3f s %8.2f Mtok/s  x%.2f respecto del intercalado\n", "",
+           pipelineTime, tokens / pipelineTime / 1e6, interleavedTime / pipelineTime);
+}
+
+/**
+ * Mide la compilacion de programas con muchos bloques que declaran
+ * variables, con el cuadruple de bloques en cada paso: si salir de un ambito
+ * costara segun sus declaraciones o las busquedas recorrieran las ocultas,
+ * el tiempo por bloque creceria con el tamano
+ * @param nested: 1 para bloques anidados, 0 para bloques consecutivos
+ * @param firstCount: Cantidad de bloques del primer programa
+ */
+void benchmarkScopes(int nested, int firstCount) {
+    const int repetitions = 3;
+    progressMessages = 0;
+    for (int blockCount = firstCount; blockCount <= firstCount * 16; blockCount *= 4) {
+        SourceBuffer source;
+        double elapsed = 0.0;
+        int errors = 0;
+
+        if (!generateScopeProgram(blockCount, nested, &source)) {
+            break;
+        }
+        for (int r = 0; r < repetitions; r++) {
+            double start = getCurrentSeconds();
+            initSemantic();
+            initParser();
+            initLexer(source.data, source.length);
+            parseProgram();
+            elapsed += getCurrentSeconds() - start;
+            errors += hasError;
+            cleanup();
+        }
+        printf("%-10s %7d bloques  %8.3f s  %7.3f us por bloque%s\n", nested ? "anidados" : "seguidos",
+               blockCount, elapsed / repetitions, elapsed / repetitions / blockCount * 1e6,
+               errors ? "  [con errores]" : "");
+        releaseSource(&source);
+    }
+    progressMessages = 1;
+}
+
+/**
+ * Mide el armado del grafo de flujo de control y la propagacion condicional
+ * de constantes sobre programas con el cuadruple de sentencias en cada paso:
+ * el tiempo por sentencia se mantiene si las pasadas son lineales
+ * @param nested: 1 para sentencias de control anidadas, 0 para el programa mixto
+ * @param firstCount: Cantidad de sentencias del primer programa
+ */
+void benchmarkControlFlow(int nested, int firstCount) {
+    const int repetitions = 3;
+    progressMessages = 0;
+    for (int statementCount = firstCount; statementCount <= firstCount * 16; statementCount *= 4) {
+        SourceBuffer source;
+        double elapsed = 0.0;
+        unsigned int blocks = 0, removed = 0;
+        int errors = 0;
+
+        int generated = nested ? generateNestedControlProgram(statementCount, &source)
+                               : generateBenchmarkProgram(statementCount, 2024u, BENCH_STYLE_MIXED, &source);
+        if (!generated) {
+            break;
+        }
+        for (int r = 0; r < repetitions; r++) {
+            initSemantic();
+            initParser();
+            initLexer(source.data, source.length);
+            parseProgram();
+            errors += hasError;
+            if (!hasError) {
+                double start = getCurrentSeconds();
+                if (buildControlFlowGraph()) {
+                    propagateConditionalConstants();
+                }
+                elapsed += getCurrentSeconds() - start;
+                blocks = programCfg.blockCount;
+                removed = programCfg.removedBlocks;
+            }
+            cleanup();
+        }
+        printf("%-8s %8d sentencias  %8.3f s  %7.3f us por sentencia  %7u bloques (%u eliminados)%s\n",
+               nested ? "anidadas" : "mixtas", statementCount, elapsed / repetitions, elapsed / repetitions / statementCount * 1e6,
+               blocks, removed, errors ? "  [con errores]" : "");
+        releaseSource(&source);
+    }
+    progressMessages = 1;
+}
+
+/**
+ * Mide el analisis de variables inicializadas sobre el programa mixto y
+ * sobre uno con 20000 variables, donde los conjuntos de todos los bloques no
+ * entran juntos y las variables se resuelven por tramos
+ */
+void benchmarkDefiniteAssignment() {
+    const int repetitions = 3;
+    const BenchmarkStyle styles[2] = {BENCH_STYLE_MIXED, BENCH_STYLE_VARIABLES};
+    const char* names[2] = {"generado", "20000 variables"};
+
+    progressMessages = 0;
+    for (int i = 0; i < 2; i++) {
+        SourceBuffer source;
+        double elapsed = 0.0;
+        unsigned int flagged = 0, blocks = 0;
+        int errors = 0;
+
+        if (!generateBenchmarkProgram(100000, 4242u, styles[i], &source)) {
+            break;
+        }
+        for (int r = 0; r < repetitions; r++) {
+            initSemantic();
+            initParser();
+            initLexer(source.data, source.length);
+            parseProgram();
+            errors += hasError;
+            if (!hasError && buildControlFlowGraph()) {
+                propagateConditionalConstants();
+                double start = getCurrentSeconds();
+                flagged = checkDefiniteAssignment();
+                elapsed += getCurrentSeconds() - start;
+                blocks = programCfg.blockCount;
+            }
+            cleanup();
+        }
+        DataflowStats stats = getDataflowStats();
+        printf("%-22s %8.3f s  %7u bloques  %6u variables  %u pasadas  %lu bloques recalculados  %u usos sin asignar%s\n",
+               names[i], elapsed / repetitions, blocks, stats.variables, stats.passes, stats.blockVisits,
+               flagged, errors ? "  [con errores]" : "");
+        releaseSource(&source);
+    }
+    progressMessages = 1;
+}
+
+/* Programas para medir la maquina virtual: bucles sin entrada ni salida */
+static const char* vmBenchmarkNames[3] = {"enteros", "reales", "condiciones"};
+static const double vmBenchmarkIterations[3] = {4000000.0, 2000000.0, 2000000.0};
+static const char* vmBenchmarkPrograms[3] = {
+    "entero i, j, n, suma;\n"
+    "n := 2000;\n"
+    "suma := 0;\n"
+    "i := 0;\n"
+    "mientras (i < n) {\n"
+    "    j := 0;\n"
+    "    mientras (j < n) {\n"
+    "        suma := suma + i * j % 7;\n"
+    "        j := j + 1;\n"
+    "    }\n"
+    "    i := i + 1;\n"
+    "}\n",
+
+    "entero k;\n"
+    "real x, paso;\n"
+    "x := 0.0;\n"
+    "paso := 1.5;\n"
+    "k := 0;\n"
+    "repetir {\n"
+    "    x := x + paso * 0.5;\n"
+    "    paso := paso - x / 1000.0;\n"
+    "    k := k + 1;\n"
+    "} hasta (k >= 2000000);\n",
+
+    "entero i, pares, otros;\n"
+    "pares := 0;\n"
+    "otros := 0;\n"
+    "i := 0;\n"
+    "mientras (i < 2000000) {\n"
+    "    si (i % 2 = 0 y i % 3 <> 0) {\n"
+    "        pares := pares + 1;\n"
+    "    } sino {\n"
+    "        otros := otros + 1;\n"
+    "    }\n"
+    "    i := i + 1;\n"
+    "}\n"
+};
+
+/**
+ * Mide la maquina virtual con programas de bucles, con y sin
+ * superinstrucciones: cada programa se compila una vez por variante y se
+ * ejecuta varias veces, midiendo solo la ejecucion
+ */
+void benchmarkVirtualMachine() {
+    const int repetitions = 3;
+    progressMessages = 0;
+    for (size_t i = 0; i < sizeof(vmBenchmarkPrograms) / sizeof(vmBenchmarkPrograms[0]); i++) {
+        for (int superinstructions = 0; superinstructions <= 1; superinstructions++) {
+            SourceBuffer source;
+            VmStats stats;
+            double elapsed = 0.0;
+            int compiled = 0;
+
+            memset(&stats, 0, sizeof(VmStats));
+            if (!loadSourceString(vmBenchmarkPrograms[i], &source)) {
+                break;
+            }
+            initSemantic();
+            initParser();
+            initLexer(source.data, source.length);
+            parseProgram();
+            if (!hasError && buildControlFlowGraph()) {
+                propagateConditionalConstants();
+                compiled = generateBytecode(superinstructions);
+            }
+            for (int r = 0; compiled && r < repetitions; r++) {
+                double start = getCurrentSeconds();
+                executeProgram(&programCode, &stats);
+                elapsed += getCurrentSeconds() - start;
+            }
+            if (compiled) {
+                printf("%-12s %-20s %8.3f s  %6u instrucciones  %12llu ejecutadas  %7.2f ns por iteracion\n",
+                       vmBenchmarkNames[i], superinstructions ? "superinstrucciones" : "basicas",
+                       elapsed / repetitions, programCode.count, stats.instructions,
+                       elapsed / repetitions / vmBenchmarkIterations[i] * 1e9);
+            } else {
+                printf("%-12s [con errores]\n", vmBenchmarkNames[i]);
+            }
+            cleanup();
+            releaseSource(&source);
+        }
+    }
+    progressMessages = 1;
+}
+
+/**
+ * Compara la maquina virtual con el codigo nativo en los mismos programas
+ * de bucles (con superinstrucciones). Tambien verifica que las dos
+ * ejecuciones dejen las variables con los mismos valores.
+ */
+void benchmarkNativeCode() {
+    const int repetitions = 3;
+    progressMessages = 0;
+    for (size_t i = 0; i < sizeof(vmBenchmarkPrograms) / sizeof(vmBenchmarkPrograms[0]); i++) {
+        SourceBuffer source;
+        NativeProgram native;
+        VmStats vmStats, nativeStats;
+        double vmTime = 0.0, nativeTime = 0.0, translationTime = 0.0;
+        int compiled = 0;
+
+        memset(&vmStats, 0, sizeof(VmStats));
+        memset(&nativeStats, 0, sizeof(VmStats));
+        if (!loadSourceString(vmBenchmarkPrograms[i], &source)) {
+            break;
+        }
+        initSemantic();
+        initParser();
+        initLexer(source.data, source.length);
+        parseProgram();
+        if (!hasError && buildControlFlowGraph()) {
+            propagateConditionalConstants();
+            compiled = generateBytecode(1);
+        }
+        if (compiled) {
+            double start = getCurrentSeconds();
+            compiled = compileNativeProgram(&programCode, &native);
+            translationTime = getCurrentSeconds() - start;
+        }
+        for (int r = 0; compiled && r < repetitions; r++) {
+            double start = getCurrentSeconds();
+            executeProgram(&programCode, &vmStats);
+            vmTime += getCurrentSeconds() - start;
+
+            start = getCurrentSeconds();
+            executeNativeProgram(&native, &nativeStats);
+            nativeTime += getCurrentSeconds() - start;
+        }
+        if (compiled) {
+            printf("%-12s VM %8.3f s  nativo %8.3f s (%5zu bytes, %2u en registros, traduccion %6.1f us)"
+                   "  %5.1fx  [%s]\n",
+                   vmBenchmarkNames[i], vmTime / repetitions, nativeTime / repetitions, native.size,
+                   native.pinnedRegisters, translationTime * 1e6, vmTime / nativeTime,
+                   vmStats.checksum == nativeStats.checksum ? "coinciden" : "NO COINCIDEN");
+            releaseNativeProgram(&native);
+        } else {
+            printf("%-12s [sin codigo nativo]\n", vmBenchmarkNames[i]);
+        }
+        cleanup();
+        releaseSource(&source);
+    }
+    progressMessages = 1;
+}
+
+/**
+ * Busqueda de palabras reservadas con la cadena de strcmp original.
+ * Se conserva solo como referencia para comparar con lookupKeyword.
+ * @param word: Palabra a verificar
+ * @return: Tipo de token correspondiente o TOKEN_IDENTIFIER
+ */
+static int isKeywordStrcmpChain(const char* word) {
+    static const char* words[] = {"entero", "caracter", "real", "si", "sino", "mientras", "repetir",
+                                  "hasta", "leer", "escribir", "y", "o", "no"};
+    static const TokenType types[] = {TOKEN_ENTERO, TOKEN_CARACTER, TOKEN_REAL, TOKEN_SI, TOKEN_SINO,
+                                      TOKEN_MIENTRAS, TOKEN_REPETIR, TOKEN_HASTA, TOKEN_LEER,
+                                      TOKEN_ESCRIBIR, TOKEN_AND, TOKEN_OR, TOKEN_NOT};
+
+    for (int i = 0; i < 13; i++) {
+        if (strcmp(word, words[i]) == 0) return types[i];
+    }
+    return TOKEN_IDENTIFIER;
+}
+
+/**
+ * Mide la busqueda de palabras reservadas sobre una lista de palabras
+ * @param name: Nombre descriptivo de la lista
+ * @param words: Palabras a buscar
+ * @param wordCount: Cantidad de palabras
+ */
+static void benchmarkKeywordList(const char* name, const char** words, int wordCount) {
+    const int repetitions = 200000;
+    int lengths[32];
+    volatile long sink = 0;
+
+    for (int i = 0; i < wordCount; i++) lengths[i] = (int)strlen(words[i]);
+
+    double start = getCurrentSeconds();
+    for (int r = 0; r < repetitions; r++) {
+        for (int i = 0; i < wordCount; i++) sink += isKeywordStrcmpChain(words[i]);
+    }
+    double chainTime = getCurrentSeconds() - start;
+
+    start = getCurrentSeconds();
+    for (int r = 0; r < repetitions; r++) {
+        for (int i = 0; i < wordCount; i++) sink += lookupKeyword(words[i], lengths[i]);
+    }
+    double hashTime = getCurrentSeconds() - start;
+
+    double lookups = (double)repetitions * wordCount;
+    printf("%-22s strcmp: %8.2f Mbusq/s   hash perfecto: %8.2f Mbusq/s   (x%.1f)\n", name,
+           lookups / chainTime / 1e6, lookups / hashTime / 1e6, chainTime / hashTime);
+}
+
+/**
+ * Compara la busqueda de palabras reservadas con entradas dominadas por
+ * palabras reservadas y por identificadores
+ */
+void benchmarkKeywords() {
+    static const char* keywordHeavy[] = {
+        "si", "sino", "mientras", "entero", "real", "escribir", "leer", "y", "o", "hasta",
+        "repetir", "caracter", "no", "si", "contador", "mientras", "escribir", "x", "entero", "sino"
+    };
+    static const char* identifierHeavy[] = {
+        "contador", "limite", "suma", "promedio", "x", "i", "resultado", "v12", "letra", "total",
+        "indice", "acumulador", "si", "valor_maximo", "n", "temp", "mientras", "dato", "siguiente", "esc"
+    };
+
+    benchmarkKeywordList("palabras reservadas", keywordHeavy, 20);
+    benchmarkKeywordList("identificadores", identifierHeavy, 20);
+}
+
+/**
+ * Ejecuta todas las mediciones de rendimiento
+ * @param userSource: Codigo fuente del usuario (NULL para usar solo programas generados)
+ */
+void runBenchmarks(SourceBuffer* userSource) {
+    SourceBuffer generated, variables;
+    printf("=== MEDICION DE RENDIMIENTO ===\n");
+
+    if (!generateBenchmarkProgram(200000, 12345u, BENCH_STYLE_MIXED, &generated)) {
+        printf("ERROR: No se pudo generar el programa de prueba\n");
+        return;
+    }
+    printf("Programa generado: %lu bytes\n\n", (unsigned long)generated.length);
+
+    printf("--- Analizador lexico (sizeof(Token) = %lu bytes) ---\n", (unsigned long)sizeof(Token));
+    benchmarkLexer("generado", &generated, 5);
+    if (userSource != NULL) {
+        benchmarkLexer("archivo", userSource, 5);
+    }
+
+    printf("\n--- Analisis lexico por adelantado (%d procesadores) ---\n", detectProcessorCount());
+    benchmarkParallelLexer("generado", &generated);
+    if (userSource != NULL) {
+        benchmarkParallelLexer("archivo", userSource);
+    }
+
+    printf("\n--- Fases de la compilacion (%lu bytes por token en la secuencia) ---\n",
+           (unsigned long)(sizeof(unsigned char) + sizeof(size_t) + sizeof(int) + sizeof(TokenValue)));
+    benchmarkPhases("generado", &generated);
+    if (userSource != NULL) {
+        benchmarkPhases("archivo", userSource);
+    }
+    if (generateBenchmarkProgram(100000, 4242u, BENCH_STYLE_VARIABLES, &variables)) {
+        benchmarkPhases("20000 variables", &variables);
+        releaseSource(&variables);
+    }
+
+    printf("\n--- Memoria por compilacion ---\n");
+    benchmarkMemory("generado", &generated);
+    if (userSource != NULL) {
+        benchmarkMemory("archivo", userSource);
+    }
+    if (generateBenchmarkProgram(100000, 4242u, BENCH_STYLE_VARIABLES, &variables)) {
+        benchmarkMemory("20000 variables", &variables);
+        releaseSource(&variables);
+    }
+
+    printf("\n--- Ambitos de bloque ---\n");
+    benchmarkScopes(0, 12500);
+    benchmarkScopes(1, 1250);
+
+    printf("\n--- Grafo de flujo de control y propagacion de constantes ---\n");
+    benchmarkControlFlow(0, 25000);
+    benchmarkControlFlow(1, 2500);
+
+    printf("\n--- Variables inicializadas antes de cada uso ---\n");
+    benchmarkDefiniteAssignment();
+
+    printf("\n--- Maquina virtual (despacho: %s) ---\n", vmDispatchName());
+    benchmarkVirtualMachine();
+
+    printf("\n--- Codigo nativo x86-64 ---\n");
+    if (nativeCodeAvailable()) {
+        benchmarkNativeCode();
+    } else {
+        printf("No disponible en esta plataforma\n");
+    }
+
+    printf("\n--- Nucleos de busqueda (mejor nivel: %s) ---\n", scanKernelLevelName(detectScanKernelLevel()));
+    benchmarkScanKernels();
+
+    printf("\n--- Palabras reservadas ---\n");
+    benchmarkKeywords();
+
+    releaseSource(&generated);
+    freeInternTable(&identifierNames);
+    freeArena(&compilationArena);
+}
@@ -0,0 +1,1393 @@
+#include "compilador.h"
+
+/*
+ * Grafo de flujo de control y propagacion condicional de constantes (SCCP).
+ *
+ * El grafo se arma recorriendo las sentencias del arbol: cada si, mientras y
+ * repetir corta el bloque actual y agrega los bloques de sus ramas. Al mismo
+ * tiempo cada variable recibe una definicion SSA por asignacion, lectura o
+ * declaracion, y una definicion phi donde se unen dos caminos: despues de un
+ * si y al comienzo de cada bucle (para las variables que el bucle asigna).
+ *
+ * La propagacion recorre solo los caminos ejecutables: una rama se agrega
+ * cuando su condicion puede tomar ese valor. Cada nodo de expresion y cada
+ * definicion bajan en el reticulado desconocido -> constante -> variable a lo
+ * sumo dos veces y al bajar avisan solo a sus usuarios, asi el trabajo es
+ * lineal en el tamano del arbol mas la cantidad de definiciones phi. Al
+ * terminar se eliminan los bloques que nunca se ejecutan, los saltos con
+ * condicion constante pasan a ser incondicionales y los usos de variables
+ * con valor constante se reemplazan por ese valor.
+ */
+
+/* Grafo del programa actual */
+ControlFlowGraph programCfg = {NULL, 0, 0, NULL, 0, 0, 0};
+
+/* Niveles del reticulado de la propagacion */
+#define LATTICE_UNKNOWN 0      // Ningun camino ejecutable llego todavia
+#define LATTICE_CONSTANT 1     // Siempre el mismo valor
+#define LATTICE_VARYING 2      // Valor que no se conoce al compilar
+
+/* Clases de definiciones SSA */
+#define SSA_INPUT 0            // Valor desconocido: declaracion o lectura
+#define SSA_ASSIGN 1           // Asignacion (node = nodo de la asignacion)
+#define SSA_PHI 2              // Union de dos caminos al comienzo de un bloque
+
+/* Marcas de ejecucion de cada bloque */
+#define BLOCK_LIVE 0x01        // El bloque se ejecuta
+#define BLOCK_EDGE_TRUE 0x02   // El salto a next[0] se ejecuta
+#define BLOCK_EDGE_FALSE 0x04  // El salto a next[1] se ejecuta
+
+/* Definicion SSA de una variable */
+typedef struct {
+    unsigned char kind;            // SSA_*
+    unsigned char level;           // LATTICE_*
+    int symbol;                    // Posicion de la variable en symbolTable
+    unsigned int node;             // Nodo que la origina
+    unsigned int block;            // Bloque donde esta
+    int operands[2];               // Phi: definicion que llega por cada predecesor (-1 = ninguna)
+    unsigned int predecessors[2];  // Phi: bloque de cada operando
+    ConstantValue constant;        // Valor si level es LATTICE_CONSTANT
+    unsigned int firstUse;         // Usuarios en definitionUsers
+    unsigned int useCount;
+} SsaDefinition;
+
+/* Cambio de la definicion actual de una variable (para volver al estado
+   anterior a una rama) */
+typedef struct {
+    int symbol;
+    int previous;
+} DefinitionChange;
+
+/* Variable asignada en una rama de un si: definicion al final de cada rama */
+typedef struct {
+    int symbol;
+    int value[2];                  // -2 = la rama no la asigna
+} BranchDefinition;
+
+/* Variable exterior asignada dentro de un bucle */
+typedef struct {
+    unsigned int loop;             // Nodo del bucle
+    int symbol;
+} LoopVariable;
+
+/* Estado de cada bloque durante la propagacion */
+typedef struct {
+    unsigned int firstPhi;         // Las phi del bloque son definiciones consecutivas
+    unsigned int phiCount;
+    unsigned char marks;           // BLOCK_*
+} BlockState;
+
+/* Sentencia compuesta que se esta agregando al grafo: se sigue con ella
+   cada vez que termina una de sus partes */
+typedef struct {
+    unsigned int node;             // Nodo de la sentencia
+    unsigned int step;             // Partes ya comenzadas (si: ramas; bucles: cuerpo)
+    unsigned int child;            // Programa o bloque: proximo hijo (0 = no quedan)
+    unsigned int block;            // si: bloque de la condicion; bucles: bloque al que vuelve
+    unsigned int trueEnd;          // si: ultimo bloque de la rama verdadera
+    unsigned int mark;             // si: cambios anotados antes de las ramas
+    unsigned int firstEntry;       // si: primera anotacion en branchDefinitions
+    unsigned int serial;           // si: marca en symbolMark
+} BuildFrame;
+
+/* Arreglo que crece en la arena */
+typedef struct {
+    void* items;
+    unsigned int count;
+    unsigned int capacity;
+} CfgArray;
+
+static CfgArray definitions;       // SsaDefinition
+static CfgArray changes;           // DefinitionChange
+static CfgArray branchDefinitions; // BranchDefinition
+static CfgArray blockStates;       // BlockState
+static CfgArray buildFrames;       // BuildFrame (sentencias compuestas abiertas)
+static int* currentDefinition;     // Variable -> definicion visible (-1 = ninguna)
+static unsigned int* symbolMark;   // Variable -> ultima marca de recorrido
+static int* symbolEntry;           // Variable -> dato asociado a la marca
+static unsigned int markSerial;
+static unsigned int* loopVariableFirst; // Nodo de bucle -> primera variable en loopVariables
+static int* loopVariables;         // Variables que necesitan una phi en cada bucle
+static unsigned int* nodeParent;   // Nodo de expresion -> nodo que lo contiene
+static int* nodeLink;              // Variable/asignacion/lectura/declaracion -> definicion;
+                                   // si/mientras/repetir -> bloque de su condicion
+static unsigned char* nodeLevel;   // LATTICE_* de cada nodo de expresion
+static unsigned char* nodeMayFail; // 1 si la expresion puede detener el programa (division entera por cero)
+static ConstantValue* nodeConstant;
+static int* definitionUsers;       // >= 0 nodo VARIABLE, < 0 -(phi + 1)
+static int* definitionWork;        // Definiciones que bajaron y falta avisar
+static unsigned int definitionWorkCount;
+static unsigned int* edgeWork;     // Saltos que pasaron a ejecutarse (bloque * 2 + lado)
+static unsigned int edgeWorkCount;
+static int cfgOutOfMemory = 0;
+
+/**
+ * Obtiene una definicion SSA
+ * @param index: Numero de la definicion
+ * @return: Definicion
+ */
+static inline SsaDefinition* definitionAt(int index) {
+    return &((SsaDefinition*)definitions.items)[index];
+}
+
+/**
+ * Obtiene el estado de un bloque
+ * @param block: Numero del bloque
+ * @return: Estado del bloque
+ */
+static inline BlockState* blockState(unsigned int block) {
+    return &((BlockState*)blockStates.items)[block];
+}
+
+/**
+ * Reserva el lugar de un elemento mas en un arreglo de la construccion
+ * @param array: Arreglo
+ * @param itemSize: Tamano de cada elemento
+ * @return: Puntero al lugar libre, o NULL si no hubo memoria
+ */
+static void* pushCfgItem(CfgArray* array, size_t itemSize) {
+    if (array->count == array->capacity) {
+        unsigned int capacity = array->capacity ? array->capacity * 2 : 256;
+        void* grown = arenaResize(&compilationArena, array->items, (size_t)array->capacity * itemSize,
+                                  (size_t)capacity * itemSize);
+        if (grown == NULL) {
+            cfgOutOfMemory = 1;
+            return NULL;
+        }
+        array->items = grown;
+        array->capacity = capacity;
+    }
+    return (char*)array->items + (size_t)array->count++ * itemSize;
+}
+
+/**
+ * Reserva un arreglo de la arena con todos sus bytes en el valor dado
+ * @param count: Cantidad de elementos
+ * @param itemSize: Tamano de cada elemento
+ * @param fill: Byte de relleno
+ * @return: Arreglo, o NULL si no hubo memoria
+ */
+static void* allocCfgTable(size_t count, size_t itemSize, int fill) {
+    void* table = arenaAlloc(&compilationArena, count * itemSize);
+    if (table == NULL) {
+        cfgOutOfMemory = 1;
+        return NULL;
+    }
+    memset(table, fill, count * itemSize);
+    return table;
+}
+
+/**
+ * Deja el grafo vacio (su memoria vuelve con la arena de la compilacion)
+ */
+void initControlFlowGraph() {
+    memset(&programCfg, 0, sizeof(ControlFlowGraph));
+}
+
+/**
+ * Indica si un nodo pertenece a una expresion
+ * @param kind: Clase del nodo
+ * @return: 1 si es una operacion, una variable o un literal
+ */
+static int isExpressionKind(AstKind kind) {
+    return kind == AST_BINARY || kind == AST_NOT || kind == AST_VARIABLE ||
+           kind == AST_INT_LITERAL || kind == AST_REAL_LITERAL || kind == AST_CHAR_LITERAL;
+}
+
+/**
+ * Calcula el final de un subarbol: los nodos estan en preorden, asi que el
+ * subarbol ocupa las posiciones desde su raiz hasta antes del valor devuelto
+ * @param root: Raiz del subarbol
+ * @return: Posicion siguiente al ultimo nodo del subarbol
+ */
+static unsigned int subtreeEnd(unsigned int root) {
+    unsigned int pending = 1, index = root;
+    while (pending > 0) {
+        pending += programAst.nodes[index].childCount;
+        pending--;
+        index++;
+    }
+    return index;
+}
+
+/* ========== CONSTRUCCION ========== */
+
+/**
+ * Agrega un bloque vacio al final del grafo; pasa a ser el bloque actual
+ * @param origin: Nodo que lo origina (0 si lo define su primera sentencia)
+ * @return: Numero del bloque, o -1 si no hubo memoria
+ */
+static int newBlock(unsigned int origin) {
+    if (programCfg.blockCount == programCfg.blockCapacity) {
+        unsigned int capacity = programCfg.blockCapacity ? programCfg.blockCapacity * 2 : 64;
+        BasicBlock* grown = (BasicBlock*)arenaResize(&compilationArena, programCfg.blocks,
+                                                     (size_t)programCfg.blockCapacity * sizeof(BasicBlock),
+                                                     (size_t)capacity * sizeof(BasicBlock));
+        if (grown == NULL) {
+            cfgOutOfMemory = 1;
+            return -1;
+        }
+        programCfg.blocks = grown;
+        programCfg.blockCapacity = capacity;
+    }
+    BlockState* state = (BlockState*)pushCfgItem(&blockStates, sizeof(BlockState));
+    if (state == NULL) {
+        return -1;
+    }
+    state->firstPhi = definitions.count;
+    state->phiCount = 0;
+    state->marks = 0;
+
+    BasicBlock* block = &programCfg.blocks[programCfg.blockCount];
+    block->firstStatement = programCfg.statementCount;
+    block->statementCount = 0;
+    block->condition = 0;
+    block->next[0] = block->next[1] = -1;
+    block->origin = origin;
+    return (int)programCfg.blockCount++;
+}
+
+/**
+ * Obtiene el bloque actual (el ultimo agregado: las sentencias siempre se
+ * agregan al ultimo bloque, asi cada bloque ocupa un tramo de statements)
+ * @return: Numero del bloque actual
+ */
+static unsigned int currentBlock() {
+    return programCfg.blockCount - 1;
+}
+
+/**
+ * Agrega una sentencia simple al bloque actual
+ * @param node: Nodo de la sentencia
+ */
+static void appendStatement(unsigned int node) {
+    if (programCfg.statementCount == programCfg.statementCapacity) {
+        unsigned int capacity = programCfg.statementCapacity ? programCfg.statementCapacity * 2 : 256;
+        unsigned int* grown = (unsigned int*)arenaResize(&compilationArena, programCfg.statements,
+                                                         (size_t)programCfg.statementCapacity * sizeof(unsigned int),
+                                                         (size_t)capacity * sizeof(unsigned int));
+        if (grown == NULL) {
+            cfgOutOfMemory = 1;
+            return;
+        }
+        programCfg.statements = grown;
+        programCfg.statementCapacity = capacity;
+    }
+    BasicBlock* block = &programCfg.blocks[currentBlock()];
+    if (block->statementCount == 0 && block->origin == 0) {
+        block->origin = node;
+    }
+    programCfg.statements[programCfg.statementCount++] = node;
+    block->statementCount++;
+}
+
+/**
+ * Agrega una definicion SSA en el bloque actual
+ * @param kind: SSA_*
+ * @param symbol: Variable definida
+ * @param node: Nodo que la origina
+ * @return: Numero de la definicion, o -1 si no hubo memoria
+ */
+static int newDefinition(int kind, int symbol, unsigned int node) {
+    SsaDefinition* definition = (SsaDefinition*)pushCfgItem(&definitions, sizeof(SsaDefinition));
+    if (definition == NULL) {
+        return -1;
+    }
+    memset(definition, 0, sizeof(SsaDefinition));
+    definition->kind = (unsigned char)kind;
+    definition->symbol = symbol;
+    definition->node = node;
+    definition->block = currentBlock();
+    definition->operands[0] = definition->operands[1] = -1;
+    return (int)definitions.count - 1;
+}
+
+/**
+ * Cambia la definicion visible de una variable y anota el cambio
+ * @param symbol: Variable
+ * @param definition: Definicion nueva
+ */
+static void defineVariable(int symbol, int definition) {
+    DefinitionChange* change = (DefinitionChange*)pushCfgItem(&changes, sizeof(DefinitionChange));
+    if (change != NULL) {
+        change->symbol = symbol;
+        change->previous = currentDefinition[symbol];
+    }
+    currentDefinition[symbol] = definition;
+}
+
+/**
+ * Agrega una sentencia que define una variable (declaracion, asignacion o lectura)
+ * @param node: Nodo de la sentencia
+ * @param kind: SSA_INPUT o SSA_ASSIGN
+ */
+static void addDefinitionStatement(unsigned int node, int kind) {
+    int symbol = programAst.nodes[node].value.intValue;
+    appendStatement(node);
+    if (symbol < 0) {
+        return;
+    }
+    int definition = newDefinition(kind, symbol, node);
+    nodeLink[node] = definition;
+    if (definition >= 0) {
+        defineVariable(symbol, definition);
+    }
+}
+
+/**
+ * Enlaza una expresion: cada nodo conoce a su padre y cada uso de variable
+ * a la definicion visible en este punto
+ * @param root: Raiz de la expresion
+ * @param owner: Sentencia que la contiene
+ */
+static void bindExpression(unsigned int root, unsigned int owner) {
+    unsigned int pending = 1, index = root;
+    nodeParent[root] = owner;
+    while (pending > 0) {
+        const AstNode* node = &programAst.nodes[index];
+        if (node->kind == AST_VARIABLE && node->value.intValue >= 0) {
+            int definition = currentDefinition[node->value.intValue];
+            nodeLink[index] = definition;
+            if (definition >= 0) {
+                definitionAt(definition)->useCount++;
+            }
+        }
+        if (node->childCount > 0) {
+            for (unsigned int child = index + 1; child != 0; child = programAst.nodes[child].nextSibling) {
+                nodeParent[child] = index;
+            }
+        }
+        pending += node->childCount;
+        pending--;
+        index++;
+    }
+}
+
+/**
+ * Anota las definiciones visibles al final de una rama de un si y vuelve
+ * al estado anterior a la rama
+ * @param mark: Cambios anotados antes de la rama
+ * @param side: 0 para la rama verdadera, 1 para la falsa
+ * @param firstEntry: Primera anotacion de este si en branchDefinitions
+ * @param serial: Marca de este si en symbolMark
+ */
+static void collectBranch(unsigned int mark, int side, unsigned int firstEntry, unsigned int serial) {
+    BranchDefinition* entries;
+
+    // Un si anidado en la rama pudo pisar las marcas de la rama anterior
+    if (side == 1) {
+        entries = (BranchDefinition*)branchDefinitions.items;
+        for (unsigned int i = firstEntry; i < branchDefinitions.count; i++) {
+            symbolMark[entries[i].symbol] = serial;
+            symbolEntry[entries[i].symbol] = (int)i;
+        }
+    }
+
+    // De atras hacia adelante: la primera vez que aparece una variable tiene su valor final
+    for (unsigned int k = changes.count; k-- > mark;) {
+        DefinitionChange* change = &((DefinitionChange*)changes.items)[k];
+        int symbol = change->symbol;
+        if (symbolMark[symbol] != serial) {
+            BranchDefinition* entry = (BranchDefinition*)pushCfgItem(&branchDefinitions, sizeof(BranchDefinition));
+            if (entry == NULL) {
+                return;
+            }
+            entry->symbol = symbol;
+            entry->value[0] = entry->value[1] = -2;
+            symbolMark[symbol] = serial;
+            symbolEntry[symbol] = (int)branchDefinitions.count - 1;
+        }
+        BranchDefinition* entry = &((BranchDefinition*)branchDefinitions.items)[symbolEntry[symbol]];
+        if (entry->value[side] == -2) {
+            entry->value[side] = currentDefinition[symbol];
+        }
+        currentDefinition[symbol] = change->previous;
+    }
+    changes.count = mark;
+}
+
+/**
+ * Crea las phi del bloque que une las dos ramas de un si
+ * @param firstEntry: Primera anotacion de este si en branchDefinitions
+ * @param node: Nodo del si
+ * @param trueEnd: Ultimo bloque de la rama verdadera
+ * @param falseEnd: Ultimo bloque de la rama falsa (o el de la condicion)
+ */
+static void createJoinPhis(unsigned int firstEntry, unsigned int node, unsigned int trueEnd, unsigned int falseEnd) {
+    unsigned int join = currentBlock();
+    for (unsigned int i = firstEntry; i < branchDefinitions.count && !cfgOutOfMemory; i++) {
+        BranchDefinition entry = ((BranchDefinition*)branchDefinitions.items)[i];
+        int before = currentDefinition[entry.symbol];
+        int trueValue = entry.value[0] == -2 ? before : entry.value[0];
+        int falseValue = entry.value[1] == -2 ? before : entry.value[1];
+        if (trueValue == falseValue) {
+            continue;
+        }
+        int phi = newDefinition(SSA_PHI, entry.symbol, node);
+        if (phi < 0) {
+            break;
+        }
+        SsaDefinition* definition = definitionAt(phi);
+        definition->operands[0] = trueValue;
+        definition->operands[1] = falseValue;
+        definition->predecessors[0] = trueEnd;
+        definition->predecessors[1] = falseEnd;
+        blockState(join)->phiCount++;
+        defineVariable(entry.symbol, phi);
+    }
+    branchDefinitions.count = firstEntry;
+}
+
+/**
+ * Anota para cada bucle las variables exteriores que asigna o lee (cada una
+ * necesita una phi al comienzo del bucle). Se recorre el arbol una sola vez
+ * con la pila de bucles abiertos: una asignacion agrega su variable a los
+ * bucles que la contienen, desde el mas interno hasta el primero que ya la
+ * tiene o hasta el bucle donde se declaro. Si un bucle tiene la variable,
+ * tambien la tienen los que lo contienen, asi que cada paso agrega una phi.
+ * @return: 1 si se armo, 0 si no hubo memoria
+ */
+static int collectLoopVariables() {
+    unsigned int count = programAst.count;
+    unsigned int* subtreeSize = (unsigned int*)allocCfgTable(count, sizeof(unsigned int), 0);
+    unsigned int* loopStack = (unsigned int*)allocCfgTable((size_t)count + 1, sizeof(unsigned int), 0);
+    unsigned int* loopEnd = (unsigned int*)allocCfgTable((size_t)count + 1, sizeof(unsigned int), 0);
+    unsigned int* declaredDepth = (unsigned int*)allocCfgTable(symbolTable.count + 1, sizeof(unsigned int), 0);
+    unsigned int* lastLoop = (unsigned int*)allocCfgTable(symbolTable.count + 1, sizeof(unsigned int), 0xFF);
+    CfgArray pairs = {NULL, 0, 0};
+    unsigned int depth = 0;
+
+    loopVariableFirst = (unsigned int*)allocCfgTable((size_t)count + 1, sizeof(unsigned int), 0);
+    if (cfgOutOfMemory) {
+        return 0;
+    }
+
+    // Tamano de cada subarbol: en preorden inverso los hijos ya estan calculados
+    for (unsigned int index = count; index-- > 0;) {
+        subtreeSize[index] = 1;
+        if (programAst.nodes[index].childCount > 0) {
+            for (unsigned int child = index + 1; child != 0; child = programAst.nodes[child].nextSibling) {
+                subtreeSize[index] += subtreeSize[child];
+            }
+        }
+    }
+
+    for (unsigned int index = 0; index < count; index++) {
+        const AstNode* node = &programAst.nodes[index];
+        int symbol = node->value.intValue;
+        while (depth > 0 && index >= loopEnd[depth]) {
+            depth--;
+        }
+        if (node->kind == AST_WHILE || node->kind == AST_REPEAT) {
+            depth++;
+            loopStack[depth] = index;
+            loopEnd[depth] = index + subtreeSize[index];
+        } else if (node->kind == AST_DECLARATION && symbol >= 0) {
+            declaredDepth[symbol] = depth;
+        } else if ((node->kind == AST_ASSIGN || node->kind == AST_READ) && symbol >= 0 &&
+                   depth > declaredDepth[symbol]) {
+            // El ultimo bucle que recibio la variable sigue abierto si algun
+            // bucle de la pila lo contiene; desde ahi hacia afuera ya la tienen
+            unsigned int last = lastLoop[symbol];
+            for (unsigned int level = depth; level > declaredDepth[symbol]; level--) {
+                if (last >= loopStack[level] && last < loopEnd[level]) {
+                    break;
+                }
+                LoopVariable* pair = (LoopVariable*)pushCfgItem(&pairs, sizeof(LoopVariable));
+                if (pair == NULL) {
+                    return 0;
+                }
+                pair->loop = loopStack[level];
+                pair->symbol = symbol;
+                loopVariableFirst[loopStack[level] + 1]++;
+            }
+            lastLoop[symbol] = loopStack[depth];
+        }
+    }
+
+    // Agrupa las variables por bucle (los bucles quedan en orden de nodo)
+    for (unsigned int index = 0; index < count; index++) {
+        loopVariableFirst[index + 1] += loopVariableFirst[index];
+    }
+    loopVariables = (int*)allocCfgTable(pairs.count ? pairs.count : 1, sizeof(int), 0);
+    if (loopVariables == NULL) {
+        return 0;
+    }
+    for (unsigned int i = 0; i < pairs.count; i++) {
+        subtreeSize[((LoopVariable*)pairs.items)[i].loop] = 0;    // Ya no hace falta: cuenta las ubicadas
+    }
+    for (unsigned int i = 0; i < pairs.count; i++) {
+        LoopVariable pair = ((LoopVariable*)pairs.items)[i];
+        loopVariables[loopVariableFirst[pair.loop] + subtreeSize[pair.loop]++] = pair.symbol;
+    }
+    return 1;
+}
+
+/**
+ * Crea al comienzo de un bucle una phi por cada variable exterior que el
+ * bucle asigna (anotadas por collectLoopVariables)
+ * @param node: Nodo del bucle
+ * @param header: Bloque al que vuelve el bucle
+ * @param entry: Bloque anterior al bucle
+ */
+static void createLoopPhis(unsigned int node, unsigned int header, unsigned int entry) {
+    for (unsigned int i = loopVariableFirst[node]; i < loopVariableFirst[node + 1]; i++) {
+        int symbol = loopVariables[i];
+        int phi = newDefinition(SSA_PHI, symbol, node);
+        if (phi < 0) {
+            break;
+        }
+        definitionAt(phi)->operands[0] = currentDefinition[symbol];
+        definitionAt(phi)->predecessors[0] = entry;
+        blockState(header)->phiCount++;
+        defineVariable(symbol, phi);
+    }
+}
+
+/**
+ * Completa las phi de un bucle con las definiciones que vuelven al comienzo
+ * @param header: Bloque al que vuelve el bucle
+ * @param latch: Bloque que salta al comienzo
+ * @param restore: 1 para que despues del bucle se vean las phi (mientras:
+ *                 se sale desde el comienzo), 0 para dejar las del final (repetir)
+ */
+static void closeLoopPhis(unsigned int header, unsigned int latch, int restore) {
+    BlockState* state = blockState(header);
+    for (unsigned int i = 0; i < state->phiCount; i++) {
+        int phi = (int)(state->firstPhi + i);
+        SsaDefinition* definition = definitionAt(phi);
+        definition->operands[1] = currentDefinition[definition->symbol];
+        definition->predecessors[1] = latch;
+        if (restore) {
+            currentDefinition[definition->symbol] = phi;
+        }
+    }
+}
+
+/**
+ * Abre una sentencia compuesta en la pila de construccion
+ * @param node: Nodo de la sentencia
+ * @return: Lugar de la sentencia en la pila, o NULL si no hubo memoria
+ */
+static BuildFrame* pushBuildFrame(unsigned int node) {
+    BuildFrame* frame = (BuildFrame*)pushCfgItem(&buildFrames, sizeof(BuildFrame));
+    if (frame != NULL) {
+        memset(frame, 0, sizeof(BuildFrame));
+        frame->node = node;
+    }
+    return frame;
+}
+
+/**
+ * Comienza a agregar al grafo una sentencia si: la condicion y el primer
+ * bloque de la rama verdadera
+ * @param node: Nodo del si (condicion, bloque verdadero [, bloque falso])
+ */
+static void beginIfStatement(unsigned int node) {
+    unsigned int condition = node + 1;
+    unsigned int trueBody = programAst.nodes[condition].nextSibling;
+    unsigned int branch = currentBlock();
+    BuildFrame* frame = pushBuildFrame(node);
+    if (frame == NULL) return;
+    frame->block = branch;
+    frame->mark = changes.count;
+    frame->firstEntry = branchDefinitions.count;
+    frame->serial = ++markSerial;
+
+    bindExpression(condition, node);
+    programCfg.blocks[branch].condition = condition;
+    if (programCfg.blocks[branch].origin == 0) {
+        programCfg.blocks[branch].origin = node;
+    }
+    nodeLink[node] = (int)branch;
+
+    int trueStart = newBlock(trueBody);
+    if (trueStart < 0) return;
+    programCfg.blocks[branch].next[0] = trueStart;
+}
+
+/**
+ * Sigue con una sentencia si despues de cada una de sus ramas; despues de
+ * la ultima crea el bloque que las une y la quita de la pila
+ * @param frame: Sentencia en el tope de la pila
+ * @return: Rama que hay que agregar ahora, o 0 si la sentencia termino
+ */
+static unsigned int continueIfStatement(BuildFrame* frame) {
+    unsigned int node = frame->node;
+    unsigned int trueBody = programAst.nodes[node + 1].nextSibling;
+    unsigned int falseBody = programAst.nodes[node].childCount > 2 ? programAst.nodes[trueBody].nextSibling : 0;
+    unsigned int falseEnd = frame->block;
+
+    if (frame->step == 0) {
+        frame->step = 1;
+        return trueBody;
+    }
+    if (frame->step == 1) {
+        frame->trueEnd = currentBlock();
+        collectBranch(frame->mark, 0, frame->firstEntry, frame->serial);
+        if (falseBody != 0) {
+            int falseStart = newBlock(falseBody);
+            if (falseStart < 0) return 0;
+            programCfg.blocks[frame->block].next[1] = falseStart;
+            frame->step = 2;
+            return falseBody;
+        }
+    } else {
+        falseEnd = currentBlock();
+        collectBranch(frame->mark, 1, frame->firstEntry, frame->serial);
+    }
+
+    unsigned int trueEnd = frame->trueEnd, firstEntry = frame->firstEntry;
+    buildFrames.count--;
+    int join = newBlock(0);
+    if (join < 0) return 0;
+    programCfg.blocks[trueEnd].next[0] = join;
+    programCfg.blocks[falseEnd].next[falseBody != 0 ? 0 : 1] = join;
+    createJoinPhis(firstEntry, node, trueEnd, falseEnd);
+    return 0;
+}
+
+/**
+ * Comienza a agregar al grafo un bucle mientras: un bloque con la condicion
+ * al que vuelve el cuerpo, y el primer bloque del cuerpo
+ * @param node: Nodo del bucle (condicion, cuerpo)
+ */
+static void beginWhileStatement(unsigned int node) {
+    unsigned int condition = node + 1;
+    unsigned int body = programAst.nodes[condition].nextSibling;
+    unsigned int entry = currentBlock();
+
+    int header = newBlock(node);
+    if (header < 0) return;
+    programCfg.blocks[entry].next[0] = header;
+    createLoopPhis(node, (unsigned int)header, entry);
+    bindExpression(condition, node);
+    programCfg.blocks[header].condition = condition;
+    nodeLink[node] = header;
+
+    int bodyStart = newBlock(body);
+    if (bodyStart < 0) return;
+    programCfg.blocks[header].next[0] = bodyStart;
+    BuildFrame* frame = pushBuildFrame(node);
+    if (frame != NULL) {
+        frame->block = (unsigned int)header;
+    }
+}
+
+/**
+ * Sigue con un bucle mientras: primero el cuerpo, despues el salto de vuelta
+ * a la condicion y la salida desde ella
+ * @param frame: Sentencia en el tope de la pila
+ * @return: Cuerpo que hay que agregar ahora, o 0 si el bucle termino
+ */
+static unsigned int continueWhileStatement(BuildFrame* frame) {
+    if (frame->step == 0) {
+        frame->step = 1;
+        return programAst.nodes[frame->node + 1].nextSibling;
+    }
+
+    unsigned int header = frame->block;
+    buildFrames.count--;
+    unsigned int latch = currentBlock();
+    programCfg.blocks[latch].next[0] = header;
+    closeLoopPhis(header, latch, 1);
+
+    int exit = newBlock(0);
+    if (exit < 0) return 0;
+    programCfg.blocks[header].next[1] = exit;
+    return 0;
+}
+
+/**
+ * Comienza a agregar al grafo un bucle repetir: el primer bloque del cuerpo,
+ * al que se vuelve mientras la condicion sea falsa
+ * @param node: Nodo del bucle (cuerpo, condicion)
+ */
+static void beginRepeatStatement(unsigned int node) {
+    unsigned int body = node + 1;
+    unsigned int entry = currentBlock();
+
+    int start = newBlock(body);
+    if (start < 0) return;
+    programCfg.blocks[entry].next[0] = start;
+    createLoopPhis(node, (unsigned int)start, entry);
+    BuildFrame* frame = pushBuildFrame(node);
+    if (frame != NULL) {
+        frame->block = (unsigned int)start;
+    }
+}
+
+/**
+ * Sigue con un bucle repetir: primero el cuerpo, despues la condicion final,
+ * que sale si es verdadera y vuelve al comienzo si es falsa
+ * @param frame: Sentencia en el tope de la pila
+ * @return: Cuerpo que hay que agregar ahora, o 0 si el bucle termino
+ */
+static unsigned int continueRepeatStatement(BuildFrame* frame) {
+    unsigned int node = frame->node;
+    if (frame->step == 0) {
+        frame->step = 1;
+        return node + 1;
+    }
+
+    unsigned int start = frame->block;
+    unsigned int condition = programAst.nodes[node + 1].nextSibling;
+    buildFrames.count--;
+    unsigned int end = currentBlock();
+    bindExpression(condition, node);
+    programCfg.blocks[end].condition = condition;
+    if (programCfg.blocks[end].origin == 0) {
+        programCfg.blocks[end].origin = condition;
+    }
+    nodeLink[node] = (int)end;
+    closeLoopPhis(start, end, 0);
+
+    int exit = newBlock(0);
+    if (exit < 0) return 0;
+    programCfg.blocks[end].next[0] = exit;
+    programCfg.blocks[end].next[1] = start;
+    return 0;
+}
+
+/**
+ * Agrega al grafo una sentencia simple, o abre una compuesta en la pila de
+ * construccion para seguir con sus partes
+ * @param node: Nodo de la sentencia
+ */
+static void beginStatement(unsigned int node) {
+    const AstNode* statement = &programAst.nodes[node];
+    switch (statement->kind) {
+        case AST_PROGRAM:
+        case AST_BLOCK:
+            if (statement->childCount > 0) {
+                BuildFrame* frame = pushBuildFrame(node);
+                if (frame != NULL) {
+                    frame->child = node + 1;
+                }
+            }
+            break;
+        case AST_DECLARATION:
+        case AST_READ:
+            addDefinitionStatement(node, SSA_INPUT);
+            break;
+        case AST_ASSIGN:
+            bindExpression(node + 1, node);
+            addDefinitionStatement(node, SSA_ASSIGN);
+            break;
+        case AST_WRITE:
+            bindExpression(node + 1, node);
+            appendStatement(node);
+            break;
+        case AST_IF:
+            beginIfStatement(node);
+            break;
+        case AST_WHILE:
+            beginWhileStatement(node);
+            break;
+        case AST_REPEAT:
+            beginRepeatStatement(node);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Sigue con la sentencia compuesta del tope de la pila de construccion
+ * @param frame: Sentencia en el tope de la pila
+ * @return: Sentencia que hay que agregar ahora, o 0 si no queda ninguna
+ *          (la del tope termino y salio de la pila)
+ */
+static unsigned int continueStatement(BuildFrame* frame) {
+    switch (programAst.nodes[frame->node].kind) {
+        case AST_IF:
+            return continueIfStatement(frame);
+        case AST_WHILE:
+            return continueWhileStatement(frame);
+        case AST_REPEAT:
+            return continueRepeatStatement(frame);
+        default: {
+            unsigned int child = frame->child;
+            if (child == 0) {
+                buildFrames.count--;
+            } else {
+                frame->child = programAst.nodes[child].nextSibling;
+            }
+            return child;
+        }
+    }
+}
+
+/**
+ * Agrega al grafo el programa completo. Las sentencias compuestas abiertas
+ * se guardan en buildFrames y no en la pila de C, asi el anidamiento de
+ * bloques no tiene otro limite que la memoria.
+ * @param root: Nodo del programa
+ */
+static void buildStatements(unsigned int root) {
+    beginStatement(root);
+    while (!cfgOutOfMemory && buildFrames.count > 0) {
+        BuildFrame* frame = &((BuildFrame*)buildFrames.items)[buildFrames.count - 1];
+        unsigned int next = continueStatement(frame);
+        if (next != 0) {
+            beginStatement(next);
+        }
+    }
+}
+
+/**
+ * Arma la lista de usuarios de cada definicion: los usos de variable que la
+ * leen y las phi que la reciben
+ * @return: 1 si se armo, 0 si no hubo memoria
+ */
+static int linkDefinitionUsers() {
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < definitions.count; i++) {
+        SsaDefinition* definition = definitionAt((int)i);
+        if (definition->kind == SSA_PHI) {
+            for (int side = 0; side < 2; side++) {
+                if (definition->operands[side] >= 0) {
+                    definitionAt(definition->operands[side])->useCount++;
+                }
+            }
+        }
+    }
+    for (unsigned int i = 0; i < definitions.count; i++) {
+        SsaDefinition* definition = definitionAt((int)i);
+        definition->firstUse = total;
+        total += definition->useCount;
+        definition->useCount = 0;
+    }
+
+    definitionUsers = (int*)allocCfgTable(total ? total : 1, sizeof(int), 0);
+    if (definitionUsers == NULL) {
+        return 0;
+    }
+    for (unsigned int node = 0; node < programAst.count; node++) {
+        if (programAst.nodes[node].kind == AST_VARIABLE && nodeLink[node] >= 0) {
+            SsaDefinition* definition = definitionAt(nodeLink[node]);
+            definitionUsers[definition->firstUse + definition->useCount++] = (int)node;
+        }
+    }
+    for (unsigned int i = 0; i < definitions.count; i++) {
+        SsaDefinition* phi = definitionAt((int)i);
+        if (phi->kind == SSA_PHI) {
+            for (int side = 0; side < 2; side++) {
+                if (phi->operands[side] >= 0) {
+                    SsaDefinition* definition = definitionAt(phi->operands[side]);
+                    definitionUsers[definition->firstUse + definition->useCount++] = -(int)i - 1;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * Arma el grafo de flujo de control del programa (programAst sin errores)
+ * y la forma SSA que usa la propagacion
+ * @return: 1 si se armo, 0 si no hubo memoria
+ */
+int buildControlFlowGraph() {
+    size_t symbolCount = symbolTable.count > 0 ? (size_t)symbolTable.count : 1;
+    size_t nodeCount = programAst.count > 0 ? programAst.count : 1;
+
+    initControlFlowGraph();
+    memset(&definitions, 0, sizeof(CfgArray));
+    memset(&changes, 0, sizeof(CfgArray));
+    memset(&branchDefinitions, 0, sizeof(CfgArray));
+    memset(&blockStates, 0, sizeof(CfgArray));
+    memset(&buildFrames, 0, sizeof(CfgArray));
+    markSerial = 0;
+    cfgOutOfMemory = 0;
+
+    currentDefinition = (int*)allocCfgTable(symbolCount, sizeof(int), 0xFF);
+    symbolMark = (unsigned int*)allocCfgTable(symbolCount, sizeof(unsigned int), 0);
+    symbolEntry = (int*)allocCfgTable(symbolCount, sizeof(int), 0);
+    nodeParent = (unsigned int*)allocCfgTable(nodeCount, sizeof(unsigned int), 0);
+    nodeLink = (int*)allocCfgTable(nodeCount, sizeof(int), 0xFF);
+    if (!cfgOutOfMemory && programAst.count > 0 && collectLoopVariables() && newBlock(0) >= 0) {
+        buildStatements(0);
+    }
+    if (cfgOutOfMemory || !linkDefinitionUsers()) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el grafo de flujo de control\n");
+        initControlFlowGraph();
+        return 0;
+    }
+    return 1;
+}
+
+/* ========== PROPAGACION ========== */
+
+/**
+ * Baja una definicion en el reticulado y la anota para avisar a sus usuarios
+ * @param index: Definicion
+ * @param level: Nivel nuevo
+ * @param constant: Valor si level es LATTICE_CONSTANT
+ */
+static void lowerDefinition(int index, int level, const ConstantValue* constant) {
+    SsaDefinition* definition = definitionAt(index);
+    if (level == LATTICE_CONSTANT && definition->level == LATTICE_CONSTANT &&
+        !sameConstant(&definition->constant, constant)) {
+        level = LATTICE_VARYING;
+    }
+    if (level <= definition->level) {
+        return;
+    }
+    definition->level = (unsigned char)level;
+    if (level == LATTICE_CONSTANT) {
+        definition->constant = *constant;
+    }
+    definitionWork[definitionWorkCount++] = index;
+}
+
+/**
+ * Marca un salto como ejecutable y lo anota para procesar su destino
+ * @param block: Bloque de origen
+ * @param side: 0 para next[0], 1 para next[1]
+ */
+static void followEdge(unsigned int block, int side) {
+    unsigned char mark = side == 0 ? BLOCK_EDGE_TRUE : BLOCK_EDGE_FALSE;
+    BlockState* state = blockState(block);
+    if (programCfg.blocks[block].next[side] < 0 || (state->marks & mark)) {
+        return;
+    }
+    state->marks |= mark;
+    edgeWork[edgeWorkCount++] = block * 2 + (unsigned int)side;
+}
+
+/**
+ * Indica si el salto de un bloque a otro se ejecuta
+ * @param from: Bloque de origen
+ * @param to: Bloque de destino
+ * @return: 1 si algun salto ejecutable une los bloques
+ */
+static int isEdgeLive(unsigned int from, unsigned int to) {
+    const BasicBlock* block = &programCfg.blocks[from];
+    unsigned char marks = blockState(from)->marks;
+    return (block->next[0] == (int)to && (marks & BLOCK_EDGE_TRUE)) ||
+           (block->next[1] == (int)to && (marks & BLOCK_EDGE_FALSE));
+}
+
+/**
+ * Calcula una phi con los operandos que llegan por saltos ejecutables
+ * @param index: Definicion phi
+ */
+static void evaluatePhi(int index) {
+    SsaDefinition* phi = definitionAt(index);
+    int level = LATTICE_UNKNOWN;
+    ConstantValue constant;
+    memset(&constant, 0, sizeof(ConstantValue));
+
+    for (int side = 0; side < 2 && level != LATTICE_VARYING; side++) {
+        if (!isEdgeLive(phi->predecessors[side], phi->block)) {
+            continue;
+        }
+        if (phi->operands[side] < 0) {
+            level = LATTICE_VARYING;
+            continue;
+        }
+        SsaDefinition* operand = definitionAt(phi->operands[side]);
+        if (operand->level == LATTICE_VARYING ||
+            (operand->level == LATTICE_CONSTANT && level == LATTICE_CONSTANT &&
+             !sameConstant(&constant, &operand->constant))) {
+            level = LATTICE_VARYING;
+        } else if (operand->level == LATTICE_CONSTANT) {
+            level = LATTICE_CONSTANT;
+            constant = operand->constant;
+        }
+    }
+    lowerDefinition(index, level, &constant);
+}
+
+/**
+ * Calcula el nivel de un nodo de expresion a partir de sus hijos
+ * @param index: Nodo
+ * @return: 1 si el nodo bajo en el reticulado, 0 si no cambio
+ */
+static int evaluateNode(unsigned int index) {
+    const AstNode* node = &programAst.nodes[index];
+    int level = LATTICE_VARYING;
+    unsigned char mayFail = nodeMayFail[index];    // Solo puede pasar de 0 a 1
+    ConstantValue constant, left, right;
+    memset(&constant, 0, sizeof(ConstantValue));
+
+    if (node->kind == AST_INT_LITERAL || node->kind == AST_REAL_LITERAL || node->kind == AST_CHAR_LITERAL) {
+        level = LATTICE_CONSTANT;
+        constant.type = (DataType)node->dataType;
+        constant.value = node->value;
+    } else if (node->kind == AST_VARIABLE) {
+        if (nodeLink[index] >= 0) {
+            SsaDefinition* definition = definitionAt(nodeLink[index]);
+            level = definition->level;
+            constant = definition->constant;
+        }
+    } else if (node->kind == AST_NOT) {
+        level = nodeLevel[index + 1];
+        mayFail |= nodeMayFail[index + 1];
+        constant.type = TYPE_LOGICO;
+        constant.value.intValue = !nodeConstant[index + 1].value.intValue;
+    } else if (node->kind == AST_BINARY) {
+        unsigned int a = index + 1, b = programAst.nodes[a].nextSibling;
+        int leftLevel = nodeLevel[a], rightLevel = nodeLevel[b];
+        left = nodeConstant[a];
+        right = nodeConstant[b];
+        mayFail |= nodeMayFail[a] | nodeMayFail[b];
+        if ((node->op == TOKEN_DIVIDE || node->op == TOKEN_MOD) && node->dataType == TYPE_ENTERO &&
+            rightLevel != LATTICE_UNKNOWN &&
+            !(rightLevel == LATTICE_CONSTANT &&
+              (right.type == TYPE_CARACTER ? right.value.charValue != 0 : right.value.intValue != 0))) {
+            mayFail = 1;    // El divisor puede valer cero
+        }
+        if (node->op == TOKEN_AND || node->op == TOKEN_OR) {
+            // Un operando que ya decide el resultado alcanza aunque el otro
+            // varie; el derecho solo si el izquierdo (que se calcula antes)
+            // no puede detener el programa
+            int decisive = node->op == TOKEN_OR;
+            constant.type = TYPE_LOGICO;
+            if ((leftLevel == LATTICE_CONSTANT && left.value.intValue == decisive) ||
+                (rightLevel == LATTICE_CONSTANT && right.value.intValue == decisive && !nodeMayFail[a])) {
+                level = LATTICE_CONSTANT;
+                constant.value.intValue = decisive;
+            } else {
+                level = leftLevel > rightLevel ? leftLevel : rightLevel;
+                constant.value.intValue = !decisive;
+            }
+        } else if (leftLevel == LATTICE_UNKNOWN || rightLevel == LATTICE_UNKNOWN) {
+            level = LATTICE_UNKNOWN;
+        } else if (leftLevel == LATTICE_CONSTANT && rightLevel == LATTICE_CONSTANT) {
+            int folded = (node->dataType == TYPE_LOGICO)
+                             ? foldComparison((TokenType)node->op, &left, &right, &constant)
+                             : foldArithmetic((TokenType)node->op, &left, &right, (DataType)node->dataType, &constant);
+            level = folded ? LATTICE_CONSTANT : LATTICE_VARYING;
+        }
+    }
+
+    int failChanged = mayFail != nodeMayFail[index];
+    nodeMayFail[index] = mayFail;
+    if (level == nodeLevel[index] &&
+        (level != LATTICE_CONSTANT || sameConstant(&constant, &nodeConstant[index]))) {
+        return failChanged;
+    }
+    if (level == LATTICE_CONSTANT && nodeLevel[index] == LATTICE_CONSTANT) {
+        level = LATTICE_VARYING;    // Dos valores distintos: no es constante
+    }
+    if (level < nodeLevel[index]) {
+        return failChanged;
+    }
+    nodeLevel[index] = (unsigned char)level;
+    nodeConstant[index] = constant;
+    return 1;
+}
+
+/**
+ * Calcula todos los nodos de una expresion, de las hojas a la raiz (en
+ * preorden inverso cada hijo aparece antes que su padre)
+ * @param root: Raiz de la expresion
+ */
+static void evaluateExpression(unsigned int root) {
+    for (unsigned int index = subtreeEnd(root); index-- > root;) {
+        evaluateNode(index);
+    }
+}
+
+/**
+ * Recalcula la definicion de una asignacion con el valor de su expresion
+ * convertido al tipo de la variable
+ * @param index: Definicion de la asignacion
+ */
+static void evaluateAssignment(int index) {
+    SsaDefinition* definition = definitionAt(index);
+    unsigned int root = definition->node + 1;
+    ConstantValue converted;
+
+    if (nodeLevel[root] == LATTICE_CONSTANT &&
+        convertConstant(&nodeConstant[root], symbolTable.entries[definition->symbol].type, &converted)) {
+        lowerDefinition(index, LATTICE_CONSTANT, &converted);
+    } else if (nodeLevel[root] != LATTICE_UNKNOWN) {
+        lowerDefinition(index, LATTICE_VARYING, NULL);
+    }
+}
+
+/**
+ * Sigue los saltos de un bloque con condicion segun lo que se sabe de ella
+ * @param block: Bloque
+ */
+static void evaluateBranch(unsigned int block) {
+    unsigned int condition = programCfg.blocks[block].condition;
+    if (nodeLevel[condition] == LATTICE_VARYING) {
+        followEdge(block, 0);
+        followEdge(block, 1);
+    } else if (nodeLevel[condition] == LATTICE_CONSTANT) {
+        followEdge(block, nodeConstant[condition].value.intValue ? 0 : 1);
+    }
+}
+
+/**
+ * Procesa un bloque que paso a ejecutarse: sus phi, sus sentencias y su salto
+ * @param block: Bloque
+ */
+static void visitBlock(unsigned int block) {
+    const BasicBlock* current = &programCfg.blocks[block];
+    BlockState* state = blockState(block);
+
+    for (unsigned int i = 0; i < state->phiCount; i++) {
+        evaluatePhi((int)(state->firstPhi + i));
+    }
+    for (unsigned int i = 0; i < current->statementCount; i++) {
+        unsigned int node = programCfg.statements[current->firstStatement + i];
+        AstKind kind = (AstKind)programAst.nodes[node].kind;
+        if (kind == AST_ASSIGN) {
+            evaluateExpression(node + 1);
+            if (nodeLink[node] >= 0) evaluateAssignment(nodeLink[node]);
+        } else if ((kind == AST_READ || kind == AST_DECLARATION) && nodeLink[node] >= 0) {
+            lowerDefinition(nodeLink[node], LATTICE_VARYING, NULL);
+        }
+    }
+    if (current->condition != 0) {
+        evaluateExpression(current->condition);
+        evaluateBranch(block);
+    } else {
+        followEdge(block, 0);
+    }
+}
+
+/**
+ * Propaga el cambio de un uso de variable hacia la raiz de su expresion y,
+ * si la raiz cambia, a la asignacion o al salto que la contiene
+ * @param node: Nodo VARIABLE cuya definicion bajo
+ */
+static void propagateUse(unsigned int node) {
+    while (evaluateNode(node)) {
+        unsigned int parent = nodeParent[node];
+        AstKind kind = (AstKind)programAst.nodes[parent].kind;
+        if (isExpressionKind(kind)) {
+            node = parent;
+            continue;
+        }
+        int link = nodeLink[parent];
+        if (kind == AST_ASSIGN && link >= 0) {
+            if (blockState(definitionAt(link)->block)->marks & BLOCK_LIVE) {
+                evaluateAssignment(link);
+            }
+        } else if ((kind == AST_IF || kind == AST_WHILE || kind == AST_REPEAT) && link >= 0) {
+            if (blockState((unsigned int)link)->marks & BLOCK_LIVE) {
+                evaluateBranch((unsigned int)link);
+            }
+        }
+        return;
+    }
+}
+
+/**
+ * Busca el primer bloque con codigo de una region inalcanzable (los bloques
+ * de union vacios solo saltan al siguiente)
+ * @param block: Primer bloque de la region
+ * @return: Bloque con codigo, o -1 si la region esta vacia
+ */
+static int firstCodeBlock(int block) {
+    for (unsigned int steps = 0; block >= 0 && steps < programCfg.blockCount; steps++) {
+        const BasicBlock* current = &programCfg.blocks[block];
+        if (current->origin != 0) {
+            return block;
+        }
+        if (current->statementCount > 0 || current->condition != 0) {
+            return -1;
+        }
+        block = current->next[0];
+    }
+    return -1;
+}
+
+/**
+ * Informa cada region inalcanzable una sola vez: en el bloque al que lleva
+ * un salto que nunca se toma desde un bloque que si se ejecuta
+ */
+static void reportUnreachableBlocks() {
+    if (!progressMessages) {
+        return;
+    }
+    for (unsigned int block = 0; block < programCfg.blockCount; block++) {
+        const BasicBlock* current = &programCfg.blocks[block];
+        if (!(blockState(block)->marks & BLOCK_LIVE) || current->condition == 0) {
+            continue;
+        }
+        for (int side = 0; side < 2; side++) {
+            int target = current->next[side];
+            if (target < 0 || (blockState((unsigned int)target)->marks & BLOCK_LIVE)) {
+                continue;
+            }
+            int code = firstCodeBlock(target);
+            if (code >= 0) {
+                // Un bloque entre llaves se ubica por su primera sentencia
+                unsigned int origin = programCfg.blocks[code].origin;
+                if (programAst.nodes[origin].kind == AST_BLOCK && programAst.nodes[origin].childCount > 0) {
+                    origin++;
+                }
+                printf("ADVERTENCIA: Codigo inalcanzable en linea %d: la condicion de la linea %d siempre es %s\n",
+                       astNodeLine(origin), astNodeLine(current->condition),
+                       side == 0 ? "falsa" : "verdadera");
+            }
+        }
+    }
+}
+
+/**
+ * Reemplaza en el arbol los usos de variables cuyo valor resulto constante
+ * por ese valor
+ * @param root: Raiz de una expresion que se ejecuta
+ */
+static void replaceConstantUses(unsigned int root) {
+    unsigned int end = subtreeEnd(root);
+    for (unsigned int index = root; index < end; index++) {
+        AstNode* node = &programAst.nodes[index];
+        if (node->kind != AST_VARIABLE || nodeLevel[index] != LATTICE_CONSTANT) {
+            continue;
+        }
+        DataType type = nodeConstant[index].type;
+        node->kind = (unsigned char)(type == TYPE_REAL ? AST_REAL_LITERAL :
+                                     type == TYPE_CARACTER ? AST_CHAR_LITERAL : AST_INT_LITERAL);
+        node->op = (unsigned char)(type == TYPE_REAL ? TOKEN_REAL_LITERAL :
+                                   type == TYPE_CARACTER ? TOKEN_CHAR_LITERAL : TOKEN_NUMBER);
+        node->dataType = (unsigned char)type;
+        node->value = nodeConstant[index].value;
+        node->flags |= AST_FLAG_FOLDED;
+    }
+}
+
+/**
+ * Elimina los bloques que no se ejecutan, deja sin condicion los saltos que
+ * siempre van al mismo lado y reemplaza los usos constantes en el arbol
+ */
+static void pruneControlFlowGraph() {
+    int* renumber = (int*)allocCfgTable(programCfg.blockCount, sizeof(int), 0xFF);
+    unsigned int kept = 0;
+    if (renumber == NULL) {
+        return;
+    }
+
+    for (unsigned int block = 0; block < programCfg.blockCount; block++) {
+        BasicBlock* current = &programCfg.blocks[block];
+        unsigned char marks = blockState(block)->marks;
+        if (!(marks & BLOCK_LIVE)) {
+            continue;
+        }
+        for (unsigned int i = 0; i < current->statementCount; i++) {
+            unsigned int node = programCfg.statements[current->firstStatement + i];
+            AstKind kind = (AstKind)programAst.nodes[node].kind;
+            if (kind == AST_ASSIGN || kind == AST_WRITE) {
+                replaceConstantUses(node + 1);
+            }
+        }
+        if (current->condition != 0) {
+            int taken = ((marks & BLOCK_EDGE_TRUE) != 0) + ((marks & BLOCK_EDGE_FALSE) != 0);
+            replaceConstantUses(current->condition);
+            if (taken == 1) {
+                current->next[0] = (marks & BLOCK_EDGE_TRUE) ? current->next[0] : current->next[1];
+                current->next[1] = -1;
+                current->condition = 0;
+            }
+        }
+        renumber[block] = (int)kept++;
+    }
+
+    for (unsigned int block = 0; block < programCfg.blockCount; block++) {
+        if (renumber[block] < 0) {
+            continue;
+        }
+        BasicBlock current = programCfg.blocks[block];
+        for (int side = 0; side < 2; side++) {
+            current.next[side] = current.next[side] >= 0 ? renumber[current.next[side]] : -1;
+        }
+        programCfg.blocks[renumber[block]] = current;
+    }
+    programCfg.removedBlocks = programCfg.blockCount - kept;
+    programCfg.blockCount = kept;
+}
+
+/**
+ * Propagacion condicional de constantes sobre el grafo armado por
+ * buildControlFlowGraph: informa y elimina el codigo inalcanzable
+ */
+void propagateConditionalConstants() {
+    if (programCfg.blockCount == 0) {
+        return;
+    }
+    nodeLevel = (unsigned char*)allocCfgTable(programAst.count, sizeof(unsigned char), 0);
+    nodeConstant = (ConstantValue*)allocCfgTable(programAst.count, sizeof(ConstantValue), 0);
+    nodeMayFail = (unsigned char*)allocCfgTable(programAst.count, sizeof(unsigned char), 0);
+    definitionWork = (int*)allocCfgTable((size_t)definitions.count * 2 + 1, sizeof(int), 0);
+    edgeWork = (unsigned int*)allocCfgTable((size_t)programCfg.blockCount * 2, sizeof(unsigned int), 0);
+    if (cfgOutOfMemory) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para la propagacion de constantes\n");
+        return;
+    }
+    definitionWorkCount = edgeWorkCount = 0;
+
+    blockState(0)->marks |= BLOCK_LIVE;
+    visitBlock(0);
+    while (edgeWorkCount > 0 || definitionWorkCount > 0) {
+        if (edgeWorkCount > 0) {
+            unsigned int edge = edgeWork[--edgeWorkCount];
+            unsigned int target = (unsigned int)programCfg.blocks[edge / 2].next[edge % 2];
+            BlockState* state = blockState(target);
+            if (!(state->marks & BLOCK_LIVE)) {
+                state->marks |= BLOCK_LIVE;
+                visitBlock(target);
+            } else {
+                for (unsigned int i = 0; i < state->phiCount; i++) {
+                    evaluatePhi((int)(state->firstPhi + i));
+                }
+            }
+            continue;
+        }
+
+        SsaDefinition* definition = definitionAt(definitionWork[--definitionWorkCount]);
+        for (unsigned int i = 0; i < definition->useCount; i++) {
+            int user = definitionUsers[definition->firstUse + i];
+            if (user >= 0) {
+                propagateUse((unsigned int)user);
+            } else if (blockState(definitionAt(-user - 1)->block)->marks & BLOCK_LIVE) {
+                evaluatePhi(-user - 1);
+            }
+        }
+    }
+
+    reportUnreachableBlocks();
+    pruneControlFlowGraph();
+}
+
+/**
+ * Muestra el grafo de flujo de control: las sentencias de cada bloque y sus saltos
+ */
+void printControlFlowGraph() {
+    unsigned int statementTotal = 0;
+    printf("\n=== GRAFO DE FLUJO DE CONTROL ===\n");
+    for (unsigned int block = 0; block < programCfg.blockCount; block++) {
+        const BasicBlock* current = &programCfg.blocks[block];
+        statementTotal += current->statementCount;
+        printf("B%u:\n", block);
+        for (unsigned int i = 0; i < current->statementCount; i++) {
+            unsigned int node = programCfg.statements[current->firstStatement + i];
+            const AstNode* statement = &programAst.nodes[node];
+            printf("    %-12s", astKindName((AstKind)statement->kind));
+            if (statement->kind != AST_WRITE && statement->value.intValue >= 0) {
+                printf(" %-12s", symbolTable.entries[statement->value.intValue].name);
+            } else {
+                printf(" %-12s", "");
+            }
+            printf(" (linea %d)\n", astNodeLine(node));
+        }
+        if (current->condition != 0) {
+            printf("    condicion (nodo %u, linea %d): verdadera -> B%d, falsa -> B%d\n", current->condition,
+                   astNodeLine(current->condition), current->next[0], current->next[1]);
+        } else if (current->next[0] >= 0) {
+            printf("    -> B%d\n", current->next[0]);
+        } else {
+            printf("    fin\n");
+        }
+    }
+    printf("=================================\n");
+    printf("Bloques: %u | Sentencias: %u | Bloques inalcanzables eliminados: %u\n",
+           programCfg.blockCount, statementTotal, programCfg.removedBlocks);
+}
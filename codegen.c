@@ -0,0 +1,800 @@
+#include "compilador.h"
+
+/*
+ * Traduccion del grafo de flujo de control a codigo de la maquina virtual de
+ * registros. Cada variable tiene su propio registro (su posicion en
+ * symbolTable), asi que leer una variable no cuesta una instruccion: las
+ * operaciones toman sus operandos directamente de los registros de las
+ * variables y los resultados intermedios van a registros temporales que se
+ * reparten como una pila durante cada sentencia.
+ *
+ * Las operaciones llevan el tipo en el codigo de operacion (el analizador
+ * semantico ya lo conoce) y las conversiones implicitas de la asignacion y
+ * de las operaciones mixtas se traducen a instrucciones CVT_*, asi la
+ * maquina virtual nunca consulta el tipo de un valor. Un literal que se
+ * opera como real se carga ya convertido.
+ *
+ * Los bloques se emiten en el orden del grafo; el salto a un bloque que
+ * sigue inmediatamente se omite. Al final, las secuencias que mas se
+ * ejecutan en los bucles (segun los pares que cuenta --perfil) se reemplazan
+ * por superinstrucciones. Las condiciones no guardan su resultado:
+ * cada operador y/o salta apenas se conoce el valor (evaluacion en
+ * cortocircuito).
+ */
+
+/* Programa traducido de la compilacion actual */
+BytecodeProgram programCode = {NULL, NULL, 0, 0, 0, 0};
+
+/* Destino de saltos. Mientras no se conoce su posicion, los saltos que lo
+   esperan forman una cadena a traves de su operando a. */
+typedef struct {
+    int position;                // Instruccion destino (-1 = todavia no emitida)
+    int chain;                   // Ultimo salto pendiente (-1 = ninguno)
+} CodeLabel;
+
+static CodeLabel* blockLabels;   // Comienzo de cada bloque del grafo
+static unsigned int nextTemp;    // Proximo temporal libre
+static unsigned int maxTemp;     // Temporales usados por la sentencia mas exigente
+static int codeOutOfMemory;
+
+/**
+ * Agrega una instruccion al final del programa
+ * @param opcode: Operacion
+ * @param type: Tipo de la constante (LOADK)
+ * @param a: Primer operando
+ * @param b: Segundo operando
+ * @param c: Tercer operando
+ * @param node: Nodo del arbol que la origina (para la linea de los errores de ejecucion)
+ * @return: Posicion de la instruccion, o -1 si no hubo memoria
+ */
+static int emitInstruction(OpCode opcode, DataType type, int a, int b, int c, unsigned int node) {
+    if (programCode.count == programCode.capacity) {
+        unsigned int capacity = programCode.capacity ? programCode.capacity * 2 : 256;
+        Instruction* code = (Instruction*)arenaResize(&compilationArena, programCode.code,
+                                                      (size_t)programCode.capacity * sizeof(Instruction),
+                                                      (size_t)capacity * sizeof(Instruction));
+        int* lines = code == NULL ? NULL
+                                  : (int*)arenaResize(&compilationArena, programCode.lines,
+                                                      (size_t)programCode.capacity * sizeof(int),
+                                                      (size_t)capacity * sizeof(int));
+        if (code != NULL) {
+            programCode.code = code;
+        }
+        if (lines == NULL) {
+            codeOutOfMemory = 1;
+            return -1;
+        }
+        programCode.lines = lines;
+        programCode.capacity = capacity;
+    }
+
+    Instruction* instruction = &programCode.code[programCode.count];
+    instruction->opcode = (unsigned char)opcode;
+    instruction->type = (unsigned char)type;
+    instruction->a = a;
+    instruction->b = b;
+    instruction->c = c;
+    programCode.lines[programCode.count] = astNodeLine(node);
+    return (int)programCode.count++;
+}
+
+/**
+ * Emite un salto a un destino, enlazandolo si el destino todavia no se conoce
+ * @param opcode: OP_JUMP, OP_JUMP_IF u OP_JUMP_IF_NOT
+ * @param label: Destino
+ * @param condition: Registro de la condicion (saltos condicionales)
+ * @param node: Nodo que lo origina
+ */
+static void emitJump(OpCode opcode, CodeLabel* label, int condition, unsigned int node) {
+    int target = label->position >= 0 ? label->position : label->chain;
+    int jump = emitInstruction(opcode, TYPE_ERROR, target, condition, 0, node);
+    if (jump >= 0 && label->position < 0) {
+        label->chain = jump;
+    }
+}
+
+/**
+ * Fija la posicion de un destino en la proxima instruccion y completa los
+ * saltos que lo esperaban
+ * @param label: Destino
+ */
+static void placeLabel(CodeLabel* label) {
+    label->position = (int)programCode.count;
+    while (label->chain >= 0) {
+        int previous = programCode.code[label->chain].a;
+        programCode.code[label->chain].a = label->position;
+        label->chain = previous;
+    }
+}
+
+/**
+ * Reserva un registro temporal
+ * @return: Numero de registro
+ */
+static int newTemp() {
+    unsigned int temp = nextTemp++;
+    if (nextTemp > maxTemp) {
+        maxTemp = nextTemp;
+    }
+    return (int)(programCode.variableCount + temp);
+}
+
+/**
+ * Obtiene los bits de un literal tal como los guarda OP_LOADK
+ * @param constant: Valor del literal
+ * @return: Operando b de la instruccion
+ */
+static int constantBits(const ConstantValue* constant) {
+    int bits = 0;
+    if (constant->type == TYPE_REAL) {
+        memcpy(&bits, &constant->value.realValue, sizeof(float));
+    } else if (constant->type == TYPE_CARACTER) {
+        bits = constant->value.charValue;
+    } else {
+        bits = constant->value.intValue;
+    }
+    return bits;
+}
+
+/**
+ * Obtiene la operacion que corresponde a un operador
+ * @param op: Tipo de token del operador
+ * @param real: 1 si se opera con reales, 0 con enteros
+ * @return: Codigo de operacion (OP_HALT si no es aritmetico ni relacional)
+ */
+static OpCode operatorOpcode(TokenType op, int real) {
+    int arithmetic = real ? OP_ADD_R : OP_ADD_I;
+    int relational = real ? OP_EQ_R : OP_EQ_I;
+    switch (op) {
+        case TOKEN_PLUS: return (OpCode)arithmetic;
+        case TOKEN_MINUS: return (OpCode)(arithmetic + 1);
+        case TOKEN_MULTIPLY: return (OpCode)(arithmetic + 2);
+        case TOKEN_DIVIDE: return (OpCode)(arithmetic + 3);
+        case TOKEN_MOD: return (OpCode)(arithmetic + 4);
+        case TOKEN_EQUAL: return (OpCode)relational;
+        case TOKEN_NOT_EQUAL: return (OpCode)(relational + 1);
+        case TOKEN_LESS: return (OpCode)(relational + 2);
+        case TOKEN_LESS_EQUAL: return (OpCode)(relational + 3);
+        case TOKEN_GREATER: return (OpCode)(relational + 4);
+        case TOKEN_GREATER_EQUAL: return (OpCode)(relational + 5);
+        default: return OP_HALT;
+    }
+}
+
+/**
+ * Obtiene la conversion que lleva un valor de un tipo a otro (caracteres y
+ * enteros comparten representacion, pero un entero asignado a un caracter
+ * se reduce)
+ * @param from: Tipo del valor
+ * @param to: Tipo destino
+ * @return: OP_CVT_*, u OP_MOVE si no hace falta convertir
+ */
+static OpCode conversionOpcode(DataType from, DataType to) {
+    if (to == TYPE_REAL) {
+        return from == TYPE_REAL ? OP_MOVE : OP_CVT_I2R;
+    }
+    if (from == TYPE_REAL) {
+        return OP_CVT_R2I;
+    }
+    return (to == TYPE_CARACTER && from != TYPE_CARACTER) ? OP_CVT_I2C : OP_MOVE;
+}
+
+/**
+ * Indica si un nodo es un literal
+ * @param node: Nodo de una expresion
+ * @return: 1 si es un literal entero, real o caracter
+ */
+static int isLiteralNode(const AstNode* node) {
+    return node->kind == AST_INT_LITERAL || node->kind == AST_REAL_LITERAL || node->kind == AST_CHAR_LITERAL;
+}
+
+/**
+ * Indica si un nodo es un operador logico (y, o, no), que se traduce a saltos
+ * @param node: Nodo de una expresion
+ * @return: 1 si es logico
+ */
+static int isLogicalNode(const AstNode* node) {
+    return node->kind == AST_NOT || (node->kind == AST_BINARY && (node->op == TOKEN_AND || node->op == TOKEN_OR));
+}
+
+/* Clases de partes de una expresion */
+#define CODE_EXPRESSION 0        // Valor en un registro
+#define CODE_OPERAND 1           // Valor llevado al tipo de la operacion
+#define CODE_BRANCH 2            // Condicion traducida a saltos
+
+#define CODE_OUTER_LABEL -1      // Destino recibido por compileBranch
+
+/* Parte de una expresion que se esta traduciendo: se sigue con ella cada vez
+   que termina una de sus partes. Los destinos propios se nombran por la
+   posicion de la parte en la pila, que puede moverse al crecer. */
+typedef struct {
+    unsigned int node;           // Raiz de la parte
+    unsigned char kind;          // CODE_*
+    unsigned char step;          // Partes ya traducidas
+    unsigned char flag;          // Condicion: valor con que salta; operando y operacion: 1 si es con reales
+    int target;                  // Expresion: registro destino (-1 = lo elige la traduccion)
+    int label;                   // Condicion: destino (CODE_OUTER_LABEL o parte que lo tiene)
+    unsigned int mark;           // Temporales reservados al comenzar
+    int value;                   // Operacion: registro del primer operando; valor logico: destino
+    CodeLabel own;               // Salida de un y/o, o final de un valor logico
+} CodeFrame;
+
+static CodeFrame* codeFrames;    // Partes abiertas
+static unsigned int codeFrameCount;
+static unsigned int codeFrameCapacity;
+static CodeLabel* outerLabel;    // Destino de la condicion que se traduce
+static int codeResult;           // Registro del valor de la ultima parte terminada
+
+/**
+ * Abre una parte de una expresion
+ * @param kind: CODE_*
+ * @param node: Raiz de la parte
+ * @param flag: Valor con que salta (condicion) o 1 si se opera con reales (operando)
+ * @param label: Destino de la condicion
+ */
+static void pushCodeFrame(int kind, unsigned int node, int flag, int label) {
+    if (codeFrameCount == codeFrameCapacity) {
+        unsigned int capacity = codeFrameCapacity ? codeFrameCapacity * 2 : 64;
+        CodeFrame* frames = (CodeFrame*)arenaResize(&compilationArena, codeFrames,
+                                                    (size_t)codeFrameCapacity * sizeof(CodeFrame),
+                                                    (size_t)capacity * sizeof(CodeFrame));
+        if (frames == NULL) {
+            codeOutOfMemory = 1;
+            return;
+        }
+        codeFrames = frames;
+        codeFrameCapacity = capacity;
+    }
+
+    CodeFrame* frame = &codeFrames[codeFrameCount++];
+    frame->node = node;
+    frame->kind = (unsigned char)kind;
+    frame->step = 0;
+    frame->flag = (unsigned char)flag;
+    frame->target = -1;
+    frame->label = label;
+    frame->mark = nextTemp;
+    frame->value = -1;
+    frame->own.position = -1;
+    frame->own.chain = -1;
+}
+
+/**
+ * Cierra la parte de arriba de la pila
+ * @param value: Registro con su valor (las condiciones no tienen)
+ */
+static void finishCodeFrame(int value) {
+    codeResult = value;
+    codeFrameCount--;
+}
+
+/**
+ * Obtiene el destino de una condicion
+ * @param label: CODE_OUTER_LABEL o posicion de la parte que lo tiene
+ * @return: Destino
+ */
+static CodeLabel* codeLabel(int label) {
+    return label == CODE_OUTER_LABEL ? outerLabel : &codeFrames[label].own;
+}
+
+/**
+ * Sigue con una condicion: salta a su destino si la condicion vale flag y
+ * sigue con la instruccion siguiente si no
+ * @param index: Posicion de la parte en la pila
+ */
+static void continueBranch(unsigned int index) {
+    CodeFrame* frame = &codeFrames[index];
+    unsigned int node = frame->node;
+    const AstNode* current = &programAst.nodes[node];
+    int whenTrue = frame->flag, label = frame->label;
+
+    switch (frame->step) {
+        case 0:
+            if (current->kind == AST_NOT) {
+                frame->step = 3;
+                pushCodeFrame(CODE_BRANCH, node + 1, !whenTrue, label);
+            } else if (isLogicalNode(current)) {
+                // y salta por falso con cualquier operando falso; o, por verdadero con cualquiera verdadero
+                int decisive = current->op == TOKEN_OR;
+                if (whenTrue == decisive) {
+                    frame->step = 1;
+                    pushCodeFrame(CODE_BRANCH, node + 1, whenTrue, label);
+                } else {
+                    frame->step = 2;
+                    pushCodeFrame(CODE_BRANCH, node + 1, decisive, (int)index);
+                }
+            } else {
+                frame->step = 5;
+                pushCodeFrame(CODE_EXPRESSION, node, 0, CODE_OUTER_LABEL);
+            }
+            break;
+        case 1:  // Los dos operandos saltan al mismo destino
+        case 2:  // El primer operando salta a la salida propia
+            frame->step = frame->step == 1 ? 3 : 4;
+            pushCodeFrame(CODE_BRANCH, programAst.nodes[node + 1].nextSibling, whenTrue, label);
+            break;
+        case 3:
+            nextTemp = frame->mark;
+            finishCodeFrame(-1);
+            break;
+        case 4:
+            placeLabel(&frame->own);
+            nextTemp = frame->mark;
+            finishCodeFrame(-1);
+            break;
+        default:  // Valor ya calculado
+            emitJump(whenTrue ? OP_JUMP_IF : OP_JUMP_IF_NOT, codeLabel(label), codeResult, node);
+            nextTemp = frame->mark;
+            finishCodeFrame(-1);
+            break;
+    }
+}
+
+/**
+ * Sigue con una expresion
+ * @param index: Posicion de la parte en la pila
+ */
+static void continueExpression(unsigned int index) {
+    CodeFrame* frame = &codeFrames[index];
+    unsigned int node = frame->node;
+    const AstNode* current = &programAst.nodes[node];
+    unsigned int left = node + 1;
+
+    switch (frame->step) {
+        case 0:
+            if (current->kind == AST_VARIABLE) {
+                finishCodeFrame(current->value.intValue);
+            } else if (isLiteralNode(current)) {
+                ConstantValue constant = {(DataType)current->dataType, current->value};
+                int destination = frame->target >= 0 ? frame->target : newTemp();
+                emitInstruction(OP_LOADK, constant.type, destination, constantBits(&constant), 0, node);
+                finishCodeFrame(destination);
+            } else if (isLogicalNode(current)) {
+                // Valor de una condicion: falso salvo que se llegue a la segunda carga
+                frame->value = frame->target >= 0 ? frame->target : newTemp();
+                frame->mark = nextTemp;
+                frame->step = 1;
+                emitInstruction(OP_LOADK, TYPE_LOGICO, frame->value, 0, 0, node);
+                pushCodeFrame(CODE_BRANCH, node, 0, (int)index);
+            } else {
+                // Operacion aritmetica o relacional: con algun operando real se
+                // opera con reales. Los operandos se leen antes de escribir el destino.
+                unsigned int right = programAst.nodes[left].nextSibling;
+                frame->mark = nextTemp;
+                frame->flag = programAst.nodes[left].dataType == TYPE_REAL || programAst.nodes[right].dataType == TYPE_REAL;
+                frame->step = 2;
+                pushCodeFrame(CODE_OPERAND, left, frame->flag, CODE_OUTER_LABEL);
+            }
+            break;
+        case 1:  // Condicion del valor logico
+            emitInstruction(OP_LOADK, TYPE_LOGICO, frame->value, 1, 0, node);
+            placeLabel(&frame->own);
+            nextTemp = frame->mark;
+            finishCodeFrame(frame->value);
+            break;
+        case 2:  // Primer operando
+            frame->value = codeResult;
+            frame->step = 3;
+            pushCodeFrame(CODE_OPERAND, programAst.nodes[left].nextSibling, frame->flag, CODE_OUTER_LABEL);
+            break;
+        default: {  // Segundo operando
+            int operand = codeResult;
+            nextTemp = frame->mark;
+            int destination = frame->target >= 0 ? frame->target : newTemp();
+            emitInstruction(operatorOpcode((TokenType)current->op, frame->flag), (DataType)current->dataType,
+                            destination, frame->value, operand, node);
+            finishCodeFrame(destination);
+            break;
+        }
+    }
+}
+
+/**
+ * Sigue con un operando de una operacion llevandolo al tipo en que se opera.
+ * Un literal se convierte al compilar; otro valor entero o caracter se
+ * convierte con OP_CVT_I2R en un temporal nuevo (un registro no pasa de
+ * entero a real en el medio de una sentencia).
+ * @param index: Posicion de la parte en la pila
+ */
+static void continueOperand(unsigned int index) {
+    CodeFrame* frame = &codeFrames[index];
+    unsigned int node = frame->node;
+    const AstNode* current = &programAst.nodes[node];
+
+    if (frame->step == 0 && (!frame->flag || current->dataType == TYPE_REAL)) {
+        frame->kind = CODE_EXPRESSION;  // Se traduce como cualquier expresion
+    } else if (frame->step == 0 && isLiteralNode(current)) {
+        ConstantValue constant = {(DataType)current->dataType, current->value}, converted;
+        convertConstant(&constant, TYPE_REAL, &converted);
+        int destination = newTemp();
+        emitInstruction(OP_LOADK, TYPE_REAL, destination, constantBits(&converted), 0, node);
+        finishCodeFrame(destination);
+    } else if (frame->step == 0) {
+        frame->step = 1;
+        pushCodeFrame(CODE_EXPRESSION, node, 0, CODE_OUTER_LABEL);
+    } else {
+        int value = codeResult;
+        int destination = newTemp();
+        emitInstruction(OP_CVT_I2R, TYPE_REAL, destination, value, 0, node);
+        finishCodeFrame(destination);
+    }
+}
+
+/**
+ * Traduce la parte abierta y todas las que abre. Las partes pendientes se
+ * guardan en codeFrames y no en la pila de C, asi la profundidad de una
+ * expresion solo esta limitada por la memoria.
+ */
+static void runCodeFrames() {
+    while (!codeOutOfMemory && codeFrameCount > 0) {
+        unsigned int top = codeFrameCount - 1;
+        switch (codeFrames[top].kind) {
+            case CODE_BRANCH: continueBranch(top); break;
+            case CODE_OPERAND: continueOperand(top); break;
+            default: continueExpression(top); break;
+        }
+    }
+    codeFrameCount = 0;
+}
+
+/**
+ * Traduce una condicion a saltos: salta a label si la condicion vale
+ * whenTrue y sigue con la instruccion siguiente si no
+ * @param node: Raiz de la condicion
+ * @param whenTrue: 1 para saltar si es verdadera, 0 si es falsa
+ * @param label: Destino del salto
+ */
+static void compileBranch(unsigned int node, int whenTrue, CodeLabel* label) {
+    outerLabel = label;
+    pushCodeFrame(CODE_BRANCH, node, whenTrue, CODE_OUTER_LABEL);
+    runCodeFrames();
+}
+
+/**
+ * Traduce una expresion
+ * @param node: Raiz de la expresion
+ * @param target: Registro donde dejar el valor, o -1 para que lo elija la traduccion
+ * @return: Registro con el valor (el de la variable si la expresion es solo una variable)
+ */
+static int compileExpression(unsigned int node, int target) {
+    codeResult = 0;
+    pushCodeFrame(CODE_EXPRESSION, node, 0, CODE_OUTER_LABEL);
+    if (codeFrameCount > 0) {
+        codeFrames[codeFrameCount - 1].target = target;
+    }
+    runCodeFrames();
+    return codeResult;
+}
+
+/**
+ * Traduce una asignacion. Si la expresion es una operacion, la ultima
+ * instruccion escribe directamente en el registro de la variable. Entre
+ * enteros y reales la conversion lee de un temporal, asi el registro de una
+ * variable guarda siempre valores de su tipo (el codigo nativo lo ubica en
+ * un registro de la clase que corresponde).
+ * @param node: Nodo de la asignacion
+ */
+static void compileAssignment(unsigned int node) {
+    int variable = programAst.nodes[node].value.intValue;
+    DataType type = symbolTable.entries[variable].type;
+    unsigned int expression = node + 1;
+    const AstNode* root = &programAst.nodes[expression];
+    ConstantValue constant = {(DataType)root->dataType, root->value}, converted;
+    OpCode conversion = conversionOpcode((DataType)root->dataType, type);
+
+    if (isLiteralNode(root) && convertConstant(&constant, type, &converted)) {
+        emitInstruction(OP_LOADK, type, variable, constantBits(&converted), 0, node);
+    } else if (root->kind == AST_BINARY && !isLogicalNode(root) &&
+               (root->dataType == TYPE_REAL) == (type == TYPE_REAL)) {
+        compileExpression(expression, variable);
+        if (conversion != OP_MOVE) {
+            emitInstruction(conversion, type, variable, variable, 0, node);
+        }
+    } else {
+        int value = compileExpression(expression, -1);
+        if (value != variable || conversion != OP_MOVE) {
+            emitInstruction(conversion, type, variable, value, 0, node);
+        }
+    }
+}
+
+/**
+ * Traduce las sentencias de un bloque
+ * @param block: Bloque del grafo
+ */
+static void compileStatements(const BasicBlock* block) {
+    for (unsigned int i = 0; i < block->statementCount; i++) {
+        unsigned int node = programCfg.statements[block->firstStatement + i];
+        const AstNode* statement = &programAst.nodes[node];
+        nextTemp = 0;
+        if (statement->kind == AST_ASSIGN) {
+            compileAssignment(node);
+        } else if (statement->kind == AST_READ) {
+            int variable = statement->value.intValue;
+            DataType type = symbolTable.entries[variable].type;
+            OpCode opcode = type == TYPE_REAL ? OP_READ_R : type == TYPE_CARACTER ? OP_READ_C : OP_READ_I;
+            emitInstruction(opcode, type, variable, 0, 0, node);
+        } else if (statement->kind == AST_WRITE) {
+            DataType type = (DataType)programAst.nodes[node + 1].dataType;
+            int value = compileExpression(node + 1, -1);
+            OpCode opcode = type == TYPE_REAL ? OP_WRITE_R : type == TYPE_CARACTER ? OP_WRITE_C : OP_WRITE_I;
+            emitInstruction(opcode, type, value, 0, 0, node);
+        }
+    }
+}
+
+/**
+ * Traduce el salto final de un bloque. El bloque siguiente en el orden del
+ * grafo no necesita salto.
+ * @param index: Numero del bloque
+ */
+static void compileTerminator(unsigned int index) {
+    const BasicBlock* block = &programCfg.blocks[index];
+    int fallthrough = (int)index + 1;
+    nextTemp = 0;
+
+    if (block->condition != 0) {
+        unsigned int condition = block->condition;
+        if (block->next[0] == fallthrough) {
+            compileBranch(condition, 0, &blockLabels[block->next[1]]);
+        } else if (block->next[1] == fallthrough) {
+            compileBranch(condition, 1, &blockLabels[block->next[0]]);
+        } else {
+            compileBranch(condition, 1, &blockLabels[block->next[0]]);
+            emitJump(OP_JUMP, &blockLabels[block->next[1]], 0, condition);
+        }
+    } else if (block->next[0] < 0) {
+        emitInstruction(OP_HALT, TYPE_ERROR, 0, 0, 0, 0);
+    } else if (block->next[0] != fallthrough) {
+        emitJump(OP_JUMP, &blockLabels[block->next[0]], 0, block->origin);
+    }
+}
+
+/**
+ * Indica si una operacion salta a la instruccion de su operando a
+ * @param opcode: Codigo de operacion
+ * @return: 1 si es un salto
+ */
+static int isJumpOpcode(OpCode opcode) {
+    return opcode == OP_JUMP || opcode == OP_JUMP_IF || opcode == OP_JUMP_IF_NOT ||
+           (opcode >= OP_JEQ_I && opcode <= OP_JGEK_I);
+}
+
+/**
+ * Indica si un registro es temporal
+ * @param reg: Numero de registro
+ * @return: 1 si no es el de una variable
+ */
+static inline int isTempRegister(int reg) {
+    return reg >= (int)programCode.variableCount;
+}
+
+/**
+ * Busca una superinstruccion que reemplace las instrucciones que empiezan en
+ * una posicion. Un temporal se lee una sola vez (la traduccion los reparte
+ * como una pila por sentencia), asi que el que une dos instrucciones
+ * consecutivas no hace falta despues. Ninguna instruccion salvo la primera
+ * puede ser destino de un salto.
+ * @param index: Primera instruccion
+ * @param isTarget: Instrucciones que son destino de algun salto
+ * @param fused: Donde dejar la superinstruccion
+ * @return: Instrucciones que reemplaza (1 si no hay ninguna)
+ */
+static int matchSuperinstruction(unsigned int index, const unsigned char* isTarget, Instruction* fused) {
+    // Negacion de cada comparacion entera (EQ, NE, LT, LE, GT, GE)
+    static const int negated[6] = {1, 0, 5, 4, 3, 2};
+    const Instruction* code = programCode.code;
+    unsigned int available = programCode.count - index;
+    const Instruction* first = &code[index];
+    const Instruction* second = available > 1 && !isTarget[index + 1] ? &code[index + 1] : NULL;
+    const Instruction* third = available > 2 && second != NULL && !isTarget[index + 2] ? &code[index + 2] : NULL;
+
+    if (second == NULL) {
+        return 1;
+    }
+    *fused = *second;
+
+    // LOADK t, k ; CMP_I u, x, t ; JUMP_IF(_NOT) u  ->  J<cmp>K_I x, k
+    if (third != NULL && first->opcode == OP_LOADK && isTempRegister(first->a) &&
+        second->opcode >= OP_EQ_I && second->opcode <= OP_GE_I && second->c == first->a &&
+        second->b != first->a && isTempRegister(second->a) &&
+        (third->opcode == OP_JUMP_IF || third->opcode == OP_JUMP_IF_NOT) && third->b == second->a) {
+        int relation = second->opcode - OP_EQ_I;
+        fused->opcode = (unsigned char)(OP_JEQK_I + (third->opcode == OP_JUMP_IF ? relation : negated[relation]));
+        fused->a = third->a;
+        fused->c = first->b;
+        return 3;
+    }
+
+    // CMP_I t, x, y ; JUMP_IF(_NOT) t  ->  J<cmp>_I x, y
+    if (first->opcode >= OP_EQ_I && first->opcode <= OP_GE_I && isTempRegister(first->a) &&
+        (second->opcode == OP_JUMP_IF || second->opcode == OP_JUMP_IF_NOT) && second->b == first->a) {
+        int relation = first->opcode - OP_EQ_I;
+        *fused = *first;
+        fused->opcode = (unsigned char)(OP_JEQ_I + (second->opcode == OP_JUMP_IF ? relation : negated[relation]));
+        fused->a = second->a;
+        return 2;
+    }
+
+    // LOADK t, k ; OP a, x, t  ->  OPK a, x, k (el incremento x := x + k es
+    // el caso de los bucles). La suma y el producto aceptan la constante a
+    // la izquierda. Un divisor cero se deja para el error de ejecucion.
+    if (first->opcode == OP_LOADK && isTempRegister(first->a) && second->b != second->c &&
+        ((second->opcode >= OP_ADD_I && second->opcode <= OP_MOD_I) ||
+         (second->opcode >= OP_ADD_R && second->opcode <= OP_MOD_R))) {
+        int real = second->opcode >= OP_ADD_R;
+        int operation = second->opcode - (real ? OP_ADD_R : OP_ADD_I);
+        int commutative = operation == 0 || operation == 2;
+        if (second->c == first->a || (commutative && second->b == first->a)) {
+            if (!real && operation >= 3 && first->b == 0) {
+                return 1;
+            }
+            fused->opcode = (unsigned char)((real ? OP_ADDK_R : OP_ADDK_I) + operation);
+            fused->b = second->c == first->a ? second->b : second->c;
+            fused->c = first->b;
+            return 2;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Reemplaza las secuencias frecuentes por superinstrucciones y corrige los
+ * destinos de los saltos
+ * @return: 1 si se completo, 0 si no hubo memoria
+ */
+static int fuseSuperinstructions() {
+    unsigned int count = programCode.count, kept = 0;
+    unsigned char* isTarget = (unsigned char*)arenaAlloc(&compilationArena, count + 1);
+    unsigned int* renumber = (unsigned int*)arenaAlloc(&compilationArena, (count + 1) * sizeof(unsigned int));
+    if (isTarget == NULL || renumber == NULL) {
+        return 0;
+    }
+    memset(isTarget, 0, count + 1);
+    for (unsigned int i = 0; i < count; i++) {
+        if (isJumpOpcode((OpCode)programCode.code[i].opcode)) {
+            isTarget[programCode.code[i].a] = 1;
+        }
+    }
+
+    for (unsigned int i = 0; i < count;) {
+        Instruction fused;
+        int length = matchSuperinstruction(i, isTarget, &fused);
+        renumber[i] = kept;
+        programCode.lines[kept] = programCode.lines[i];
+        programCode.code[kept++] = length > 1 ? fused : programCode.code[i];
+        i += (unsigned int)length;
+    }
+    renumber[count] = kept;
+
+    for (unsigned int i = 0; i < kept; i++) {
+        if (isJumpOpcode((OpCode)programCode.code[i].opcode)) {
+            programCode.code[i].a = (int)renumber[programCode.code[i].a];
+        }
+    }
+    programCode.count = kept;
+    return 1;
+}
+
+/**
+ * Traduce el programa (grafo de flujo de control ya depurado) a codigo de la
+ * maquina virtual en programCode
+ * @param superinstructions: 1 para reemplazar las secuencias frecuentes por superinstrucciones
+ * @return: 1 si se tradujo, 0 si no hubo memoria
+ */
+int generateBytecode(int superinstructions) {
+    memset(&programCode, 0, sizeof(BytecodeProgram));
+    programCode.variableCount = (unsigned int)symbolTable.count;
+    codeOutOfMemory = 0;
+    maxTemp = 0;
+    codeFrames = NULL;
+    codeFrameCount = 0;
+    codeFrameCapacity = 0;
+
+    blockLabels = (CodeLabel*)arenaAlloc(&compilationArena, (programCfg.blockCount + 1) * sizeof(CodeLabel));
+    if (blockLabels == NULL) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el codigo de la maquina virtual\n");
+        return 0;
+    }
+    memset(blockLabels, 0xFF, (programCfg.blockCount + 1) * sizeof(CodeLabel));
+
+    for (unsigned int index = 0; index < programCfg.blockCount && !codeOutOfMemory; index++) {
+        placeLabel(&blockLabels[index]);
+        compileStatements(&programCfg.blocks[index]);
+        compileTerminator(index);
+    }
+    if (programCode.count == 0 || programCode.code[programCode.count - 1].opcode != OP_HALT) {
+        emitInstruction(OP_HALT, TYPE_ERROR, 0, 0, 0, 0);
+    }
+    if (codeOutOfMemory || (superinstructions && !fuseSuperinstructions())) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el codigo de la maquina virtual\n");
+        return 0;
+    }
+    programCode.registerCount = programCode.variableCount + maxTemp;
+    return 1;
+}
+
+/**
+ * Obtiene el nombre de una operacion
+ * @param opcode: Codigo de operacion
+ * @return: Nombre para listados
+ */
+const char* opcodeName(OpCode opcode) {
+    static const char* names[OP_COUNT] = {
+        "HALT", "LOADK", "MOVE", "CVT_I2R", "CVT_R2I", "CVT_I2C",
+        "ADD_I", "SUB_I", "MUL_I", "DIV_I", "MOD_I", "ADD_R", "SUB_R", "MUL_R", "DIV_R", "MOD_R",
+        "EQ_I", "NE_I", "LT_I", "LE_I", "GT_I", "GE_I", "EQ_R", "NE_R", "LT_R", "LE_R", "GT_R", "GE_R",
+        "JUMP", "JUMP_IF", "JUMP_IF_NOT", "READ_I", "READ_R", "READ_C", "WRITE_I", "WRITE_R", "WRITE_C",
+        "ADDK_I", "SUBK_I", "MULK_I", "DIVK_I", "MODK_I", "ADDK_R", "SUBK_R", "MULK_R", "DIVK_R", "MODK_R",
+        "JEQ_I", "JNE_I", "JLT_I", "JLE_I", "JGT_I", "JGE_I", "JEQK_I", "JNEK_I", "JLTK_I", "JLEK_I", "JGTK_I", "JGEK_I"
+    };
+    return opcode < OP_COUNT ? names[opcode] : "?";
+}
+
+/**
+ * Escribe el nombre de un registro: el de su variable o tN para los temporales
+ * @param reg: Numero de registro
+ * @param buffer: Donde dejar el nombre
+ * @param size: Tamano del buffer
+ */
+static void formatRegister(int reg, char* buffer, size_t size) {
+    if (reg >= 0 && (unsigned int)reg < programCode.variableCount) {
+        snprintf(buffer, size, "%s", symbolTable.entries[reg].name);
+    } else {
+        snprintf(buffer, size, "t%u", (unsigned int)reg - programCode.variableCount);
+    }
+}
+
+/**
+ * Muestra el codigo de la maquina virtual, una instruccion por linea
+ */
+void printBytecode() {
+    char a[64], b[64], c[64];
+    printf("\n=== CODIGO DE LA MAQUINA VIRTUAL ===\n");
+    for (unsigned int i = 0; i < programCode.count; i++) {
+        const Instruction* instruction = &programCode.code[i];
+        OpCode opcode = (OpCode)instruction->opcode;
+        printf("%6u  %-12s ", i, opcodeName(opcode));
+        formatRegister(instruction->a, a, sizeof(a));
+        formatRegister(instruction->b, b, sizeof(b));
+        formatRegister(instruction->c, c, sizeof(c));
+
+        if (opcode == OP_LOADK) {
+            if (instruction->type == TYPE_REAL) {
+                float value;
+                memcpy(&value, &instruction->b, sizeof(float));
+                printf("%s, %g", a, value);
+            } else if (instruction->type == TYPE_CARACTER) {
+                printf("%s, '%c'", a, (char)instruction->b);
+            } else {
+                printf("%s, %d", a, instruction->b);
+            }
+        } else if (opcode >= OP_MOVE && opcode <= OP_CVT_I2C) {
+            printf("%s, %s", a, b);
+        } else if (opcode >= OP_ADD_I && opcode <= OP_GE_R) {
+            printf("%s, %s, %s", a, b, c);
+        } else if (opcode == OP_JUMP) {
+            printf("-> %d", instruction->a);
+        } else if (opcode == OP_JUMP_IF || opcode == OP_JUMP_IF_NOT) {
+            printf("%s -> %d", b, instruction->a);
+        } else if (opcode >= OP_READ_I && opcode <= OP_WRITE_C) {
+            printf("%s", a);
+        } else if (opcode >= OP_ADDK_I && opcode <= OP_MODK_I) {
+            printf("%s, %s, %d", a, b, instruction->c);
+        } else if (opcode >= OP_ADDK_R && opcode <= OP_MODK_R) {
+            float value;
+            memcpy(&value, &instruction->c, sizeof(float));
+            printf("%s, %s, %g", a, b, value);
+        } else if (opcode >= OP_JEQ_I && opcode <= OP_JGE_I) {
+            printf("%s, %s -> %d", b, c, instruction->a);
+        } else if (opcode >= OP_JEQK_I && opcode <= OP_JGEK_I) {
+            printf("%s, %d -> %d", b, instruction->c, instruction->a);
+        }
+        printf("\n");
+    }
+    printf("====================================\n");
+    printf("Instrucciones: %u | Registros: %u (%u variables, %u temporales) | Bytes: %lu\n", programCode.count,
+           programCode.registerCount, programCode.variableCount,
+           programCode.registerCount - programCode.variableCount,
+           (unsigned long)(programCode.count * sizeof(Instruction)));
+}
@@ -7,10 +7,10 @@
 #include <ctype.h>
 
 /* Definiciones de constantes */
-#define MAX_TOKEN_LENGTH 50
-#define MAX_IDENTIFIER_LENGTH 30
 #define MAX_STRING_LENGTH 100
+#define SOURCE_PADDING 64      // Bytes en cero garantizados despues del codigo fuente
 #define MAX_PROGRAM_LENGTH 1000
+#define DEFAULT_MAX_ERRORS 20  // Errores informados antes de detener el analisis (--max-errores)
 
 /* Tipos de tokens */
 typedef enum {
@@ -76,55 +76,490 @@ typedef enum {
     TYPE_ENTERO,
     TYPE_CARACTER,
     TYPE_REAL,
-    TYPE_ERROR
+    TYPE_ERROR,
+    TYPE_LOGICO         // Resultado de una condicion (despues de TYPE_ERROR para conservar los codigos)
 } DataType;
 
-/* Estructura para un token */
+/* Errores lexicos (se guardan en value.intValue de los tokens TOKEN_ERROR) */
+typedef enum {
+    LEXICAL_ERROR_UNKNOWN_CHAR,      // Caracter que no pertenece al lenguaje
+    LEXICAL_ERROR_UNCLOSED_CHAR,     // Caracter literal sin comilla de cierre
+    LEXICAL_ERROR_UNCLOSED_STRING    // Cadena literal sin comillas de cierre
+} LexicalError;
+
+/* Valor de un literal (o codigo de LexicalError en los tokens de error) */
+typedef union {
+    int intValue;
+    char charValue;
+    float realValue;
+} TokenValue;
+
+/* Estructura para un token: el lexema no se copia, se referencia dentro del
+   codigo fuente. La linea y la columna se calculan desde la posicion solo
+   cuando hace falta mostrarlas (getTokenLine, getTokenColumn). */
 typedef struct {
+    size_t offset;     // Posicion del lexema en sourceCode
     TokenType type;
-    char lexeme[MAX_TOKEN_LENGTH];
-    int line;
-    int column;
-    union {
-        int intValue;
-        char charValue;
-        float realValue;
-    } value;
+    int length;        // Longitud del lexema
+    TokenValue value;
 } Token;
 
+/* Valor conocido al compilar (plegado y propagacion de constantes) */
+typedef struct {
+    DataType type;     // TYPE_ENTERO, TYPE_CARACTER o TYPE_REAL
+    TokenValue value;
+} ConstantValue;
+
+/* Bloque de memoria de una arena (definido en arena.c) */
+typedef struct ArenaBlock ArenaBlock;
+
+/* Estadisticas de uso de una arena desde el ultimo resetArena */
+typedef struct {
+    size_t allocations;        // Reservas repartidas
+    size_t systemAllocations;  // Bloques nuevos pedidos al sistema
+    size_t bytesInUse;         // Bytes repartidos
+    size_t peakBytes;          // Maximo de bytes repartidos
+    size_t reservedBytes;      // Bytes de todos los bloques (se conservan al reiniciar)
+} ArenaStats;
+
+/* Arena: memoria que se reparte en orden y se libera toda junta */
+typedef struct {
+    ArenaBlock* first;
+    ArenaBlock* current;     // Bloque donde se reparte
+    ArenaStats stats;
+} Arena;
+
+/* Secuencia de tokens reconocidos por adelantado, guardada campo por campo:
+   cada arreglo es denso y se recorre con el mismo indice */
+typedef struct {
+    unsigned char* types;    // TokenType de cada token
+    size_t* offsets;         // Posicion del lexema en sourceCode
+    int* lengths;            // Longitud del lexema
+    TokenValue* values;      // Valor de los literales
+    size_t count;
+    size_t capacity;
+    Arena* arena;            // Arena duenia de los arreglos
+} TokenArray;
+
+/* Posicion de la tabla hash de nombres (el hash evita comparar textos distintos) */
+typedef struct {
+    unsigned int hash;       // Hash del nombre
+    int id;                  // Numero del nombre (-1 = libre)
+} InternSlot;
+
+/* Tabla de nombres internados: cada identificador distinto recibe un numero */
+typedef struct {
+    size_t* offsets;         // Primera aparicion de cada nombre en sourceCode
+    int* lengths;            // Longitud de cada nombre
+    unsigned int* hashes;    // Hash de cada nombre (para redistribuir y unir tablas)
+    int count;               // Cantidad de nombres
+    int capacity;            // Capacidad de los arreglos anteriores
+    InternSlot* slots;       // Tabla hash abierta con robin hood
+    int slotCount;           // Cantidad de posiciones (potencia de 2)
+    Arena storage;           // Memoria propia: el lexer puede correr en otro hilo
+} InternTable;
+
+/* Posicion de un recorrido del analizador lexico (varios pueden avanzar a la vez) */
+typedef struct {
+    size_t pos;            // Proximo byte a examinar en sourceCode
+    InternTable* names;    // Tabla donde se internan los identificadores
+} LexerCursor;
+
+/* Tuberia lexer -> parser sobre un anillo sin cerrojos (definida en pipeline.c) */
+typedef struct TokenPipeline TokenPipeline;
+
 /* Estructura para la tabla de símbolos */
-typedef struct Symbol {
-    char name[MAX_IDENTIFIER_LENGTH];
+typedef struct {
+    char* name;              // Copia del nombre para diagnosticos y listados
+    int nameLength;
+    int nameId;              // Numero del nombre en identifierNames
     DataType type;
     union {
         int intValue;
         char charValue;
         float realValue;
     } value;
-    int initialized;
-    struct Symbol* next;
+    int initialized;         // Recibe un valor antes de cada uso (lo corrige dataflow.c)
+    int shadowed;            // Declaracion del mismo nombre que oculta (-1 = ninguna)
+    int depth;               // Profundidad del ambito (0 = global)
+    unsigned int scopeSerial; // Numero del ambito que la declaro
+    unsigned int constantSerial; // Asignacion que dejo en value un valor conocido (0 = desconocido)
 } Symbol;
 
+/* Tabla de simbolos: arreglo plano en orden de declaracion, con un indice
+   por numero de nombre (identifierNames) y una pila de ambitos abiertos.
+   Las declaraciones de un bloque no se quitan al salir de el: quedan
+   vencidas porque su ambito ya no esta en la pila. */
+typedef struct {
+    Symbol* entries;
+    int count;
+    int capacity;
+    int* indexByName;        // Numero de nombre -> ultima declaracion (-1 = sin declarar)
+    int indexCapacity;
+    unsigned int* openScopes; // Numero de ambito abierto en cada profundidad
+    int depth;               // Profundidad actual (0 = global)
+    int scopeCapacity;
+    unsigned int scopeSerial; // Ultimo numero de ambito repartido
+} SymbolTable;
+
+/* Clases de nodos del arbol sintactico */
+typedef enum {
+    AST_PROGRAM,          // Raiz: declaraciones y sentencias en orden
+    AST_DECLARATION,      // Variable declarada (value = simbolo, dataType = tipo)
+    AST_ASSIGN,           // Asignacion (value = variable destino): expresion
+    AST_IF,               // Condicion, bloque [, bloque sino]
+    AST_WHILE,            // Condicion, bloque
+    AST_REPEAT,           // Bloque, condicion
+    AST_READ,             // Lectura (value = variable destino)
+    AST_WRITE,            // Escritura: expresion
+    AST_BLOCK,            // Declaraciones y sentencias entre llaves (ambito propio)
+    AST_BINARY,           // Operacion (op = TokenType): izquierda, derecha
+    AST_NOT,              // Negacion logica: condicion
+    AST_VARIABLE,         // Uso de una variable (value = simbolo)
+    AST_INT_LITERAL,
+    AST_REAL_LITERAL,
+    AST_CHAR_LITERAL
+} AstKind;
+
+/* Marcas de los nodos del arbol */
+#define AST_FLAG_ERROR 0x01   // Se informo un error dentro del nodo
+#define AST_FLAG_FOLDED 0x02  // Literal calculado al compilar (reemplaza una operacion o una variable)
+
+/* Nodo del arbol sintactico. Los nodos se guardan en preorden en un solo
+   arreglo: el primer hijo de un nodo con hijos es el nodo siguiente y el
+   resto se recorre por nextSibling. */
+typedef struct {
+    unsigned char kind;          // AstKind
+    unsigned char op;            // TokenType del operador (AST_BINARY)
+    unsigned char dataType;      // DataType (TYPE_ERROR en sentencias y subexpresiones invalidas)
+    unsigned char flags;         // AST_FLAG_*
+    unsigned int childCount;
+    unsigned int nextSibling;    // Indice del hermano siguiente (0 = ultimo hijo)
+    TokenValue value;            // Literal o posicion del simbolo en symbolTable (-1 = sin declarar)
+    size_t offset;               // Posicion del token en sourceCode
+} AstNode;
+
+/* Arbol sintactico del programa (los nodos viven en la arena de la compilacion) */
+typedef struct {
+    AstNode* nodes;
+    unsigned int count;
+    unsigned int capacity;
+} Ast;
+
+/* Bloque basico: sentencias simples en linea recta y un salto final. Con
+   condicion salta a next[0] si es verdadera y a next[1] si es falsa; sin
+   condicion salta a next[0] (-1 = fin del programa). */
+typedef struct {
+    unsigned int firstStatement; // Primera sentencia en ControlFlowGraph.statements
+    unsigned int statementCount;
+    unsigned int condition;      // Raiz de la condicion del salto en programAst (0 = sin condicion)
+    int next[2];                 // Bloques siguientes (-1 = ninguno)
+    unsigned int origin;         // Primer nodo del bloque, para ubicar mensajes (0 = vacio)
+} BasicBlock;
+
+/* Grafo de flujo de control del programa (memoria de la arena de la compilacion).
+   El bloque 0 es la entrada. */
+typedef struct {
+    BasicBlock* blocks;
+    unsigned int blockCount;
+    unsigned int blockCapacity;
+    unsigned int* statements;    // Nodos de declaraciones, asignaciones, lecturas y escrituras
+    unsigned int statementCount;
+    unsigned int statementCapacity;
+    unsigned int removedBlocks;  // Bloques inalcanzables eliminados
+} ControlFlowGraph;
+
+/* Operaciones de la maquina virtual. Los registros 0 .. variableCount - 1
+   son las variables (por su posicion en symbolTable); los siguientes son
+   temporales de las expresiones. Los registros no guardan su tipo: cada
+   operacion indica el suyo (_I para enteros, caracteres y logicos, _R para
+   reales) y las conversiones son instrucciones aparte. */
+typedef enum {
+    OP_HALT,              // Fin del programa
+    OP_LOADK,             // a := constante b (bits del valor, tipo en type)
+    OP_MOVE,              // a := b
+    OP_CVT_I2R,           // a := b entero convertido a real
+    OP_CVT_R2I,           // a := b real truncado a entero
+    OP_CVT_I2C,           // a := b entero reducido a caracter
+    OP_ADD_I,             // a := b + c
+    OP_SUB_I,             // a := b - c
+    OP_MUL_I,             // a := b * c
+    OP_DIV_I,             // a := b / c (error de ejecucion si c es cero)
+    OP_MOD_I,             // a := b % c (error de ejecucion si c es cero)
+    OP_ADD_R,
+    OP_SUB_R,
+    OP_MUL_R,
+    OP_DIV_R,
+    OP_MOD_R,
+    OP_EQ_I,              // a := b = c (logico)
+    OP_NE_I,              // a := b <> c
+    OP_LT_I,              // a := b < c
+    OP_LE_I,              // a := b <= c
+    OP_GT_I,              // a := b > c
+    OP_GE_I,              // a := b >= c
+    OP_EQ_R,
+    OP_NE_R,
+    OP_LT_R,
+    OP_LE_R,
+    OP_GT_R,
+    OP_GE_R,
+    OP_JUMP,              // Salta a la instruccion a
+    OP_JUMP_IF,           // Salta a la instruccion a si b es verdadero
+    OP_JUMP_IF_NOT,       // Salta a la instruccion a si b es falso
+    OP_READ_I,            // leer(a) entero
+    OP_READ_R,            // leer(a) real
+    OP_READ_C,            // leer(a) caracter
+    OP_WRITE_I,           // escribir(a) entero
+    OP_WRITE_R,           // escribir(a) real
+    OP_WRITE_C,           // escribir(a) caracter
+    // Superinstrucciones (ver fuseSuperinstructions en codegen.c)
+    OP_ADDK_I,            // a := b + constante c
+    OP_SUBK_I,
+    OP_MULK_I,
+    OP_DIVK_I,            // Constante distinta de cero: no se detiene
+    OP_MODK_I,
+    OP_ADDK_R,            // a := b + constante c (bits del real)
+    OP_SUBK_R,
+    OP_MULK_R,
+    OP_DIVK_R,
+    OP_MODK_R,
+    OP_JEQ_I,             // Salta a la instruccion a si b = c
+    OP_JNE_I,
+    OP_JLT_I,
+    OP_JLE_I,
+    OP_JGT_I,
+    OP_JGE_I,
+    OP_JEQK_I,            // Salta a la instruccion a si b = constante c
+    OP_JNEK_I,
+    OP_JLTK_I,
+    OP_JLEK_I,
+    OP_JGTK_I,
+    OP_JGEK_I,
+    OP_COUNT
+} OpCode;
+
+/* Instruccion de la maquina virtual (16 bytes) */
+typedef struct {
+    unsigned char opcode;        // OpCode
+    unsigned char type;          // DataType de la constante de LOADK (solo para los listados)
+    int a, b, c;                 // Registros, constante o destino del salto
+} Instruction;
+
+/* Programa traducido para la maquina virtual (memoria de la arena de la compilacion) */
+typedef struct {
+    Instruction* code;
+    int* lines;                  // Linea del codigo fuente de cada instruccion
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int variableCount;  // Registros de variables (symbolTable.count)
+    unsigned int registerCount;  // Variables mas temporales
+} BytecodeProgram;
+
+/* Estadisticas de una ejecucion */
+typedef struct {
+    unsigned long long instructions; // Instrucciones ejecutadas
+    unsigned long long* pairCounts;  // Pares de operaciones consecutivas (NULL = sin perfil)
+    unsigned int checksum;           // Suma de control de las variables al terminar
+} VmStats;
+
+/* Funciones de C que llama el codigo x86-64 */
+typedef enum {
+    RUNTIME_READ,                    // leer: readRuntimeValue (en memoria) o sslRead (objeto)
+    RUNTIME_WRITE,                   // escribir: writeRuntimeValue o sslWrite
+    RUNTIME_FMODF                    // Resto real
+} RuntimeFunction;
+
+/* Llamada a completar en un objeto relocalizable (call rel32) */
+typedef struct {
+    size_t position;                 // Posicion del desplazamiento dentro del codigo
+    RuntimeFunction function;
+} RuntimeCall;
+
+/* Codigo x86-64 traducido (jit.c) */
+typedef struct {
+    unsigned char* bytes;
+    size_t length;
+    RuntimeCall* calls;              // Llamadas a completar (solo en objetos relocalizables)
+    unsigned int callCount;
+    unsigned int pinnedRegisters;    // Registros que viven en registros del procesador
+} MachineCode;
+
+/* Programa traducido a codigo x86-64 (jit.c) */
+typedef struct {
+    void* code;                      // Paginas de codigo (lectura y ejecucion)
+    size_t size;                     // Bytes de codigo
+    const BytecodeProgram* program;  // Programa de la maquina virtual que se tradujo
+    unsigned int pinnedRegisters;    // Registros que viven en registros del procesador
+} NativeProgram;
+
+/* Estadisticas del analisis de variables inicializadas (dataflow.c) */
+typedef struct {
+    unsigned int variables;      // Variables leidas en codigo ejecutable (las que se siguen)
+    unsigned int passes;         // Pasadas por tramos de variables
+    unsigned long blockVisits;   // Bloques recalculados por la cola en todas las pasadas
+} DataflowStats;
+
+/* Codigo fuente cargado en memoria */
+typedef struct {
+    char* data;          // Texto, seguido de al menos SOURCE_PADDING bytes en cero
+    size_t length;       // Longitud del texto en bytes
+    size_t mappedSize;   // Tamano de la proyeccion en memoria (0 si esta en el heap)
+} SourceBuffer;
+
+/* Niveles de los nucleos de busqueda del analizador lexico */
+typedef enum {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} ScanKernelLevel;
+
+/* Nucleos que encuentran el final de las corridas largas del codigo fuente */
+typedef struct {
+    size_t (*skipBlanks)(const char* text, size_t pos);
+    size_t (*skipIdentifier)(const char* text, size_t pos);
+    size_t (*skipDigits)(const char* text, size_t pos);
+    size_t (*findLineEnd)(const char* text, size_t pos);
+} ScanKernels;
+
+/* Estilos de los programas generados para las mediciones */
+typedef enum {
+    BENCH_STYLE_MIXED,        // Sentencias variadas con algunos comentarios
+    BENCH_STYLE_WHITESPACE,   // Dominado por blancos y sangria
+    BENCH_STYLE_COMMENTS,     // Dominado por comentarios de linea
+    BENCH_STYLE_VARIABLES     // Miles de variables declaradas y referenciadas
+} BenchmarkStyle;
+
+/* Opciones de linea de comandos */
+typedef struct {
+    char* sourceFile;     // Archivo fuente (NULL para usar el ejemplo)
+    int printTokens;      // Listar los tokens antes de compilar
+    int benchmark;        // Ejecutar mediciones de rendimiento
+    int threadCount;      // Hilos del analisis lexico por adelantado (-1 = intercalado, 0 = todos)
+    int pipeline;         // Analisis lexico en un hilo propio, concurrente con el parser
+    int printTree;        // Mostrar el arbol sintactico despues de compilar
+    int printGraph;       // Mostrar el grafo de flujo de control despues de compilar
+    int printBytecode;    // Mostrar el codigo de la maquina virtual
+    int execute;          // Ejecutar el programa compilado
+    int profile;          // Contar los pares de operaciones ejecutadas
+    int plainBytecode;    // Generar el codigo sin superinstrucciones
+    int nativeCode;       // Ejecutar traduciendo a codigo x86-64 en lugar de la maquina virtual
+    char* objectFile;     // Objeto ELF64 a escribir con el programa traducido (NULL = ninguno)
+    int maxErrors;        // Errores informados antes de detener el analisis (0 = sin limite)
+} CompilerOptions;
+
 /* Variables globales */
 extern char* sourceCode;
-extern int currentPos;
-extern int currentLine;
-extern int currentColumn;
+extern size_t sourceLength;
+extern size_t currentPos;
 extern Token currentToken;
-extern Symbol* symbolTable;
+extern SymbolTable symbolTable;
+extern Ast programAst;
+extern BytecodeProgram programCode;
+extern ControlFlowGraph programCfg;
+extern ScanKernels scanKernels;
+extern InternTable identifierNames;
+extern Arena compilationArena;
 extern int hasError;
+extern int errorCount;         // Errores informados en la compilacion actual
+extern int maxErrors;          // Limite de errores informados (0 = sin limite)
+extern int progressMessages;   // Mensajes de avance, informativos y advertencias (no errores)
 
 /* Funciones del analizador léxico (lexer.c) */
-void initLexer(char* code);
+void initLexer(char* code, size_t length);
 Token getNextToken(void);
+Token scanToken(LexerCursor* cursor);
 int isKeyword(char* word);
+int lookupKeyword(const char* word, int length);
 int isLetter(char c);
 int isDigit(char c);
-void skipWhitespace(void);
-void skipComment(void);
+const char* getTokenText(Token token);
+int getTokenLine(Token token);
+int getTokenColumn(Token token);
+void releaseLineIndex(void);
+
+/* Nucleos de busqueda vectorizados (scan.c) */
+ScanKernelLevel detectScanKernelLevel(void);
+int selectScanKernels(ScanKernelLevel level);
+void initScanKernels(void);
+const char* scanKernelLevelName(ScanKernelLevel level);
+
+/* Tabla de nombres internados (intern.c) */
+unsigned int hashName(const char* name, int length);
+void resetInternTable(InternTable* table);
+void freeInternTable(InternTable* table);
+int internName(InternTable* table, size_t offset, int length);
+int internNameHashed(InternTable* table, size_t offset, int length, unsigned int hash);
+
+/* Arena de memoria de la compilacion (arena.c) */
+void* arenaAlloc(Arena* arena, size_t size);
+void* arenaResize(Arena* arena, void* memory, size_t oldSize, size_t newSize);
+char* arenaCopyText(Arena* arena, const char* text, size_t length);
+void resetArena(Arena* arena);
+void freeArena(Arena* arena);
+
+/* Analisis lexico por adelantado y en paralelo (tokens.c) */
+int detectProcessorCount(void);
+int tokenizeSource(SourceBuffer* source, int threadCount, TokenArray* tokens);
+Token getStreamToken(const TokenArray* tokens, size_t index);
+void freeTokenArray(TokenArray* tokens);
+
+/* Tuberia del analizador lexico en un hilo propio (pipeline.c) */
+TokenPipeline* startTokenPipeline(SourceBuffer* source);
+Token receiveToken(TokenPipeline* pipeline);
+void stopTokenPipeline(TokenPipeline* pipeline);
+
+/* Arbol sintactico (ast.c) */
+void initAst(void);
+unsigned int beginAstNode(AstKind kind, Token token);
+void endAstNode(void);
+unsigned int addAstLeaf(AstKind kind, Token token);
+unsigned int addAstPostorder(const AstNode* nodes, unsigned int count);
+void markAstError(void);
+const char* astKindName(AstKind kind);
+int astNodeLine(unsigned int node);
+int astNodeColumn(unsigned int node);
+void printAst(void);
+
+/* Grafo de flujo de control y propagacion condicional de constantes (cfg.c) */
+void initControlFlowGraph(void);
+int buildControlFlowGraph(void);
+void propagateConditionalConstants(void);
+void printControlFlowGraph(void);
+
+/* Analisis de variables inicializadas antes de cada uso (dataflow.c) */
+unsigned int checkDefiniteAssignment(void);
+DataflowStats getDataflowStats(void);
+
+/* Traduccion a codigo de la maquina virtual (codegen.c) */
+int generateBytecode(int superinstructions);
+const char* opcodeName(OpCode opcode);
+void printBytecode(void);
+
+/* Maquina virtual de registros (vm.c) */
+int executeProgram(const BytecodeProgram* program, VmStats* stats);
+const char* vmDispatchName(void);
+void printOpcodePairs(const unsigned long long* pairCounts, int limit);
+void reportRuntimeError(const BytecodeProgram* program, unsigned int pc);
+int readRuntimeValue(OpCode opcode, void* destination);
+void writeRuntimeValue(OpCode opcode, int bits);
+unsigned int registerChecksum(const void* registers, unsigned int count);
+
+/* Traduccion a codigo nativo x86-64 (jit.c) */
+int generateMachineCode(const BytecodeProgram* program, const int* failureCodes, int relocatable,
+                        MachineCode* code);
+void releaseMachineCode(MachineCode* code);
+int nativeCodeAvailable(void);
+int compileNativeProgram(const BytecodeProgram* program, NativeProgram* native);
+int executeNativeProgram(const NativeProgram* native, VmStats* stats);
+void releaseNativeProgram(NativeProgram* native);
+
+/* Escritura de objetos ELF64 relocalizables (object.c) */
+int writeObjectFile(const BytecodeProgram* program, const char* path, size_t* codeSize);
 
 /* Funciones del analizador sintáctico (parser.c) */
 void initParser(void);
+void useTokenStream(TokenArray* tokens);
+void useTokenPipeline(TokenPipeline* pipeline);
 void parseProgram(void);
 void parseDeclaration(void);
 void parseStatement(void);
@@ -134,33 +569,57 @@ void parseWhileStatement(void);
 void parseRepeatStatement(void);
 void parseReadStatement(void);
 void parseWriteStatement(void);
-void parseExpression(void);
-void parseTerm(void);
-void parseFactor(void);
-void parseCondition(void);
+DataType parseExpression(void);
+DataType parseCondition(void);
 void match(TokenType expected);
 void syntaxError(char* message);
+int registerError(int syntactic);
+int errorLimitReached(void);
 
 /* Funciones del analizador semántico (semantic.c) */
 void initSemantic(void);
-Symbol* lookupSymbol(char* name);
-Symbol* insertSymbol(char* name, DataType type);
-DataType checkExpressionType(void);
+Symbol* lookupSymbol(int nameId);
+int enterScope(void);
+void exitScope(void);
+Symbol* insertSymbol(int nameId, const char* name, int length, DataType type);
+DataType checkArithmeticOperation(DataType leftType, DataType rightType, TokenType operator);
+int checkRelationalOperation(DataType leftType, DataType rightType);
 void checkAssignmentCompatibility(Symbol* var, DataType exprType);
 void semanticError(char* message);
 DataType getTokenDataType(TokenType type);
 
+/* Plegado y propagacion de constantes (fold.c) */
+void initConstants(void);
+int foldArithmetic(TokenType operator, const ConstantValue* left, const ConstantValue* right,
+                   DataType resultType, ConstantValue* result);
+int foldComparison(TokenType operator, const ConstantValue* left, const ConstantValue* right,
+                   ConstantValue* result);
+int isZeroConstant(const ConstantValue* constant);
+int sameConstant(const ConstantValue* a, const ConstantValue* b);
+int convertConstant(const ConstantValue* constant, DataType type, ConstantValue* result);
+int getKnownValue(const Symbol* symbol, ConstantValue* constant);
+void assignKnownValue(Symbol* symbol, const ConstantValue* constant);
+size_t markConstants(void);
+void forgetConstantsSince(size_t mark);
+unsigned int enterConstantLoop(void);
+void exitConstantLoop(unsigned int outerBarrier);
+
 /* Funciones auxiliares principales */
 void printToken(Token token);
 void printSymbolTable(void);
 void cleanup(void);
-char* readSourceFile(char* filename);
+
+/* Funciones de carga del codigo fuente (source.c) */
+int loadSourceFile(const char* filename, SourceBuffer* source);
+int loadSourceString(const char* text, SourceBuffer* source);
+void releaseSource(SourceBuffer* source);
 
 /* Funciones de utilidad general (utils.c) */
 void dataTypeToString(DataType type, char* typeStr);
 void tokenTypeToString(TokenType tokenType, char* tokenStr);
 void formatSymbolValue(Symbol* symbol, char* valueStr);
 void formatLocation(int line, int column, char* locationStr);
+void formatTokenLexeme(Token token, char* lexemeStr, int size);
 
 /* Funciones de validación (utils.c) */
 int isValidIdentifier(char* identifier);
@@ -174,12 +633,33 @@ void displaySymbolTableStatistics(void);
 char* getExampleSourceCode(void);
 int initializeCompiler(char* sourceCode);
 void displayCompilationResults(int success);
-void cleanupCompiler(char* sourceCode, int isFromFile);
+int compileAndShowResults(SourceBuffer* source, CompilerOptions* options);
+int runCompiledProgram(CompilerOptions* options);
+void cleanupCompiler(SourceBuffer* source);
+void printUsage(char* programName);
+int parseArguments(int argc, char* argv[], CompilerOptions* options);
+void printAllTokens(SourceBuffer* source);
+
+/* Funciones de medicion de rendimiento (bench.c) */
+int generateBenchmarkProgram(int statementCount, unsigned int seed, BenchmarkStyle style, SourceBuffer* source);
+double getCurrentSeconds(void);
+void benchmarkLexer(const char* name, SourceBuffer* source, int repetitions);
+void benchmarkScanKernels(void);
+void benchmarkKeywords(void);
+void benchmarkParallelLexer(const char* name, SourceBuffer* source);
+void benchmarkPhases(const char* name, SourceBuffer* source);
+void benchmarkMemory(const char* name, SourceBuffer* source);
+void benchmarkScopes(int nested, int firstCount);
+void benchmarkControlFlow(int nested, int firstCount);
+void benchmarkDefiniteAssignment(void);
+void benchmarkVirtualMachine(void);
+void benchmarkNativeCode(void);
+void runBenchmarks(SourceBuffer* userSource);
 
 /* Funciones auxiliares de semantic mejoradas */
 void initializeSymbolValue(Symbol* symbol, DataType type);
-Symbol* createSymbol(char* name, DataType type);
+Symbol* createSymbol(int nameId, const char* name, int length, DataType type);
 int insertSymbolInTable(Symbol* symbol);
-void freeSymbol(Symbol* symbol);
+void releaseSymbolTable(void);
 
 #endif
\ No newline at end of file
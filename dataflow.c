@@ -0,0 +1,381 @@
+#include "compilador.h"
+
+/*
+ * Variables inicializadas antes de cada uso (asignacion definitiva). Es un
+ * problema de flujo de datos hacia adelante sobre el grafo de flujo de
+ * control: al entrar a un bloque una variable esta asignada si lo esta al
+ * salir de todos sus predecesores. Cada bloque guarda su salida como un
+ * conjunto de bits indexado por variable y una cola de bloques pendientes
+ * recalcula solo los bloques cuya entrada cambio.
+ *
+ * Solo se siguen las variables que se leen en codigo ejecutable, numeradas
+ * en forma densa. Con decenas de miles de variables y de bloques los
+ * conjuntos completos no entran en memoria, asi que las variables se
+ * resuelven por tramos: cada pasada usa como mucho DATAFLOW_BUDGET_WORDS
+ * palabras para los conjuntos de todos los bloques.
+ */
+
+/* Palabras de 64 bits para los conjuntos de todos los bloques en una pasada */
+#define DATAFLOW_BUDGET_WORDS (1u << 21)
+
+/* Clases de eventos de un bloque */
+#define EVENT_USE 0      // Lectura de la variable en una expresion
+#define EVENT_DEFINE 1   // Asignacion o lectura con leer
+#define EVENT_KILL 2     // Declaracion (dentro de un bucle vuelve a empezar sin valor)
+
+typedef unsigned long long BitWord;
+
+/* Lo que un bloque hace con una variable seguida, en el orden del programa */
+typedef struct {
+    unsigned int variable;   // Numero denso de la variable
+    unsigned int node;       // Nodo VARIABLE del uso (EVENT_USE)
+    unsigned char kind;      // EVENT_*
+} FlowEvent;
+
+/* Estado de la pasada actual */
+static FlowEvent* events;            // Eventos de todos los bloques, bloque por bloque
+static unsigned int* firstEvent;     // Bloque -> primer evento (blockCount + 1 posiciones)
+static unsigned int* firstPredecessor; // Bloque -> primer predecesor (blockCount + 1 posiciones)
+static unsigned int* predecessors;
+static BitWord* blockOut;            // Salida de cada bloque (wordCount palabras por bloque)
+static BitWord* scratch;             // Entrada del bloque que se calcula
+static unsigned int wordCount;       // Palabras por conjunto en la pasada actual
+static unsigned int firstVariable;   // Primera variable de la pasada actual
+static unsigned int* flaggedUses;    // Nodos de los usos sin asignacion segura
+static unsigned int flaggedCount;
+static DataflowStats lastStats;
+
+/**
+ * Reserva un arreglo de la arena de la compilacion
+ * @param count: Cantidad de elementos
+ * @param itemSize: Tamano de cada elemento
+ * @return: Arreglo sin inicializar, o NULL si no hubo memoria
+ */
+static void* allocFlowTable(size_t count, size_t itemSize) {
+    return arenaAlloc(&compilationArena, (count ? count : 1) * itemSize);
+}
+
+/**
+ * Recorre las variables leidas por una expresion
+ * @param root: Raiz de la expresion
+ * @param variableIds: Simbolo -> numero denso (-1 = sin numero todavia)
+ * @param variableCount: Cantidad de variables numeradas (se actualiza)
+ * @param block: Bloque de la expresion (para contar eventos), o -1 para solo numerar
+ */
+static void collectUses(unsigned int root, int* variableIds, unsigned int* variableCount, int block) {
+    unsigned int pending = 1, index = root;
+    while (pending > 0) {
+        const AstNode* node = &programAst.nodes[index];
+        int symbol = node->value.intValue;
+        if (node->kind == AST_VARIABLE && symbol >= 0) {
+            if (block < 0) {
+                if (variableIds[symbol] < 0) {
+                    variableIds[symbol] = (int)(*variableCount)++;
+                }
+            } else {
+                FlowEvent* event = &events[firstEvent[block + 1]++];
+                event->variable = (unsigned int)variableIds[symbol];
+                event->node = index;
+                event->kind = EVENT_USE;
+            }
+        }
+        pending += node->childCount;
+        pending--;
+        index++;
+    }
+}
+
+/**
+ * Cuenta los nodos VARIABLE de una expresion
+ * @param root: Raiz de la expresion
+ * @return: Cantidad de usos de variables
+ */
+static unsigned int countUses(unsigned int root) {
+    unsigned int pending = 1, index = root, uses = 0;
+    while (pending > 0) {
+        const AstNode* node = &programAst.nodes[index];
+        uses += node->kind == AST_VARIABLE && node->value.intValue >= 0;
+        pending += node->childCount;
+        pending--;
+        index++;
+    }
+    return uses;
+}
+
+/**
+ * Recorre las sentencias de un bloque en orden: numera las variables leidas
+ * (mode 0), cuenta los eventos (mode 1) o los anota (mode 2)
+ * @param block: Bloque
+ * @param mode: Pasada de la construccion
+ * @param variableIds: Simbolo -> numero denso
+ * @param variableCount: Cantidad de variables numeradas
+ */
+static void scanBlockEvents(unsigned int block, int mode, int* variableIds, unsigned int* variableCount) {
+    const BasicBlock* current = &programCfg.blocks[block];
+    for (unsigned int i = 0; i <= current->statementCount; i++) {
+        unsigned int expression = 0, target = 0;
+        int symbol = -1;
+        unsigned char kind = EVENT_USE;
+        if (i == current->statementCount) {
+            expression = current->condition;    // La condicion del salto va despues de las sentencias
+        } else {
+            unsigned int node = programCfg.statements[current->firstStatement + i];
+            AstKind statement = (AstKind)programAst.nodes[node].kind;
+            if (statement == AST_ASSIGN || statement == AST_WRITE) {
+                expression = node + 1;
+            }
+            if (statement != AST_WRITE) {
+                symbol = programAst.nodes[node].value.intValue;
+                kind = statement == AST_DECLARATION ? EVENT_KILL : EVENT_DEFINE;
+                target = node;
+            }
+        }
+
+        if (expression != 0) {
+            if (mode == 0) {
+                collectUses(expression, variableIds, variableCount, -1);
+            } else if (mode == 1) {
+                firstEvent[block + 1] += countUses(expression);
+            } else {
+                collectUses(expression, variableIds, variableCount, (int)block);
+            }
+        }
+        if (mode != 0 && symbol >= 0 && variableIds[symbol] >= 0) {
+            if (mode == 1) {
+                firstEvent[block + 1]++;
+            } else {
+                FlowEvent* event = &events[firstEvent[block + 1]++];
+                event->variable = (unsigned int)variableIds[symbol];
+                event->node = target;
+                event->kind = kind;
+            }
+        }
+    }
+}
+
+/**
+ * Arma los eventos de cada bloque y la lista de predecesores
+ * @param variableCount: Donde guardar la cantidad de variables seguidas
+ * @return: 1 si se armo, 0 si no hubo memoria
+ */
+static int buildFlowEvents(unsigned int* variableCount) {
+    unsigned int blockCount = programCfg.blockCount;
+    int* variableIds = (int*)allocFlowTable((size_t)symbolTable.count, sizeof(int));
+    firstEvent = (unsigned int*)allocFlowTable((size_t)blockCount + 1, sizeof(unsigned int));
+    firstPredecessor = (unsigned int*)allocFlowTable((size_t)blockCount + 1, sizeof(unsigned int));
+    if (variableIds == NULL || firstEvent == NULL || firstPredecessor == NULL) {
+        return 0;
+    }
+    memset(variableIds, 0xFF, (size_t)symbolTable.count * sizeof(int));
+    memset(firstEvent, 0, ((size_t)blockCount + 1) * sizeof(unsigned int));
+    memset(firstPredecessor, 0, ((size_t)blockCount + 1) * sizeof(unsigned int));
+
+    // Numeracion densa de las variables leidas y cantidad de eventos por bloque
+    *variableCount = 0;
+    for (unsigned int block = 0; block < blockCount; block++) {
+        scanBlockEvents(block, 0, variableIds, variableCount);
+    }
+    for (unsigned int block = 0; block < blockCount; block++) {
+        scanBlockEvents(block, 1, variableIds, variableCount);
+        for (int side = 0; side < 2; side++) {
+            if (programCfg.blocks[block].next[side] >= 0) {
+                firstPredecessor[programCfg.blocks[block].next[side] + 1]++;
+            }
+        }
+    }
+    for (unsigned int block = 0; block < blockCount; block++) {
+        firstEvent[block + 1] += firstEvent[block];
+        firstPredecessor[block + 1] += firstPredecessor[block];
+    }
+
+    // Cada bloque llena su tramo avanzando firstEvent[block + 1] desde el comienzo
+    events = (FlowEvent*)allocFlowTable(firstEvent[blockCount], sizeof(FlowEvent));
+    predecessors = (unsigned int*)allocFlowTable(firstPredecessor[blockCount], sizeof(unsigned int));
+    if (events == NULL || predecessors == NULL) {
+        return 0;
+    }
+    for (unsigned int block = blockCount; block > 0; block--) {
+        firstEvent[block] = firstEvent[block - 1];
+        firstPredecessor[block] = firstPredecessor[block - 1];
+    }
+    for (unsigned int block = 0; block < blockCount; block++) {
+        scanBlockEvents(block, 2, variableIds, variableCount);
+        for (int side = 0; side < 2; side++) {
+            int next = programCfg.blocks[block].next[side];
+            if (next >= 0) {
+                predecessors[firstPredecessor[next + 1]++] = block;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * Calcula en scratch la entrada de un bloque: lo asignado al salir de todos
+ * sus predecesores (nada en el bloque de entrada)
+ * @param block: Bloque
+ */
+static void computeBlockInput(unsigned int block) {
+    unsigned int first = firstPredecessor[block], last = firstPredecessor[block + 1];
+    if (block == 0 || first == last) {
+        memset(scratch, 0, (size_t)wordCount * sizeof(BitWord));
+        return;
+    }
+    memcpy(scratch, &blockOut[(size_t)predecessors[first] * wordCount], (size_t)wordCount * sizeof(BitWord));
+    for (unsigned int p = first + 1; p < last; p++) {
+        const BitWord* out = &blockOut[(size_t)predecessors[p] * wordCount];
+        for (unsigned int w = 0; w < wordCount; w++) {
+            scratch[w] &= out[w];
+        }
+    }
+}
+
+/**
+ * Aplica a scratch los eventos de un bloque para las variables de la pasada
+ * @param block: Bloque
+ * @param report: 1 para anotar los usos de variables sin asignacion segura
+ */
+static void applyBlockEvents(unsigned int block, int report) {
+    unsigned int limit = wordCount * 64;
+    for (unsigned int e = firstEvent[block]; e < firstEvent[block + 1]; e++) {
+        const FlowEvent* event = &events[e];
+        unsigned int bit = event->variable - firstVariable;
+        if (event->variable < firstVariable || bit >= limit) {
+            continue;
+        }
+        BitWord mask = (BitWord)1 << (bit % 64);
+        if (event->kind == EVENT_DEFINE) {
+            scratch[bit / 64] |= mask;
+        } else if (event->kind == EVENT_KILL) {
+            scratch[bit / 64] &= ~mask;
+        } else if (report && !(scratch[bit / 64] & mask)) {
+            flaggedUses[flaggedCount++] = event->node;
+        }
+    }
+}
+
+/**
+ * Resuelve un tramo de variables: recalcula los bloques pendientes hasta que
+ * ninguna salida cambie y despues anota los usos sin asignacion segura
+ * @param queue: Cola circular de bloques (blockCount posiciones)
+ * @param queued: Marca de bloque en la cola
+ */
+static void solveVariableRange(unsigned int* queue, unsigned char* queued) {
+    unsigned int blockCount = programCfg.blockCount;
+    unsigned int head = 0, size = blockCount;
+
+    // Todo asignado es el punto de partida de una interseccion: solo baja
+    memset(blockOut, 0xFF, (size_t)blockCount * wordCount * sizeof(BitWord));
+    for (unsigned int block = 0; block < blockCount; block++) {
+        queue[block] = block;
+        queued[block] = 1;
+    }
+
+    while (size > 0) {
+        unsigned int block = queue[head];
+        head = (head + 1) % blockCount;
+        size--;
+        queued[block] = 0;
+        lastStats.blockVisits++;
+
+        computeBlockInput(block);
+        applyBlockEvents(block, 0);
+        BitWord* out = &blockOut[(size_t)block * wordCount];
+        if (memcmp(out, scratch, (size_t)wordCount * sizeof(BitWord)) == 0) {
+            continue;
+        }
+        memcpy(out, scratch, (size_t)wordCount * sizeof(BitWord));
+        for (int side = 0; side < 2; side++) {
+            int next = programCfg.blocks[block].next[side];
+            if (next >= 0 && !queued[next]) {
+                queued[next] = 1;
+                queue[(head + size) % blockCount] = (unsigned int)next;
+                size++;
+            }
+        }
+    }
+
+    for (unsigned int block = 0; block < blockCount; block++) {
+        computeBlockInput(block);
+        applyBlockEvents(block, 1);
+    }
+}
+
+/**
+ * Compara dos posiciones de nodos (para qsort)
+ * @param a: Primer nodo
+ * @param b: Segundo nodo
+ * @return: Negativo, cero o positivo segun el orden
+ */
+static int compareNodes(const void* a, const void* b) {
+    unsigned int x = *(const unsigned int*)a, y = *(const unsigned int*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Busca los usos de variables que pueden leerse antes de recibir un valor
+ * en algun camino del grafo de flujo de control (ya sin bloques
+ * inalcanzables) y los informa en el orden del codigo fuente. Las variables
+ * con alguno de esos usos quedan como no inicializadas en la tabla de simbolos
+ * @return: Cantidad de usos informados
+ */
+unsigned int checkDefiniteAssignment() {
+    unsigned int blockCount = programCfg.blockCount;
+    unsigned int variableCount = 0;
+
+    memset(&lastStats, 0, sizeof(DataflowStats));
+    flaggedCount = 0;
+    if (blockCount == 0) {
+        return 0;
+    }
+    if (!buildFlowEvents(&variableCount)) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el analisis de inicializacion\n");
+        return 0;
+    }
+    lastStats.variables = variableCount;
+    if (variableCount == 0) {
+        return 0;
+    }
+
+    // Tantas palabras por bloque como entren en el presupuesto, al menos una
+    unsigned int totalWords = (variableCount + 63) / 64;
+    wordCount = DATAFLOW_BUDGET_WORDS / blockCount;
+    if (wordCount == 0) wordCount = 1;
+    if (wordCount > totalWords) wordCount = totalWords;
+
+    unsigned int* queue = (unsigned int*)allocFlowTable(blockCount, sizeof(unsigned int));
+    unsigned char* queued = (unsigned char*)allocFlowTable(blockCount, sizeof(unsigned char));
+    blockOut = (BitWord*)allocFlowTable((size_t)blockCount * wordCount, sizeof(BitWord));
+    scratch = (BitWord*)allocFlowTable(wordCount, sizeof(BitWord));
+    flaggedUses = (unsigned int*)allocFlowTable(firstEvent[blockCount], sizeof(unsigned int));
+    if (queue == NULL || queued == NULL || blockOut == NULL || scratch == NULL || flaggedUses == NULL) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el analisis de inicializacion\n");
+        return 0;
+    }
+
+    for (firstVariable = 0; firstVariable < variableCount; firstVariable += wordCount * 64) {
+        solveVariableRange(queue, queued);
+        lastStats.passes++;
+    }
+
+    // Las pasadas informan por tramo de variables: se ordenan por posicion
+    qsort(flaggedUses, flaggedCount, sizeof(unsigned int), compareNodes);
+    for (unsigned int i = 0; i < flaggedCount; i++) {
+        unsigned int node = flaggedUses[i];
+        Symbol* variable = &symbolTable.entries[programAst.nodes[node].value.intValue];
+        variable->initialized = 0;
+        if (progressMessages) {
+            printf("ADVERTENCIA: Variable '%s' puede usarse sin inicializar en linea %d, columna %d\n",
+                   variable->name, astNodeLine(node), astNodeColumn(node));
+        }
+    }
+    return flaggedCount;
+}
+
+/**
+ * Obtiene las estadisticas del ultimo analisis de inicializacion
+ * @return: Variables seguidas, pasadas por tramos y bloques recalculados
+ */
+DataflowStats getDataflowStats() {
+    return lastStats;
+}
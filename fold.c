@@ -0,0 +1,323 @@
+#include "compilador.h"
+#include <limits.h>
+
+/*
+ * Plegado y propagacion de constantes. Las operaciones aritmeticas entre
+ * valores conocidos se calculan al compilar con las reglas de tipos del
+ * analizador semantico, y el valor de cada asignacion constante queda en el
+ * simbolo mientras el codigo siga en linea recta.
+ *
+ * Cada asignacion recibe un numero de serie creciente y el simbolo guarda el
+ * de la asignacion que dejo su valor (0 = desconocido). Al entrar en un bucle
+ * se fija una barrera en el numero actual: dentro del bucle solo se conocen
+ * los valores asignados despues de la barrera, porque el resto puede cambiar
+ * en la vuelta anterior. Los simbolos asignados dentro de una rama o de un
+ * bucle se anotan en un registro; al salir se olvidan sus valores.
+ */
+
+/* Ultimo numero de serie de asignacion repartido */
+static unsigned int assignmentSerial = 0;
+
+/* Los valores asignados hasta este numero no valen en el bucle actual */
+static unsigned int loopBarrier = 0;
+
+/* Registro de simbolos asignados (posiciones en symbolTable, memoria de la arena) */
+static int* assignedSymbols = NULL;
+static size_t assignedCount = 0;
+static size_t assignedCapacity = 0;
+
+/**
+ * Reinicia el estado de la propagacion para una compilacion nueva
+ */
+void initConstants() {
+    assignmentSerial = 0;
+    loopBarrier = 0;
+    assignedSymbols = NULL;
+    assignedCount = assignedCapacity = 0;
+}
+
+/**
+ * Obtiene el valor de una constante como entero (los caracteres se promueven)
+ * @param constant: Constante entera o caracter
+ * @return: Valor entero
+ */
+static int constantAsInteger(const ConstantValue* constant) {
+    return constant->type == TYPE_CARACTER ? (int)constant->value.charValue : constant->value.intValue;
+}
+
+/**
+ * Obtiene el valor de una constante como real
+ * @param constant: Constante de cualquier tipo numerico
+ * @return: Valor real
+ */
+static float constantAsReal(const ConstantValue* constant) {
+    return constant->type == TYPE_REAL ? constant->value.realValue : (float)constantAsInteger(constant);
+}
+
+/**
+ * Indica si una constante vale cero (divisor que no se puede plegar)
+ * @param constant: Constante numerica
+ * @return: 1 si vale cero, 0 si no
+ */
+int isZeroConstant(const ConstantValue* constant) {
+    return constantAsReal(constant) == 0.0f;
+}
+
+/**
+ * Calcula una operacion entre enteros. La suma, la resta y el producto dan
+ * la vuelta como en la maquina; la division y el resto por cero (o el
+ * desborde de la division) se dejan para la ejecucion.
+ * @param operator: Operador aritmetico
+ * @param left: Operando izquierdo
+ * @param right: Operando derecho
+ * @param result: Donde guardar el resultado
+ * @return: 1 si se pudo calcular, 0 si no
+ */
+static int foldIntegerOperation(TokenType operator, int left, int right, int* result) {
+    switch (operator) {
+        case TOKEN_PLUS:
+            *result = (int)((unsigned int)left + (unsigned int)right);
+            return 1;
+        case TOKEN_MINUS:
+            *result = (int)((unsigned int)left - (unsigned int)right);
+            return 1;
+        case TOKEN_MULTIPLY:
+            *result = (int)((unsigned int)left * (unsigned int)right);
+            return 1;
+        case TOKEN_DIVIDE:
+        case TOKEN_MOD:
+            if (right == 0 || (left == INT_MIN && right == -1)) {
+                return 0;
+            }
+            *result = operator == TOKEN_DIVIDE ? left / right : left % right;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Calcula una operacion aritmetica entre constantes
+ * @param operator: Operador aritmetico
+ * @param left: Operando izquierdo
+ * @param right: Operando derecho
+ * @param resultType: Tipo del resultado (checkArithmeticOperation)
+ * @param result: Donde guardar el resultado
+ * @return: 1 si se calculo, 0 si la operacion queda para la ejecucion
+ */
+int foldArithmetic(TokenType operator, const ConstantValue* left, const ConstantValue* right,
+                   DataType resultType, ConstantValue* result) {
+    if (resultType != TYPE_ENTERO && resultType != TYPE_REAL) {
+        return 0;
+    }
+    if ((operator == TOKEN_DIVIDE || operator == TOKEN_MOD) && isZeroConstant(right)) {
+        return 0;
+    }
+
+    result->type = resultType;
+    result->value.intValue = 0;
+    if (resultType == TYPE_ENTERO) {
+        return foldIntegerOperation(operator, constantAsInteger(left), constantAsInteger(right),
+                                    &result->value.intValue);
+    }
+
+    float a = constantAsReal(left), b = constantAsReal(right);
+    switch (operator) {
+        case TOKEN_PLUS: result->value.realValue = a + b; return 1;
+        case TOKEN_MINUS: result->value.realValue = a - b; return 1;
+        case TOKEN_MULTIPLY: result->value.realValue = a * b; return 1;
+        case TOKEN_DIVIDE: result->value.realValue = a / b; return 1;
+        default: return 0;    // El resto entre reales queda para la ejecucion
+    }
+}
+
+/**
+ * Calcula una comparacion entre constantes. Si alguna es real se comparan
+ * como reales; si no, como enteros (los caracteres se promueven).
+ * @param operator: Operador relacional
+ * @param left: Operando izquierdo
+ * @param right: Operando derecho
+ * @param result: Donde guardar el resultado (TYPE_LOGICO, 1 = verdadero)
+ * @return: 1 si se calculo, 0 si el operador no es relacional
+ */
+int foldComparison(TokenType operator, const ConstantValue* left, const ConstantValue* right,
+                   ConstantValue* result) {
+    int order;
+    if (left->type == TYPE_REAL || right->type == TYPE_REAL) {
+        float a = constantAsReal(left), b = constantAsReal(right);
+        if (a != a || b != b) {
+            // Con un valor que no es un numero solo <> es verdadero
+            result->type = TYPE_LOGICO;
+            result->value.intValue = operator == TOKEN_NOT_EQUAL;
+            return operator >= TOKEN_EQUAL && operator <= TOKEN_GREATER_EQUAL;
+        }
+        order = (a > b) - (a < b);
+    } else {
+        int a = constantAsInteger(left), b = constantAsInteger(right);
+        order = (a > b) - (a < b);
+    }
+
+    result->type = TYPE_LOGICO;
+    switch (operator) {
+        case TOKEN_EQUAL: result->value.intValue = order == 0; return 1;
+        case TOKEN_NOT_EQUAL: result->value.intValue = order != 0; return 1;
+        case TOKEN_LESS: result->value.intValue = order < 0; return 1;
+        case TOKEN_LESS_EQUAL: result->value.intValue = order <= 0; return 1;
+        case TOKEN_GREATER: result->value.intValue = order > 0; return 1;
+        case TOKEN_GREATER_EQUAL: result->value.intValue = order >= 0; return 1;
+        default: return 0;
+    }
+}
+
+/**
+ * Indica si dos constantes son iguales en tipo y en valor
+ * @param a: Primera constante
+ * @param b: Segunda constante
+ * @return: 1 si son iguales, 0 si no
+ */
+int sameConstant(const ConstantValue* a, const ConstantValue* b) {
+    if (a->type != b->type) {
+        return 0;
+    }
+    if (a->type == TYPE_REAL) {
+        return memcmp(&a->value.realValue, &b->value.realValue, sizeof(float)) == 0;
+    }
+    return a->type == TYPE_CARACTER ? a->value.charValue == b->value.charValue
+                                    : a->value.intValue == b->value.intValue;
+}
+
+/**
+ * Convierte una constante al tipo de la variable que la recibe, con las
+ * conversiones automaticas de la asignacion
+ * @param constant: Valor asignado
+ * @param type: Tipo de la variable
+ * @param result: Donde guardar el valor convertido
+ * @return: 1 si se convirtio, 0 si el valor no se conoce despues de la conversion
+ */
+int convertConstant(const ConstantValue* constant, DataType type, ConstantValue* result) {
+    result->type = type;
+    result->value.intValue = 0;
+    if (type == TYPE_REAL) {
+        result->value.realValue = constantAsReal(constant);
+        return 1;
+    }
+    if (constant->type == TYPE_REAL) {
+        // Un real fuera del rango de los enteros no tiene conversion definida
+        float real = constant->value.realValue;
+        if (type != TYPE_ENTERO || !(real > (float)INT_MIN && real < (float)INT_MAX)) {
+            return 0;
+        }
+        result->value.intValue = (int)real;
+        return 1;
+    }
+    if (type == TYPE_ENTERO) {
+        result->value.intValue = constantAsInteger(constant);
+        return 1;
+    }
+    if (type == TYPE_CARACTER) {
+        result->value.charValue = (char)constantAsInteger(constant);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Obtiene el valor de una variable si se conoce en este punto del programa
+ * @param symbol: Variable
+ * @param constant: Donde guardar el valor
+ * @return: 1 si el valor se conoce, 0 si no
+ */
+int getKnownValue(const Symbol* symbol, ConstantValue* constant) {
+    if (symbol == NULL || symbol->constantSerial <= loopBarrier) {
+        return 0;
+    }
+    constant->type = symbol->type;
+    constant->value.intValue = 0;
+    if (symbol->type == TYPE_CARACTER) {
+        constant->value.charValue = symbol->value.charValue;
+    } else if (symbol->type == TYPE_REAL) {
+        constant->value.realValue = symbol->value.realValue;
+    } else {
+        constant->value.intValue = symbol->value.intValue;
+    }
+    return 1;
+}
+
+/**
+ * Registra una asignacion: el simbolo pasa a tener el valor dado o, si el
+ * valor no se conoce, lo olvida
+ * @param symbol: Variable asignada
+ * @param constant: Valor ya convertido al tipo de la variable (NULL si no se conoce)
+ */
+void assignKnownValue(Symbol* symbol, const ConstantValue* constant) {
+    if (symbol == NULL) {
+        return;
+    }
+    symbol->constantSerial = 0;
+    if (constant == NULL || symbol->type == TYPE_ERROR) {
+        return;
+    }
+
+    if (assignedCount == assignedCapacity) {
+        size_t capacity = assignedCapacity ? assignedCapacity * 2 : 256;
+        int* grown = (int*)arenaResize(&compilationArena, assignedSymbols, assignedCapacity * sizeof(int),
+                                       capacity * sizeof(int));
+        if (grown == NULL) {
+            return;    // Sin memoria el valor queda desconocido, que siempre es correcto
+        }
+        assignedSymbols = grown;
+        assignedCapacity = capacity;
+    }
+    assignedSymbols[assignedCount++] = (int)(symbol - symbolTable.entries);
+
+    if (symbol->type == TYPE_CARACTER) {
+        symbol->value.charValue = constant->value.charValue;
+    } else if (symbol->type == TYPE_REAL) {
+        symbol->value.realValue = constant->value.realValue;
+    } else {
+        symbol->value.intValue = constant->value.intValue;
+    }
+    symbol->constantSerial = ++assignmentSerial;
+}
+
+/**
+ * Marca el comienzo de una rama o de un bucle en el registro de asignaciones
+ * @return: Marca para forgetConstantsSince
+ */
+size_t markConstants() {
+    return assignedCount;
+}
+
+/**
+ * Olvida los valores de las variables asignadas desde una marca (al salir de
+ * una rama o de un bucle que puede no ejecutarse). Las anotaciones se
+ * descartan: esas variables ya no tienen valor que olvidar.
+ * @param mark: Marca de markConstants
+ */
+void forgetConstantsSince(size_t mark) {
+    for (size_t i = mark; i < assignedCount; i++) {
+        symbolTable.entries[assignedSymbols[i]].constantSerial = 0;
+    }
+    if (mark < assignedCount) {
+        assignedCount = mark;
+    }
+}
+
+/**
+ * Entra en un bucle: los valores conocidos hasta aqui dejan de usarse
+ * dentro de el, porque una vuelta anterior pudo cambiarlos
+ * @return: Barrera anterior, para exitConstantLoop
+ */
+unsigned int enterConstantLoop() {
+    unsigned int outer = loopBarrier;
+    loopBarrier = assignmentSerial;
+    return outer;
+}
+
+/**
+ * Sale de un bucle y vuelve a la barrera exterior
+ * @param outerBarrier: Valor devuelto por enterConstantLoop
+ */
+void exitConstantLoop(unsigned int outerBarrier) {
+    loopBarrier = outerBarrier;
+}
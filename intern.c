@@ -0,0 +1,195 @@
+#include "compilador.h"
+
+/*
+ * Tabla de nombres internados. Cada identificador distinto recibe un numero
+ * denso (0, 1, 2...) en el orden en que aparece por primera vez. El nombre no
+ * se copia: se guarda la posicion de su primera aparicion en sourceCode.
+ * La busqueda usa direccionamiento abierto con robin hood sobre un arreglo
+ * plano de pares (hash, numero). Los arreglos viven en la arena propia de la
+ * tabla, asi cada hilo del lexer crece la suya sin coordinarse con el resto.
+ */
+
+/* Nombres de los identificadores del codigo fuente actual */
+InternTable identifierNames = {NULL, NULL, NULL, 0, 0, NULL, 0, {NULL, NULL, {0, 0, 0, 0, 0}}};
+
+/* Posiciones iniciales de la tabla hash (potencia de 2) */
+#define INTERN_INITIAL_SLOTS 256
+
+/* La tabla crece al superar 3/4 de ocupacion */
+#define INTERN_MAX_LOAD(slots) ((slots) / 4 * 3)
+
+/**
+ * Calcula el hash de un nombre (FNV-1a)
+ * @param name: Primer caracter del nombre
+ * @param length: Longitud del nombre
+ * @return: Hash del nombre
+ */
+unsigned int hashName(const char* name, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Vacia la tabla conservando la memoria reservada
+ * @param table: Tabla a vaciar
+ */
+void resetInternTable(InternTable* table) {
+    resetArena(&table->storage);
+    table->offsets = NULL;
+    table->lengths = NULL;
+    table->hashes = NULL;
+    table->slots = NULL;
+    table->count = table->capacity = table->slotCount = 0;
+}
+
+/**
+ * Libera toda la memoria de la tabla
+ * @param table: Tabla a liberar
+ */
+void freeInternTable(InternTable* table) {
+    freeArena(&table->storage);
+    memset(table, 0, sizeof(InternTable));
+}
+
+/**
+ * Distancia de una posicion ocupada a la posicion ideal de su hash
+ * @param slot: Posicion ocupada
+ * @param hash: Hash guardado en la posicion
+ * @param mask: Cantidad de posiciones menos uno
+ * @return: Cantidad de pasos de sondeo que lleva esa entrada
+ */
+static inline unsigned int probeDistance(unsigned int slot, unsigned int hash, unsigned int mask) {
+    return (slot - (hash & mask)) & mask;
+}
+
+/**
+ * Ubica un numero en la tabla hash con robin hood: al sondear, la entrada
+ * que esta mas lejos de su posicion ideal se queda con el lugar y la otra
+ * sigue buscando. Asi las distancias quedan parejas y una busqueda fallida
+ * termina en cuanto encuentra una entrada mas cercana a su origen.
+ * @param slots: Posiciones de la tabla
+ * @param mask: Cantidad de posiciones menos uno
+ * @param hash: Hash del nombre
+ * @param id: Numero del nombre
+ */
+static void placeInternSlot(InternSlot* slots, unsigned int mask, unsigned int hash, int id) {
+    InternSlot incoming = {hash, id};
+    unsigned int slot = hash & mask;
+    unsigned int distance = 0;
+
+    for (;;) {
+        if (slots[slot].id < 0) {
+            slots[slot] = incoming;
+            return;
+        }
+        unsigned int existing = probeDistance(slot, slots[slot].hash, mask);
+        if (existing < distance) {
+            InternSlot displaced = slots[slot];
+            slots[slot] = incoming;
+            incoming = displaced;
+            distance = existing;
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+}
+
+/**
+ * Agranda los arreglos de nombres y, si hace falta, la tabla hash
+ * @param table: Tabla a agrandar
+ * @return: 1 si se pudo agrandar, 0 si no hubo memoria
+ */
+static int growInternTable(InternTable* table) {
+    int slotCount = table->slotCount ? table->slotCount * 2 : INTERN_INITIAL_SLOTS;
+    int capacity = INTERN_MAX_LOAD(slotCount);
+    size_t oldCapacity = (size_t)table->capacity;
+    Arena* arena = &table->storage;
+    void* grown;
+
+    if ((grown = arenaResize(arena, table->offsets, oldCapacity * sizeof(size_t), (size_t)capacity * sizeof(size_t))) == NULL) return 0;
+    table->offsets = (size_t*)grown;
+    if ((grown = arenaResize(arena, table->lengths, oldCapacity * sizeof(int), (size_t)capacity * sizeof(int))) == NULL) return 0;
+    table->lengths = (int*)grown;
+    if ((grown = arenaResize(arena, table->hashes, oldCapacity * sizeof(unsigned int), (size_t)capacity * sizeof(unsigned int))) == NULL) return 0;
+    table->hashes = (unsigned int*)grown;
+
+    InternSlot* slots = (InternSlot*)arenaAlloc(arena, (size_t)slotCount * sizeof(InternSlot));
+    if (slots == NULL) return 0;
+    memset(slots, 0xFF, (size_t)slotCount * sizeof(InternSlot));
+    for (int id = 0; id < table->count; id++) {
+        placeInternSlot(slots, (unsigned int)(slotCount - 1), table->hashes[id], id);
+    }
+
+    table->slots = slots;
+    table->slotCount = slotCount;
+    table->capacity = capacity;
+    return 1;
+}
+
+/**
+ * Busca un nombre en la tabla hash. El hash se guarda en cada posicion, asi
+ * que solo se compara el texto cuando los hashes coinciden.
+ * @param table: Tabla donde buscar
+ * @param name: Primer caracter del nombre
+ * @param length: Longitud del nombre
+ * @param hash: Hash del nombre
+ * @return: Numero del nombre o -1 si no esta
+ */
+static int findInternSlot(const InternTable* table, const char* name, int length, unsigned int hash) {
+    unsigned int mask = (unsigned int)(table->slotCount - 1);
+    unsigned int slot = hash & mask;
+    unsigned int distance = 0;
+
+    for (;;) {
+        const InternSlot* entry = &table->slots[slot];
+        if (entry->id < 0 || probeDistance(slot, entry->hash, mask) < distance) {
+            return -1;
+        }
+        if (entry->hash == hash && table->lengths[entry->id] == length &&
+            memcmp(sourceCode + table->offsets[entry->id], name, (size_t)length) == 0) {
+            return entry->id;
+        }
+        slot = (slot + 1) & mask;
+        distance++;
+    }
+}
+
+/**
+ * Obtiene el numero de un nombre del codigo fuente, agregandolo si es nuevo
+ * @param table: Tabla de nombres
+ * @param offset: Posicion del nombre en sourceCode
+ * @param length: Longitud del nombre
+ * @param hash: Hash del nombre (hashName)
+ * @return: Numero del nombre, o -1 si no hubo memoria
+ */
+int internNameHashed(InternTable* table, size_t offset, int length, unsigned int hash) {
+    if (table->count == table->capacity && !growInternTable(table)) {
+        return -1;
+    }
+
+    int id = findInternSlot(table, sourceCode + offset, length, hash);
+    if (id >= 0) {
+        return id;
+    }
+
+    id = table->count++;
+    table->offsets[id] = offset;
+    table->lengths[id] = length;
+    table->hashes[id] = hash;
+    placeInternSlot(table->slots, (unsigned int)(table->slotCount - 1), hash, id);
+    return id;
+}
+
+/**
+ * Obtiene el numero de un nombre del codigo fuente, agregandolo si es nuevo
+ * @param table: Tabla de nombres
+ * @param offset: Posicion del nombre en sourceCode
+ * @param length: Longitud del nombre
+ * @return: Numero del nombre, o -1 si no hubo memoria
+ */
+int internName(InternTable* table, size_t offset, int length) {
+    return internNameHashed(table, offset, length, hashName(sourceCode + offset, length));
+}
@@ -0,0 +1,1101 @@
+#define _DEFAULT_SOURCE
+#include "compilador.h"
+#include <math.h>
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JIT_AVAILABLE 1
+#else
+#define JIT_AVAILABLE 0
+#endif
+
+/*
+ * Traduccion del codigo de la maquina virtual a codigo x86-64, sin
+ * ensamblador externo: cada instruccion se reemplaza por una plantilla de
+ * instrucciones del procesador con los mismos resultados que vm.c (la
+ * maquina virtual es la referencia; ver benchmarkNativeCode en bench.c).
+ *
+ * El arreglo de registros de la maquina virtual sigue siendo la memoria del
+ * programa y su direccion queda en r15. Como la traduccion separa enteros y
+ * reales, cada registro tiene una sola clase en todo el programa (o se usa
+ * de las dos formas y se deja en memoria). Los enteros mas usados viven en
+ * rbx, rbp, r12, r13 y r14 y los reales en xmm8..xmm15; el peso de cada uso
+ * crece con la cantidad de bucles (saltos hacia atras) que lo rodean.
+ *
+ * leer y escribir llaman a readRuntimeValue y writeRuntimeValue de vm.c, y
+ * el resto real a fmodf. Los registros SSE no se conservan en las llamadas,
+ * asi que los reales ubicados se guardan antes y se recargan despues.
+ *
+ * La funcion generada recibe el arreglo de registros y devuelve -1 si el
+ * programa termino o, si fallo una instruccion (division por cero o lectura
+ * invalida), su codigo de falla: el numero de la instruccion, que informa
+ * reportRuntimeError, o el que elija quien traduce (object.c).
+ *
+ * El mismo codigo sirve para ejecutar en memoria o para un objeto ELF: en
+ * memoria las llamadas usan la direccion absoluta de cada funcion; en un
+ * objeto son call rel32 a completar por el enlazador (ver RuntimeCall).
+ *
+ * Para ejecutar, el codigo se copia a paginas pedidas con mmap como lectura
+ * y escritura, que pasan a lectura y ejecucion (mprotect) antes de usarse:
+ * nunca son escribibles y ejecutables a la vez.
+ */
+
+/* Registros generales (numeracion de la codificacion) */
+enum {
+    REG_RAX = 0, REG_RCX = 1, REG_RDX = 2, REG_RBX = 3,
+    REG_RBP = 5, REG_RSI = 6, REG_RDI = 7,
+    REG_R12 = 12, REG_R13 = 13, REG_R14 = 14, REG_R15 = 15
+};
+
+/* Registros SSE de trabajo */
+#define REG_XMM0 0
+#define REG_XMM1 1
+
+/* Registro con la direccion del arreglo de registros de la maquina virtual */
+#define FRAME_REGISTER REG_R15
+
+/* Registros generales que conservan las llamadas (ubicacion de enteros) */
+static const int pinnedGeneralRegisters[] = {REG_RBX, REG_RBP, REG_R12, REG_R13, REG_R14};
+#define PINNED_GENERAL_COUNT 5
+
+/* Registros SSE para reales (xmm8..xmm15) */
+#define PINNED_SSE_FIRST 8
+#define PINNED_SSE_COUNT 8
+
+/* Niveles de bucle que cuentan para el peso de un uso */
+#define MAX_WEIGHT_DEPTH 6
+
+/* Condiciones de x86 para EQ, NE, LT, LE, GT y GE con signo */
+static const unsigned char integerConditions[6] = {0x4, 0x5, 0xC, 0xE, 0xF, 0xD};
+#define CONDITION_EQUAL 0x4
+#define CONDITION_NOT_EQUAL 0x5
+#define CONDITION_ABOVE 0x7
+#define CONDITION_ABOVE_EQUAL 0x3
+#define CONDITION_PARITY 0xA
+#define CONDITION_NO_PARITY 0xB
+#define JUMP_ALWAYS -1
+
+/* Clase de un operando de una instruccion */
+typedef enum {
+    OPERAND_NONE,
+    OPERAND_INT,                 // Registro con entero, caracter o logico
+    OPERAND_REAL,                // Registro con real
+    OPERAND_CONSTANT,
+    OPERAND_TARGET               // Destino de un salto
+} OperandKind;
+
+/* Clases de valores vistas en un registro (mascara) */
+#define CLASS_INT 1
+#define CLASS_REAL 2
+
+/* Ubicacion de un registro de la maquina virtual */
+typedef struct {
+    int pinned;                  // 1 si vive en un registro del procesador
+    int reg;                     // Registro del procesador (general o SSE segun la clase)
+    int disp;                    // Desplazamiento dentro del arreglo de registros
+} NativeOperand;
+
+/* Salto cuyo desplazamiento se completa al final */
+typedef struct {
+    size_t position;             // Posicion del desplazamiento de 32 bits
+    unsigned int label;          // Instruccion destino (count = salida)
+} JumpFixup;
+
+/* Estado de una traduccion */
+typedef struct {
+    unsigned char* bytes;
+    size_t length;
+    size_t capacity;
+    JumpFixup* fixups;
+    unsigned int fixupCount;
+    unsigned int fixupCapacity;
+    RuntimeCall* calls;          // Llamadas de un objeto relocalizable
+    unsigned int callCount;
+    unsigned int callCapacity;
+    int relocatable;             // 1 para un objeto ELF (llamadas a completar)
+    const int* failureCodes;     // Codigo de falla de cada instruccion (NULL = su numero)
+    int failed;                  // Falto memoria
+    int* location;               // Registro del procesador de cada registro (-1 = memoria)
+    unsigned char* classes;      // Clase de cada registro (CLASS_INT o CLASS_REAL)
+    int pinned[PINNED_GENERAL_COUNT + PINNED_SSE_COUNT];
+    unsigned int pinnedCount;
+    unsigned int exitLabel;
+} JitState;
+
+/* Funcion generada */
+typedef int (*NativeEntry)(void* registers);
+
+/* ========== CODIFICACION ========== */
+
+/**
+ * Agrega un byte al codigo
+ * @param jit: Traduccion en curso
+ * @param value: Byte
+ */
+static void emitByte(JitState* jit, unsigned int value) {
+    if (jit->failed) {
+        return;
+    }
+    if (jit->length == jit->capacity) {
+        size_t capacity = jit->capacity ? jit->capacity * 2 : 4096;
+        unsigned char* bytes = (unsigned char*)realloc(jit->bytes, capacity);
+        if (bytes == NULL) {
+            jit->failed = 1;
+            return;
+        }
+        jit->bytes = bytes;
+        jit->capacity = capacity;
+    }
+    jit->bytes[jit->length++] = (unsigned char)value;
+}
+
+/**
+ * Agrega un valor de 32 bits (little endian)
+ * @param jit: Traduccion en curso
+ * @param value: Valor
+ */
+static void emit32(JitState* jit, unsigned int value) {
+    for (int i = 0; i < 4; i++) {
+        emitByte(jit, (value >> (8 * i)) & 0xFF);
+    }
+}
+
+/**
+ * Agrega un valor de 64 bits (little endian)
+ * @param jit: Traduccion en curso
+ * @param value: Valor
+ */
+static void emit64(JitState* jit, unsigned long long value) {
+    emit32(jit, (unsigned int)value);
+    emit32(jit, (unsigned int)(value >> 32));
+}
+
+/**
+ * Operando que es directamente un registro del procesador
+ * @param reg: Registro
+ * @return: Operando
+ */
+static NativeOperand machineRegister(int reg) {
+    NativeOperand operand = {1, reg, 0};
+    return operand;
+}
+
+/**
+ * Operando en memoria: la posicion de un registro de la maquina virtual
+ * @param index: Registro de la maquina virtual
+ * @return: Operando [r15 + 4 * index]
+ */
+static NativeOperand memorySlot(int index) {
+    NativeOperand operand = {0, 0, index * (int)sizeof(int)};
+    return operand;
+}
+
+/**
+ * Ubicacion actual de un registro de la maquina virtual
+ * @param jit: Traduccion en curso
+ * @param index: Registro de la maquina virtual
+ * @return: Registro del procesador o memoria
+ */
+static NativeOperand virtualRegister(const JitState* jit, int index) {
+    return jit->location[index] >= 0 ? machineRegister(jit->location[index]) : memorySlot(index);
+}
+
+/**
+ * Codifica una instruccion con operando registro/memoria (ModRM): prefijo,
+ * REX, codigo de operacion y ModRM. La memoria es siempre [r15 + disp32].
+ * @param jit: Traduccion en curso
+ * @param prefix: Prefijo obligatorio (0x66, 0xF3) o 0
+ * @param opcode: Codigo de operacion; los de dos bytes se escriben 0x0Fxx
+ * @param wide: 1 para operar con 64 bits (REX.W)
+ * @param reg: Registro (o extension del codigo) del campo reg
+ * @param operand: Operando del campo rm
+ */
+static void emitModRm(JitState* jit, unsigned int prefix, unsigned int opcode, int wide, int reg,
+                      NativeOperand operand) {
+    int rm = operand.pinned ? operand.reg : FRAME_REGISTER;
+    unsigned int rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+
+    if (prefix) {
+        emitByte(jit, prefix);
+    }
+    if (rex != 0x40) {
+        emitByte(jit, rex);
+    }
+    if (opcode > 0xFF) {
+        emitByte(jit, opcode >> 8);
+    }
+    emitByte(jit, opcode & 0xFF);
+    if (operand.pinned) {
+        emitByte(jit, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+    } else {
+        emitByte(jit, 0x80 | ((reg & 7) << 3) | (rm & 7));
+        emit32(jit, (unsigned int)operand.disp);
+    }
+}
+
+/**
+ * mov reg32, constante
+ * @param jit: Traduccion en curso
+ * @param reg: Registro general
+ * @param value: Constante
+ */
+static void emitLoadConstant(JitState* jit, int reg, int value) {
+    if (reg & 8) {
+        emitByte(jit, 0x41);
+    }
+    emitByte(jit, 0xB8 + (reg & 7));
+    emit32(jit, (unsigned int)value);
+}
+
+/**
+ * Copia un entero a un registro general (si no esta ya ahi)
+ * @param jit: Traduccion en curso
+ * @param reg: Registro general destino
+ * @param source: Operando con el valor
+ */
+static void emitLoadInteger(JitState* jit, int reg, NativeOperand source) {
+    if (!(source.pinned && source.reg == reg)) {
+        emitModRm(jit, 0, 0x8B, 0, reg, source);
+    }
+}
+
+/**
+ * Guarda un registro general en un operando (si no es el mismo)
+ * @param jit: Traduccion en curso
+ * @param reg: Registro general con el valor
+ * @param target: Operando destino
+ */
+static void emitStoreInteger(JitState* jit, int reg, NativeOperand target) {
+    if (!(target.pinned && target.reg == reg)) {
+        emitModRm(jit, 0, 0x89, 0, reg, target);
+    }
+}
+
+/**
+ * Copia un real a un registro SSE (si no esta ya ahi)
+ * @param jit: Traduccion en curso
+ * @param reg: Registro SSE destino
+ * @param source: Operando con el valor
+ */
+static void emitLoadReal(JitState* jit, int reg, NativeOperand source) {
+    if (source.pinned) {
+        if (source.reg != reg) {
+            emitModRm(jit, 0, 0x0F28, 0, reg, source);           // movaps
+        }
+    } else {
+        emitModRm(jit, 0xF3, 0x0F10, 0, reg, source);            // movss
+    }
+}
+
+/**
+ * Guarda un registro SSE en un operando (si no es el mismo)
+ * @param jit: Traduccion en curso
+ * @param reg: Registro SSE con el valor
+ * @param target: Operando destino
+ */
+static void emitStoreReal(JitState* jit, int reg, NativeOperand target) {
+    if (target.pinned) {
+        if (target.reg != reg) {
+            emitModRm(jit, 0, 0x0F28, 0, target.reg, machineRegister(reg));
+        }
+    } else {
+        emitModRm(jit, 0xF3, 0x0F11, 0, reg, target);
+    }
+}
+
+/**
+ * Carga los bits de un real constante en un registro SSE (usa eax)
+ * @param jit: Traduccion en curso
+ * @param reg: Registro SSE destino
+ * @param bits: Bits del real
+ */
+static void emitRealConstant(JitState* jit, int reg, int bits) {
+    emitLoadConstant(jit, REG_RAX, bits);
+    emitModRm(jit, 0x66, 0x0F6E, 0, reg, machineRegister(REG_RAX));  // movd
+}
+
+/**
+ * Salto (rel32) a una instruccion o a la salida; el desplazamiento se
+ * completa al terminar
+ * @param jit: Traduccion en curso
+ * @param condition: Condicion de x86 o JUMP_ALWAYS
+ * @param label: Instruccion destino (jit->exitLabel = salida)
+ */
+static void emitJump(JitState* jit, int condition, unsigned int label) {
+    if (condition == JUMP_ALWAYS) {
+        emitByte(jit, 0xE9);
+    } else {
+        emitByte(jit, 0x0F);
+        emitByte(jit, 0x80 | condition);
+    }
+    if (jit->fixupCount == jit->fixupCapacity) {
+        unsigned int capacity = jit->fixupCapacity ? jit->fixupCapacity * 2 : 64;
+        JumpFixup* fixups = (JumpFixup*)realloc(jit->fixups, capacity * sizeof(JumpFixup));
+        if (fixups == NULL) {
+            jit->failed = 1;
+            return;
+        }
+        jit->fixups = fixups;
+        jit->fixupCapacity = capacity;
+    }
+    jit->fixups[jit->fixupCount].position = jit->length;
+    jit->fixups[jit->fixupCount].label = label;
+    jit->fixupCount++;
+    emit32(jit, 0);
+}
+
+/**
+ * Sale de la funcion informando que fallo una instruccion: mov eax, codigo y
+ * salto a la salida (10 bytes)
+ * @param jit: Traduccion en curso
+ * @param pc: Instruccion que fallo
+ */
+static void emitFailure(JitState* jit, unsigned int pc) {
+    emitLoadConstant(jit, REG_RAX, jit->failureCodes != NULL ? jit->failureCodes[pc] : (int)pc);
+    emitJump(jit, JUMP_ALWAYS, jit->exitLabel);
+}
+
+/**
+ * Llama a una funcion de C (la pila ya esta alineada a 16 bytes). En un
+ * objeto es un call rel32 que completa el enlazador; en memoria, un call a
+ * la direccion absoluta.
+ * @param jit: Traduccion en curso
+ * @param function: Funcion a llamar
+ */
+static void emitCall(JitState* jit, RuntimeFunction function) {
+    if (jit->relocatable) {
+        emitByte(jit, 0xE8);              // call rel32
+        if (jit->callCount == jit->callCapacity) {
+            unsigned int capacity = jit->callCapacity ? jit->callCapacity * 2 : 16;
+            RuntimeCall* calls = (RuntimeCall*)realloc(jit->calls, capacity * sizeof(RuntimeCall));
+            if (calls == NULL) {
+                jit->failed = 1;
+                return;
+            }
+            jit->calls = calls;
+            jit->callCapacity = capacity;
+        }
+        jit->calls[jit->callCount].position = jit->length;
+        jit->calls[jit->callCount].function = function;
+        jit->callCount++;
+        emit32(jit, 0);
+        return;
+    }
+
+    uintptr_t address = function == RUNTIME_READ ? (uintptr_t)readRuntimeValue
+                      : function == RUNTIME_WRITE ? (uintptr_t)writeRuntimeValue
+                      : (uintptr_t)fmodf;
+    emitByte(jit, 0x48);                  // mov rax, imm64
+    emitByte(jit, 0xB8);
+    emit64(jit, address);
+    emitByte(jit, 0xFF);                  // call rax
+    emitByte(jit, 0xD0);
+}
+
+/**
+ * Guarda en memoria los registros ubicados en el procesador
+ * @param jit: Traduccion en curso
+ * @param general: 1 para incluir los enteros (las llamadas ya los conservan)
+ */
+static void emitSpill(JitState* jit, int general) {
+    for (unsigned int i = 0; i < jit->pinnedCount; i++) {
+        int index = jit->pinned[i];
+        if (jit->classes[index] == CLASS_REAL) {
+            emitStoreReal(jit, jit->location[index], memorySlot(index));
+        } else if (general) {
+            emitStoreInteger(jit, jit->location[index], memorySlot(index));
+        }
+    }
+}
+
+/**
+ * Recarga desde memoria los registros ubicados en el procesador
+ * @param jit: Traduccion en curso
+ * @param general: 1 para incluir los enteros
+ */
+static void emitReload(JitState* jit, int general) {
+    for (unsigned int i = 0; i < jit->pinnedCount; i++) {
+        int index = jit->pinned[i];
+        if (jit->classes[index] == CLASS_REAL) {
+            emitLoadReal(jit, jit->location[index], memorySlot(index));
+        } else if (general) {
+            emitLoadInteger(jit, jit->location[index], memorySlot(index));
+        }
+    }
+}
+
+/* ========== UBICACION DE REGISTROS ========== */
+
+/**
+ * Obtiene la clase de cada operando de una instruccion
+ * @param instruction: Instruccion
+ * @param kinds: Clases de a, b y c
+ */
+static void getOperandKinds(const Instruction* instruction, OperandKind kinds[3]) {
+    int opcode = instruction->opcode;
+    OperandKind value = instruction->type == TYPE_REAL ? OPERAND_REAL : OPERAND_INT;
+
+    kinds[0] = kinds[1] = kinds[2] = OPERAND_NONE;
+    if (opcode == OP_LOADK) {
+        kinds[0] = value;
+        kinds[1] = OPERAND_CONSTANT;
+    } else if (opcode == OP_MOVE) {
+        kinds[0] = kinds[1] = value;
+    } else if (opcode == OP_CVT_I2R) {
+        kinds[0] = OPERAND_REAL;
+        kinds[1] = OPERAND_INT;
+    } else if (opcode == OP_CVT_R2I) {
+        kinds[0] = OPERAND_INT;
+        kinds[1] = OPERAND_REAL;
+    } else if (opcode == OP_CVT_I2C) {
+        kinds[0] = kinds[1] = OPERAND_INT;
+    } else if ((opcode >= OP_ADD_I && opcode <= OP_MOD_I) || (opcode >= OP_EQ_I && opcode <= OP_GE_I)) {
+        kinds[0] = kinds[1] = kinds[2] = OPERAND_INT;
+    } else if (opcode >= OP_ADD_R && opcode <= OP_MOD_R) {
+        kinds[0] = kinds[1] = kinds[2] = OPERAND_REAL;
+    } else if (opcode >= OP_EQ_R && opcode <= OP_GE_R) {
+        kinds[0] = OPERAND_INT;
+        kinds[1] = kinds[2] = OPERAND_REAL;
+    } else if (opcode == OP_JUMP) {
+        kinds[0] = OPERAND_TARGET;
+    } else if (opcode == OP_JUMP_IF || opcode == OP_JUMP_IF_NOT) {
+        kinds[0] = OPERAND_TARGET;
+        kinds[1] = OPERAND_INT;
+    } else if (opcode == OP_READ_R || opcode == OP_WRITE_R) {
+        kinds[0] = OPERAND_REAL;
+    } else if ((opcode >= OP_READ_I && opcode <= OP_READ_C) || (opcode >= OP_WRITE_I && opcode <= OP_WRITE_C)) {
+        kinds[0] = OPERAND_INT;
+    } else if (opcode >= OP_ADDK_I && opcode <= OP_MODK_I) {
+        kinds[0] = kinds[1] = OPERAND_INT;
+        kinds[2] = OPERAND_CONSTANT;
+    } else if (opcode >= OP_ADDK_R && opcode <= OP_MODK_R) {
+        kinds[0] = kinds[1] = OPERAND_REAL;
+        kinds[2] = OPERAND_CONSTANT;
+    } else if (opcode >= OP_JEQ_I && opcode <= OP_JGE_I) {
+        kinds[0] = OPERAND_TARGET;
+        kinds[1] = kinds[2] = OPERAND_INT;
+    } else if (opcode >= OP_JEQK_I && opcode <= OP_JGEK_I) {
+        kinds[0] = OPERAND_TARGET;
+        kinds[1] = OPERAND_INT;
+        kinds[2] = OPERAND_CONSTANT;
+    }
+}
+
+/**
+ * Elige los registros de la maquina virtual que viven en el procesador:
+ * los de una sola clase con mas peso, donde cada uso pesa 8 veces mas por
+ * cada bucle que lo rodea
+ * @param jit: Traduccion en curso
+ * @param program: Programa a traducir
+ * @return: 1 si se pudo, 0 si falto memoria
+ */
+static int allocateRegisters(JitState* jit, const BytecodeProgram* program) {
+    unsigned int registerCount = program->registerCount ? program->registerCount : 1;
+    unsigned long long* weights = (unsigned long long*)calloc(registerCount, sizeof(unsigned long long));
+    int* depthChanges = (int*)calloc(program->count + 1, sizeof(int));
+    OperandKind kinds[3];
+
+    jit->location = (int*)malloc(registerCount * sizeof(int));
+    jit->classes = (unsigned char*)calloc(registerCount, 1);
+    if (weights == NULL || depthChanges == NULL || jit->location == NULL || jit->classes == NULL) {
+        free(weights);
+        free(depthChanges);
+        return 0;
+    }
+
+    // Cada salto hacia atras encierra un bucle entre su destino y el salto
+    for (unsigned int pc = 0; pc < program->count; pc++) {
+        getOperandKinds(&program->code[pc], kinds);
+        if (kinds[0] == OPERAND_TARGET && (unsigned int)program->code[pc].a <= pc) {
+            depthChanges[program->code[pc].a]++;
+            depthChanges[pc + 1]--;
+        }
+    }
+
+    int depth = 0;
+    for (unsigned int pc = 0; pc < program->count; pc++) {
+        const Instruction* instruction = &program->code[pc];
+        const int operands[3] = {instruction->a, instruction->b, instruction->c};
+
+        depth += depthChanges[pc];
+        getOperandKinds(instruction, kinds);
+        for (int i = 0; i < 3; i++) {
+            if (kinds[i] == OPERAND_INT || kinds[i] == OPERAND_REAL) {
+                jit->classes[operands[i]] |= kinds[i] == OPERAND_INT ? CLASS_INT : CLASS_REAL;
+                weights[operands[i]] += 1ull << (3 * (depth < MAX_WEIGHT_DEPTH ? depth : MAX_WEIGHT_DEPTH));
+            }
+        }
+    }
+
+    for (unsigned int i = 0; i < registerCount; i++) {
+        jit->location[i] = -1;
+    }
+    for (int real = 0; real <= 1; real++) {
+        unsigned char wanted = real ? CLASS_REAL : CLASS_INT;
+        int available = real ? PINNED_SSE_COUNT : PINNED_GENERAL_COUNT;
+
+        for (int slot = 0; slot < available; slot++) {
+            int best = -1;
+            for (unsigned int i = 0; i < program->registerCount; i++) {
+                if (jit->classes[i] == wanted && jit->location[i] < 0 && weights[i] > 0 &&
+                    (best < 0 || weights[i] > weights[best])) {
+                    best = (int)i;
+                }
+            }
+            if (best < 0) {
+                break;
+            }
+            jit->location[best] = real ? PINNED_SSE_FIRST + slot : pinnedGeneralRegisters[slot];
+            jit->pinned[jit->pinnedCount++] = best;
+        }
+    }
+
+    free(weights);
+    free(depthChanges);
+    return 1;
+}
+
+/* ========== PLANTILLAS ========== */
+
+/**
+ * Division o resto entero. Un divisor cero sale con error; -1 se resuelve
+ * aparte porque idiv falla con INT_MIN / -1 (la maquina virtual da INT_MIN
+ * y resto cero).
+ * @param jit: Traduccion en curso
+ * @param instruction: DIV_I, MOD_I, DIVK_I o MODK_I
+ * @param pc: Numero de la instruccion
+ */
+static void emitIntegerDivision(JitState* jit, const Instruction* instruction, unsigned int pc) {
+    int remainder = instruction->opcode == OP_MOD_I || instruction->opcode == OP_MODK_I;
+    NativeOperand target = virtualRegister(jit, instruction->a);
+    NativeOperand dividend = virtualRegister(jit, instruction->b);
+
+    if (instruction->opcode == OP_DIVK_I || instruction->opcode == OP_MODK_I) {
+        if (instruction->c == 0) {
+            emitFailure(jit, pc);
+        } else if (instruction->c == -1) {
+            if (remainder) {
+                emitByte(jit, 0x31);      // xor eax, eax
+                emitByte(jit, 0xC0);
+            } else {
+                emitLoadInteger(jit, REG_RAX, dividend);
+                emitByte(jit, 0xF7);      // neg eax
+                emitByte(jit, 0xD8);
+            }
+            emitStoreInteger(jit, REG_RAX, target);
+        } else {
+            emitLoadInteger(jit, REG_RAX, dividend);
+            emitLoadConstant(jit, REG_RCX, instruction->c);
+            emitByte(jit, 0x99);          // cdq
+            emitByte(jit, 0xF7);          // idiv ecx
+            emitByte(jit, 0xF9);
+            emitStoreInteger(jit, remainder ? REG_RDX : REG_RAX, target);
+        }
+        return;
+    }
+
+    emitLoadInteger(jit, REG_RCX, virtualRegister(jit, instruction->c));
+    emitByte(jit, 0x85);                  // test ecx, ecx
+    emitByte(jit, 0xC9);
+    emitByte(jit, 0x75);                  // jnz (saltea emitFailure)
+    emitByte(jit, 10);
+    emitFailure(jit, pc);
+    emitLoadInteger(jit, REG_RAX, dividend);
+    emitByte(jit, 0x83);                  // cmp ecx, -1
+    emitByte(jit, 0xF9);
+    emitByte(jit, 0xFF);
+    emitByte(jit, 0x75);                  // jne idiv
+    emitByte(jit, 4);
+    emitByte(jit, remainder ? 0x31 : 0xF7);  // xor edx, edx / neg eax
+    emitByte(jit, remainder ? 0xD2 : 0xD8);
+    emitByte(jit, 0xEB);                  // jmp guardar
+    emitByte(jit, 3);
+    emitByte(jit, 0x99);                  // cdq
+    emitByte(jit, 0xF7);                  // idiv ecx
+    emitByte(jit, 0xF9);
+    emitStoreInteger(jit, remainder ? REG_RDX : REG_RAX, target);
+}
+
+/**
+ * Resto real con fmodf, como la maquina virtual
+ * @param jit: Traduccion en curso
+ * @param instruction: MOD_R o MODK_R
+ */
+static void emitRealRemainder(JitState* jit, const Instruction* instruction) {
+    emitSpill(jit, 0);
+    emitLoadReal(jit, REG_XMM0, virtualRegister(jit, instruction->b));
+    if (instruction->opcode == OP_MODK_R) {
+        emitRealConstant(jit, REG_XMM1, instruction->c);
+    } else {
+        emitLoadReal(jit, REG_XMM1, virtualRegister(jit, instruction->c));
+    }
+    emitCall(jit, RUNTIME_FMODF);
+    emitReload(jit, 0);
+    emitStoreReal(jit, REG_XMM0, virtualRegister(jit, instruction->a));
+}
+
+/**
+ * Comparacion de reales con el resultado de C: si algun operando no es un
+ * numero solo es verdadero el distinto. ucomiss deja ZF, PF y CF en 1 para
+ * operandos sin orden, asi que menor y menor o igual se evaluan como mayor
+ * con los operandos invertidos (seta/setae exigen CF en 0).
+ * @param jit: Traduccion en curso
+ * @param instruction: EQ_R .. GE_R
+ */
+static void emitRealComparison(JitState* jit, const Instruction* instruction) {
+    int opcode = instruction->opcode;
+    int swapped = opcode == OP_LT_R || opcode == OP_LE_R;
+    NativeOperand left = virtualRegister(jit, swapped ? instruction->c : instruction->b);
+    NativeOperand right = virtualRegister(jit, swapped ? instruction->b : instruction->c);
+
+    emitLoadReal(jit, REG_XMM0, left);
+    emitModRm(jit, 0, 0x0F2E, 0, REG_XMM0, right);                          // ucomiss
+    if (opcode == OP_EQ_R || opcode == OP_NE_R) {
+        int equal = opcode == OP_EQ_R;
+        emitModRm(jit, 0, 0x0F90 | (equal ? CONDITION_EQUAL : CONDITION_NOT_EQUAL), 0, 0,
+                  machineRegister(REG_RAX));
+        emitModRm(jit, 0, 0x0F90 | (equal ? CONDITION_NO_PARITY : CONDITION_PARITY), 0, 0,
+                  machineRegister(REG_RCX));
+        emitModRm(jit, 0, equal ? 0x20 : 0x08, 0, REG_RCX, machineRegister(REG_RAX));  // and/or al, cl
+    } else {
+        int strict = opcode == OP_LT_R || opcode == OP_GT_R;
+        emitModRm(jit, 0, 0x0F90 | (strict ? CONDITION_ABOVE : CONDITION_ABOVE_EQUAL), 0, 0,
+                  machineRegister(REG_RAX));
+    }
+    emitModRm(jit, 0, 0x0FB6, 0, REG_RAX, machineRegister(REG_RAX));          // movzx eax, al
+    emitStoreInteger(jit, REG_RAX, virtualRegister(jit, instruction->a));
+}
+
+/**
+ * Traduce una instruccion de la maquina virtual
+ * @param jit: Traduccion en curso
+ * @param program: Programa
+ * @param pc: Numero de la instruccion
+ */
+static void translateInstruction(JitState* jit, const BytecodeProgram* program, unsigned int pc) {
+    static const unsigned int integerOperations[3] = {0x03, 0x2B, 0x0FAF};       // add, sub, imul
+    static const unsigned int integerImmediates[2] = {0, 5};                     // add, sub (0x81 /n)
+    static const unsigned int realOperations[4] = {0x0F58, 0x0F5C, 0x0F59, 0x0F5E}; // addss .. divss
+    const Instruction* instruction = &program->code[pc];
+    int opcode = instruction->opcode;
+    OperandKind kinds[3];
+    NativeOperand target = memorySlot(0);
+
+    // En los saltos a es el destino, no un registro
+    getOperandKinds(instruction, kinds);
+    if (kinds[0] == OPERAND_INT || kinds[0] == OPERAND_REAL) {
+        target = virtualRegister(jit, instruction->a);
+    }
+    int targetRegister = target.pinned ? target.reg : -1;
+
+    switch (opcode) {
+        case OP_HALT:
+            emitLoadConstant(jit, REG_RAX, -1);
+            emitJump(jit, JUMP_ALWAYS, jit->exitLabel);
+            break;
+
+        case OP_LOADK:
+            if (!target.pinned) {
+                emitModRm(jit, 0, 0xC7, 0, 0, target);                              // mov [m32], imm32
+                emit32(jit, (unsigned int)instruction->b);
+            } else if (instruction->type == TYPE_REAL) {
+                emitRealConstant(jit, target.reg, instruction->b);
+            } else {
+                emitLoadConstant(jit, target.reg, instruction->b);
+            }
+            break;
+
+        case OP_MOVE:
+            if (instruction->type == TYPE_REAL) {
+                int work = targetRegister >= 0 ? targetRegister : REG_XMM0;
+                emitLoadReal(jit, work, virtualRegister(jit, instruction->b));
+                emitStoreReal(jit, work, target);
+            } else {
+                int work = targetRegister >= 0 ? targetRegister : REG_RAX;
+                emitLoadInteger(jit, work, virtualRegister(jit, instruction->b));
+                emitStoreInteger(jit, work, target);
+            }
+            break;
+
+        case OP_CVT_I2R: {
+            int work = targetRegister >= 0 ? targetRegister : REG_XMM0;
+            emitModRm(jit, 0, 0x0F57, 0, work, machineRegister(work));              // xorps (sin dependencia)
+            emitModRm(jit, 0xF3, 0x0F2A, 0, work, virtualRegister(jit, instruction->b));  // cvtsi2ss
+            emitStoreReal(jit, work, target);
+            break;
+        }
+        case OP_CVT_R2I: {
+            // cvttss2si ya da 0x80000000 (INT_MIN) fuera de rango o sin numero
+            int work = targetRegister >= 0 ? targetRegister : REG_RAX;
+            emitModRm(jit, 0xF3, 0x0F2C, 0, work, virtualRegister(jit, instruction->b));
+            emitStoreInteger(jit, work, target);
+            break;
+        }
+        case OP_CVT_I2C:
+            emitLoadInteger(jit, REG_RAX, virtualRegister(jit, instruction->b));
+            emitModRm(jit, 0, 0x0FBE, 0, REG_RAX, machineRegister(REG_RAX));      // movsx eax, al
+            emitStoreInteger(jit, REG_RAX, target);
+            break;
+
+        case OP_ADD_I:
+        case OP_SUB_I:
+        case OP_MUL_I: {
+            // Se opera en el registro del destino salvo que sea tambien el segundo operando
+            int work = (targetRegister >= 0 && instruction->c != instruction->a) ? targetRegister : REG_RAX;
+            emitLoadInteger(jit, work, virtualRegister(jit, instruction->b));
+            emitModRm(jit, 0, integerOperations[opcode - OP_ADD_I], 0, work, virtualRegister(jit, instruction->c));
+            emitStoreInteger(jit, work, target);
+            break;
+        }
+        case OP_DIV_I:
+        case OP_MOD_I:
+        case OP_DIVK_I:
+        case OP_MODK_I:
+            emitIntegerDivision(jit, instruction, pc);
+            break;
+
+        case OP_ADD_R:
+        case OP_SUB_R:
+        case OP_MUL_R:
+        case OP_DIV_R: {
+            int work = (targetRegister >= 0 && instruction->c != instruction->a) ? targetRegister : REG_XMM0;
+            emitLoadReal(jit, work, virtualRegister(jit, instruction->b));
+            emitModRm(jit, 0xF3, realOperations[opcode - OP_ADD_R], 0, work, virtualRegister(jit, instruction->c));
+            emitStoreReal(jit, work, target);
+            break;
+        }
+        case OP_MOD_R:
+        case OP_MODK_R:
+            emitRealRemainder(jit, instruction);
+            break;
+
+        case OP_EQ_I:
+        case OP_NE_I:
+        case OP_LT_I:
+        case OP_LE_I:
+        case OP_GT_I:
+        case OP_GE_I:
+            emitLoadInteger(jit, REG_RAX, virtualRegister(jit, instruction->b));
+            emitModRm(jit, 0, 0x3B, 0, REG_RAX, virtualRegister(jit, instruction->c));   // cmp
+            emitModRm(jit, 0, 0x0F90 | integerConditions[opcode - OP_EQ_I], 0, 0, machineRegister(REG_RAX));
+            emitModRm(jit, 0, 0x0FB6, 0, REG_RAX, machineRegister(REG_RAX));
+            emitStoreInteger(jit, REG_RAX, target);
+            break;
+
+        case OP_EQ_R:
+        case OP_NE_R:
+        case OP_LT_R:
+        case OP_LE_R:
+        case OP_GT_R:
+        case OP_GE_R:
+            emitRealComparison(jit, instruction);
+            break;
+
+        case OP_JUMP:
+            emitJump(jit, JUMP_ALWAYS, (unsigned int)instruction->a);
+            break;
+        case OP_JUMP_IF:
+        case OP_JUMP_IF_NOT: {
+            NativeOperand condition = virtualRegister(jit, instruction->b);
+            if (condition.pinned) {
+                emitModRm(jit, 0, 0x85, 0, condition.reg, condition);                 // test r32, r32
+            } else {
+                emitModRm(jit, 0, 0x83, 0, 7, condition);                             // cmp [m32], 0
+                emitByte(jit, 0);
+            }
+            emitJump(jit, opcode == OP_JUMP_IF ? CONDITION_NOT_EQUAL : CONDITION_EQUAL,
+                     (unsigned int)instruction->a);
+            break;
+        }
+
+        case OP_READ_I:
+        case OP_READ_R:
+        case OP_READ_C:
+            emitSpill(jit, 0);
+            emitLoadConstant(jit, REG_RDI, jit->relocatable ? opcode - OP_READ_I : opcode);
+            emitModRm(jit, 0, 0x8D, 1, REG_RSI, memorySlot(instruction->a));           // lea rsi, [r15 + disp]
+            emitCall(jit, RUNTIME_READ);
+            emitReload(jit, 0);
+            if (target.pinned && jit->classes[instruction->a] == CLASS_INT) {
+                emitLoadInteger(jit, target.reg, memorySlot(instruction->a));
+            }
+            emitByte(jit, 0x85);          // test eax, eax
+            emitByte(jit, 0xC0);
+            emitByte(jit, 0x75);          // jnz (saltea emitFailure)
+            emitByte(jit, 10);
+            emitFailure(jit, pc);
+            break;
+
+        case OP_WRITE_I:
+        case OP_WRITE_R:
+        case OP_WRITE_C:
+            emitSpill(jit, 0);
+            // Un real ubicado en el procesador ya quedo en memoria
+            emitLoadInteger(jit, REG_RSI, opcode == OP_WRITE_R ? memorySlot(instruction->a) : target);
+            emitLoadConstant(jit, REG_RDI, jit->relocatable ? opcode - OP_WRITE_I : opcode);
+            emitCall(jit, RUNTIME_WRITE);
+            emitReload(jit, 0);
+            break;
+
+        case OP_ADDK_I:
+        case OP_SUBK_I:
+            if (instruction->a == instruction->b) {
+                emitModRm(jit, 0, 0x81, 0, (int)integerImmediates[opcode - OP_ADDK_I], target);
+                emit32(jit, (unsigned int)instruction->c);
+            } else {
+                int work = targetRegister >= 0 ? targetRegister : REG_RAX;
+                emitLoadInteger(jit, work, virtualRegister(jit, instruction->b));
+                emitModRm(jit, 0, 0x81, 0, (int)integerImmediates[opcode - OP_ADDK_I], machineRegister(work));
+                emit32(jit, (unsigned int)instruction->c);
+                emitStoreInteger(jit, work, target);
+            }
+            break;
+        case OP_MULK_I: {
+            int work = targetRegister >= 0 ? targetRegister : REG_RAX;
+            emitModRm(jit, 0, 0x69, 0, work, virtualRegister(jit, instruction->b));   // imul r32, r/m32, imm32
+            emit32(jit, (unsigned int)instruction->c);
+            emitStoreInteger(jit, work, target);
+            break;
+        }
+
+        case OP_ADDK_R:
+        case OP_SUBK_R:
+        case OP_MULK_R:
+        case OP_DIVK_R: {
+            int work = targetRegister >= 0 ? targetRegister : REG_XMM0;
+            emitRealConstant(jit, REG_XMM1, instruction->c);
+            emitLoadReal(jit, work, virtualRegister(jit, instruction->b));
+            emitModRm(jit, 0xF3, realOperations[opcode - OP_ADDK_R], 0, work, machineRegister(REG_XMM1));
+            emitStoreReal(jit, work, target);
+            break;
+        }
+
+        case OP_JEQ_I:
+        case OP_JNE_I:
+        case OP_JLT_I:
+        case OP_JLE_I:
+        case OP_JGT_I:
+        case OP_JGE_I:
+            emitLoadInteger(jit, REG_RAX, virtualRegister(jit, instruction->b));
+            emitModRm(jit, 0, 0x3B, 0, REG_RAX, virtualRegister(jit, instruction->c));
+            emitJump(jit, integerConditions[opcode - OP_JEQ_I], (unsigned int)instruction->a);
+            break;
+        case OP_JEQK_I:
+        case OP_JNEK_I:
+        case OP_JLTK_I:
+        case OP_JLEK_I:
+        case OP_JGTK_I:
+        case OP_JGEK_I:
+            emitModRm(jit, 0, 0x81, 0, 7, virtualRegister(jit, instruction->b));       // cmp r/m32, imm32
+            emit32(jit, (unsigned int)instruction->c);
+            emitJump(jit, integerConditions[opcode - OP_JEQK_I], (unsigned int)instruction->a);
+            break;
+
+        default:
+            jit->failed = 1;
+            break;
+    }
+}
+
+/**
+ * Traduce el programa completo: entrada, instrucciones y salida
+ * @param jit: Traduccion en curso
+ * @param program: Programa
+ * @return: 1 si se pudo, 0 si no
+ */
+static int translateProgram(JitState* jit, const BytecodeProgram* program) {
+    static const unsigned char prologue[] = {
+        0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57,  // push rbx, rbp, r12..r15
+        0x48, 0x83, 0xEC, 0x08,                                      // sub rsp, 8 (alinea a 16)
+        0x49, 0x89, 0xFF                                             // mov r15, rdi
+    };
+    static const unsigned char epilogue[] = {
+        0x48, 0x83, 0xC4, 0x08,                                      // add rsp, 8
+        0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B,  // pop r15..r12, rbp, rbx
+        0xC3                                                         // ret
+    };
+    size_t* labels = (size_t*)malloc((program->count + 1) * sizeof(size_t));
+
+    if (labels == NULL) {
+        return 0;
+    }
+    jit->exitLabel = program->count;
+    for (size_t i = 0; i < sizeof(prologue); i++) {
+        emitByte(jit, prologue[i]);
+    }
+    emitReload(jit, 1);
+
+    for (unsigned int pc = 0; pc < program->count; pc++) {
+        labels[pc] = jit->length;
+        translateInstruction(jit, program, pc);
+    }
+
+    // Salida: deja todo en memoria (eax tiene el resultado)
+    labels[program->count] = jit->length;
+    emitSpill(jit, 1);
+    for (size_t i = 0; i < sizeof(epilogue); i++) {
+        emitByte(jit, epilogue[i]);
+    }
+
+    if (!jit->failed) {
+        for (unsigned int i = 0; i < jit->fixupCount; i++) {
+            size_t position = jit->fixups[i].position;
+            int displacement = (int)((long long)labels[jit->fixups[i].label] - (long long)(position + 4));
+            memcpy(jit->bytes + position, &displacement, sizeof(int));
+        }
+    }
+    free(labels);
+    return !jit->failed;
+}
+
+/**
+ * Traduce un programa de la maquina virtual a codigo x86-64
+ * @param program: Programa de la maquina virtual
+ * @param failureCodes: Valor que devuelve la funcion si falla cada
+ *                      instruccion (NULL = el numero de la instruccion)
+ * @param relocatable: 1 para un objeto ELF (las llamadas quedan en code->calls),
+ *                     0 para ejecutar en este proceso
+ * @param code: Resultado (liberar con releaseMachineCode)
+ * @return: 1 si se genero el codigo, 0 si falto memoria
+ */
+int generateMachineCode(const BytecodeProgram* program, const int* failureCodes, int relocatable,
+                        MachineCode* code) {
+    JitState jit;
+    int success;
+
+    memset(code, 0, sizeof(MachineCode));
+    memset(&jit, 0, sizeof(JitState));
+    jit.relocatable = relocatable;
+    jit.failureCodes = failureCodes;
+    success = allocateRegisters(&jit, program) && translateProgram(&jit, program);
+    if (success) {
+        code->bytes = jit.bytes;
+        code->length = jit.length;
+        code->calls = jit.calls;
+        code->callCount = jit.callCount;
+        code->pinnedRegisters = jit.pinnedCount;
+    } else {
+        free(jit.bytes);
+        free(jit.calls);
+    }
+    free(jit.fixups);
+    free(jit.location);
+    free(jit.classes);
+    return success;
+}
+
+/**
+ * Libera el resultado de generateMachineCode
+ * @param code: Codigo traducido
+ */
+void releaseMachineCode(MachineCode* code) {
+    free(code->bytes);
+    free(code->calls);
+    memset(code, 0, sizeof(MachineCode));
+}
+
+#if JIT_AVAILABLE
+
+/**
+ * Traduce un programa de la maquina virtual a codigo x86-64 ejecutable
+ * @param program: Programa de la maquina virtual
+ * @param native: Resultado (liberar con releaseNativeProgram)
+ * @return: 1 si se genero el codigo, 0 si no
+ */
+int compileNativeProgram(const BytecodeProgram* program, NativeProgram* native) {
+    MachineCode code;
+    int success = 0;
+
+    memset(native, 0, sizeof(NativeProgram));
+    if (!generateMachineCode(program, NULL, 0, &code)) {
+        return 0;
+    }
+
+    void* pages = mmap(NULL, code.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages != MAP_FAILED) {
+        memcpy(pages, code.bytes, code.length);
+        if (mprotect(pages, code.length, PROT_READ | PROT_EXEC) == 0) {
+            native->code = pages;
+            native->size = code.length;
+            native->program = program;
+            native->pinnedRegisters = code.pinnedRegisters;
+            success = 1;
+        } else {
+            munmap(pages, code.length);
+        }
+    }
+    releaseMachineCode(&code);
+    return success;
+}
+
+/**
+ * Ejecuta un programa traducido a codigo nativo. Las variables empiezan en
+ * cero, como en la maquina virtual.
+ * @param native: Programa de compileNativeProgram
+ * @param stats: Estadisticas (puede ser NULL); no se cuentan instrucciones
+ * @return: 1 si el programa termino, 0 si se detuvo por un error de ejecucion
+ */
+int executeNativeProgram(const NativeProgram* native, VmStats* stats) {
+    const BytecodeProgram* program = native->program;
+    void* registers = calloc(program->registerCount ? program->registerCount : 1, sizeof(int));
+    NativeEntry entry;
+
+    if (registers == NULL) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para los registros del programa\n");
+        return 0;
+    }
+
+    memcpy(&entry, &native->code, sizeof(entry));
+    int failedInstruction = entry(registers);
+    fflush(stdout);
+    if (failedInstruction >= 0) {
+        reportRuntimeError(program, (unsigned int)failedInstruction);
+    }
+    if (stats != NULL) {
+        stats->instructions = 0;
+        stats->checksum = registerChecksum(registers, program->variableCount);
+    }
+    free(registers);
+    return failedInstruction < 0;
+}
+
+/**
+ * Libera el codigo de un programa traducido
+ * @param native: Programa de compileNativeProgram
+ */
+void releaseNativeProgram(NativeProgram* native) {
+    if (native->code != NULL) {
+        munmap(native->code, native->size);
+    }
+    memset(native, 0, sizeof(NativeProgram));
+}
+
+#else
+
+int compileNativeProgram(const BytecodeProgram* program, NativeProgram* native) {
+    (void)program;
+    memset(native, 0, sizeof(NativeProgram));
+    return 0;
+}
+
+int executeNativeProgram(const NativeProgram* native, VmStats* stats) {
+    (void)native;
+    (void)stats;
+    return 0;
+}
+
+void releaseNativeProgram(NativeProgram* native) {
+    memset(native, 0, sizeof(NativeProgram));
+}
+
+#endif
+
+/**
+ * Indica si este ejecutable puede generar codigo nativo
+ * @return: 1 en Linux x86-64 compilado con GCC o Clang, 0 si no
+ */
+int nativeCodeAvailable() {
+    return JIT_AVAILABLE;
+}
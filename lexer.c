@@ -2,60 +2,278 @@
 
 /* Variables globales del analizador lexico */
 char* sourceCode = NULL;
-int currentPos = 0;
-int currentLine = 1;
-int currentColumn = 1;
+size_t sourceLength = 0;
+size_t currentPos = 0;
 Token currentToken;
 
+/* Indice de comienzos de linea: lineStarts[i] es la posicion del primer byte
+   de la linea i + 1. Se construye la primera vez que se informa una ubicacion. */
+static size_t* lineStarts = NULL;
+static size_t lineStartCount = 0;
+
+/**
+ * Clases de caracteres del automata. Cada byte de entrada se traduce a una
+ * clase mediante charClassTable y la clase indexa la tabla de transiciones.
+ */
+typedef enum {
+    CC_OTHER,      // Caracter no valido en el lenguaje
+    CC_BLANK,      // Espacio, tabulacion, retorno de carro
+    CC_NEWLINE,    // \n
+    CC_EOF,        // \0 (fin del codigo fuente)
+    CC_LETTER,     // a-z, A-Z, _
+    CC_DIGIT,      // 0-9
+    CC_DOT,        // .
+    CC_SLASH,      // /
+    CC_COLON,      // :
+    CC_LESS,       // <
+    CC_GREATER,    // >
+    CC_EQUAL,      // =
+    CC_QUOTE,      // '
+    CC_DQUOTE,     // "
+    CC_SINGLE,     // + - * % ( ) { } ; ,
+    CC_COUNT
+} CharClass;
+
+/**
+ * Estados del automata finito determinista. LEX_EMIT no es un estado real:
+ * indica que el token acumulado termina antes del caracter actual.
+ */
+typedef enum {
+    LEX_EMIT = 0,
+    LEX_START,
+    LEX_IDENT,
+    LEX_INT,
+    LEX_INT_DOT,
+    LEX_REAL,
+    LEX_SLASH,
+    LEX_COMMENT,
+    LEX_COLON,
+    LEX_ASSIGN,
+    LEX_LESS,
+    LEX_LESS_EQUAL,
+    LEX_NOT_EQUAL,
+    LEX_GREATER,
+    LEX_GREATER_EQUAL,
+    LEX_SINGLE,
+    LEX_CHAR_OPEN,
+    LEX_CHAR_BODY,
+    LEX_CHAR_CLOSED,
+    LEX_STRING,
+    LEX_STRING_CLOSED,
+    LEX_UNKNOWN,
+    LEX_STATE_COUNT
+} LexerState;
+
+/* Tabla de clases de caracteres (se completa una sola vez en initLexerTables) */
+static unsigned char charClassTable[256];
+static int lexerTablesReady = 0;
+
+/* Tipo de token de cada operador o delimitador de un caracter */
+static const unsigned char singleCharTokens[128] = {
+    ['+'] = TOKEN_PLUS,
+    ['-'] = TOKEN_MINUS,
+    ['*'] = TOKEN_MULTIPLY,
+    ['%'] = TOKEN_MOD,
+    ['='] = TOKEN_EQUAL,
+    ['('] = TOKEN_LPAREN,
+    [')'] = TOKEN_RPAREN,
+    ['{'] = TOKEN_LBRACE,
+    ['}'] = TOKEN_RBRACE,
+    [';'] = TOKEN_SEMICOLON,
+    [','] = TOKEN_COMMA
+};
+
+/* Tipo de token que se acepta al terminar en cada estado */
+static const unsigned char stateTokenTypes[LEX_STATE_COUNT] = {
+    [LEX_START] = TOKEN_EOF,
+    [LEX_IDENT] = TOKEN_IDENTIFIER,
+    [LEX_INT] = TOKEN_NUMBER,
+    [LEX_INT_DOT] = TOKEN_REAL_LITERAL,
+    [LEX_REAL] = TOKEN_REAL_LITERAL,
+    [LEX_SLASH] = TOKEN_DIVIDE,
+    [LEX_COMMENT] = TOKEN_EOF,
+    [LEX_COLON] = TOKEN_ERROR,
+    [LEX_ASSIGN] = TOKEN_ASSIGN,
+    [LEX_LESS] = TOKEN_LESS,
+    [LEX_LESS_EQUAL] = TOKEN_LESS_EQUAL,
+    [LEX_NOT_EQUAL] = TOKEN_NOT_EQUAL,
+    [LEX_GREATER] = TOKEN_GREATER,
+    [LEX_GREATER_EQUAL] = TOKEN_GREATER_EQUAL,
+    [LEX_SINGLE] = TOKEN_ERROR,
+    [LEX_CHAR_OPEN] = TOKEN_ERROR,
+    [LEX_CHAR_BODY] = TOKEN_ERROR,
+    [LEX_CHAR_CLOSED] = TOKEN_CHAR_LITERAL,
+    [LEX_STRING] = TOKEN_ERROR,
+    [LEX_STRING_CLOSED] = TOKEN_STRING_LITERAL,
+    [LEX_UNKNOWN] = TOKEN_ERROR
+};
+
+/* Filas de la tabla para estados que consumen todo salvo comillas dobles, fin de linea o archivo */
+#define LEX_ROW_UNTIL_EOL(state) \
+    [CC_OTHER] = state, [CC_BLANK] = state, [CC_LETTER] = state, [CC_DIGIT] = state, \
+    [CC_DOT] = state, [CC_SLASH] = state, [CC_COLON] = state, [CC_LESS] = state, \
+    [CC_GREATER] = state, [CC_EQUAL] = state, [CC_QUOTE] = state, [CC_SINGLE] = state
+
+/**
+ * Tabla de transiciones: transitionTable[estado][clase] = siguiente estado.
+ * Las celdas no listadas valen LEX_EMIT (fin del token actual).
+ */
+static const unsigned char transitionTable[LEX_STATE_COUNT][CC_COUNT] = {
+    [LEX_START] = {
+        [CC_OTHER] = LEX_UNKNOWN, [CC_BLANK] = LEX_START, [CC_NEWLINE] = LEX_START,
+        [CC_LETTER] = LEX_IDENT, [CC_DIGIT] = LEX_INT, [CC_DOT] = LEX_UNKNOWN,
+        [CC_SLASH] = LEX_SLASH, [CC_COLON] = LEX_COLON, [CC_LESS] = LEX_LESS,
+        [CC_GREATER] = LEX_GREATER, [CC_EQUAL] = LEX_SINGLE, [CC_QUOTE] = LEX_CHAR_OPEN,
+        [CC_DQUOTE] = LEX_STRING, [CC_SINGLE] = LEX_SINGLE
+    },
+    [LEX_IDENT] = { [CC_LETTER] = LEX_IDENT, [CC_DIGIT] = LEX_IDENT },
+    [LEX_INT] = { [CC_DIGIT] = LEX_INT, [CC_DOT] = LEX_INT_DOT },
+    [LEX_INT_DOT] = { [CC_DIGIT] = LEX_REAL },
+    [LEX_REAL] = { [CC_DIGIT] = LEX_REAL },
+    [LEX_SLASH] = { [CC_SLASH] = LEX_COMMENT },
+    [LEX_COMMENT] = { LEX_ROW_UNTIL_EOL(LEX_COMMENT), [CC_DQUOTE] = LEX_COMMENT, [CC_NEWLINE] = LEX_START },
+    [LEX_COLON] = { [CC_EQUAL] = LEX_ASSIGN },
+    [LEX_LESS] = { [CC_EQUAL] = LEX_LESS_EQUAL, [CC_GREATER] = LEX_NOT_EQUAL },
+    [LEX_GREATER] = { [CC_EQUAL] = LEX_GREATER_EQUAL },
+    [LEX_CHAR_OPEN] = { LEX_ROW_UNTIL_EOL(LEX_CHAR_BODY), [CC_DQUOTE] = LEX_CHAR_BODY },
+    [LEX_CHAR_BODY] = { [CC_QUOTE] = LEX_CHAR_CLOSED },
+    [LEX_STRING] = { LEX_ROW_UNTIL_EOL(LEX_STRING), [CC_DQUOTE] = LEX_STRING_CLOSED }
+};
+
+/**
+ * Construye las tablas del automata (clases de caracteres y transiciones)
+ */
+static void initLexerTables() {
+    int c;
+
+    for (c = 0; c < 256; c++) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') charClassTable[c] = CC_LETTER;
+        else if (c >= '0' && c <= '9') charClassTable[c] = CC_DIGIT;
+        else if (c < 128 && singleCharTokens[c] != 0) charClassTable[c] = CC_SINGLE;
+        else charClassTable[c] = CC_OTHER;
+    }
+
+    charClassTable[' '] = CC_BLANK;
+    charClassTable['\t'] = CC_BLANK;
+    charClassTable['\r'] = CC_BLANK;
+    charClassTable['\n'] = CC_NEWLINE;
+    charClassTable['\0'] = CC_EOF;
+    charClassTable['.'] = CC_DOT;
+    charClassTable['/'] = CC_SLASH;
+    charClassTable[':'] = CC_COLON;
+    charClassTable['<'] = CC_LESS;
+    charClassTable['>'] = CC_GREATER;
+    charClassTable['='] = CC_EQUAL;
+    charClassTable['\''] = CC_QUOTE;
+    charClassTable['"'] = CC_DQUOTE;
+
+    initScanKernels();
+    lexerTablesReady = 1;
+}
+
 /**
  * Inicializa el analizador lexico con el codigo fuente proporcionado
- * @param code: Cadena de caracteres que contiene el codigo fuente a analizar
+ * @param code: Codigo fuente a analizar (seguido de SOURCE_PADDING bytes en cero)
+ * @param length: Longitud del codigo fuente en bytes
  */
-void initLexer(char* code) {
+void initLexer(char* code, size_t length) {
+    if (!lexerTablesReady) {
+        initLexerTables();
+    }
+
+    releaseLineIndex();
+    resetInternTable(&identifierNames);
     sourceCode = code;
+    sourceLength = length;
     currentPos = 0;
-    currentLine = 1;
-    currentColumn = 1;
     currentToken = getNextToken();
 }
 
+/* Limites de longitud de las palabras reservadas ("y" ... "caracter") */
+#define KEYWORD_MIN_LENGTH 1
+#define KEYWORD_MAX_LENGTH 8
+#define KEYWORD_TABLE_SIZE 32
+
 /**
- * Verifica si una palabra es una palabra reservada del lenguaje
- * @param word: Palabra a verificar
- * @return: Tipo de token correspondiente o TOKEN_IDENTIFIER si no es palabra reservada
+ * Funcion de hash perfecta para las palabras reservadas. Usa el primer y el
+ * ultimo caracter y la longitud; las constantes se eligieron por busqueda
+ * exhaustiva para que las 13 palabras caigan en posiciones distintas.
  */
-int isKeyword(char* word) {
+#define KEYWORD_HASH(first, last, length) \
+    ((((unsigned)(first)) * 2u + ((unsigned)(last)) * 11u + (unsigned)(length)) & (KEYWORD_TABLE_SIZE - 1))
+
+/* Entrada de la tabla de palabras reservadas */
+typedef struct {
+    const char* word;
+    unsigned char length;
+    unsigned char type;
+} KeywordEntry;
+
+/* Tabla de palabras reservadas indexada por KEYWORD_HASH (sin colisiones) */
+static const KeywordEntry keywordTable[KEYWORD_TABLE_SIZE] = {
     // Tipos de datos
-    if (strcmp(word, "entero") == 0) return TOKEN_ENTERO;
-    if (strcmp(word, "caracter") == 0) return TOKEN_CARACTER;
-    if (strcmp(word, "real") == 0) return TOKEN_REAL;
-    
+    [KEYWORD_HASH('e', 'o', 6)] = {"entero", 6, TOKEN_ENTERO},
+    [KEYWORD_HASH('c', 'r', 8)] = {"caracter", 8, TOKEN_CARACTER},
+    [KEYWORD_HASH('r', 'l', 4)] = {"real", 4, TOKEN_REAL},
+
     // Estructuras de control
-    if (strcmp(word, "si") == 0) return TOKEN_SI;
-    if (strcmp(word, "sino") == 0) return TOKEN_SINO;
-    if (strcmp(word, "mientras") == 0) return TOKEN_MIENTRAS;
-    if (strcmp(word, "repetir") == 0) return TOKEN_REPETIR;    // parte inicial de 'repetir hasta'
-    if (strcmp(word, "hasta") == 0) return TOKEN_HASTA;        // parte final de 'repetir hasta'
-    
+    [KEYWORD_HASH('s', 'i', 2)] = {"si", 2, TOKEN_SI},
+    [KEYWORD_HASH('s', 'o', 4)] = {"sino", 4, TOKEN_SINO},
+    [KEYWORD_HASH('m', 's', 8)] = {"mientras", 8, TOKEN_MIENTRAS},
+    [KEYWORD_HASH('r', 'r', 7)] = {"repetir", 7, TOKEN_REPETIR},    // parte inicial de 'repetir hasta'
+    [KEYWORD_HASH('h', 'a', 5)] = {"hasta", 5, TOKEN_HASTA},        // parte final de 'repetir hasta'
+
     // Entrada/Salida
-    if (strcmp(word, "leer") == 0) return TOKEN_LEER;
-    if (strcmp(word, "escribir") == 0) return TOKEN_ESCRIBIR;
-    
+    [KEYWORD_HASH('l', 'r', 4)] = {"leer", 4, TOKEN_LEER},
+    [KEYWORD_HASH('e', 'r', 8)] = {"escribir", 8, TOKEN_ESCRIBIR},
+
     // Operadores logicos
-    if (strcmp(word, "y") == 0) return TOKEN_AND;
-    if (strcmp(word, "o") == 0) return TOKEN_OR;
-    if (strcmp(word, "no") == 0) return TOKEN_NOT;
-    
+    [KEYWORD_HASH('y', 'y', 1)] = {"y", 1, TOKEN_AND},
+    [KEYWORD_HASH('o', 'o', 1)] = {"o", 1, TOKEN_OR},
+    [KEYWORD_HASH('n', 'o', 2)] = {"no", 2, TOKEN_NOT}
+};
+
+/**
+ * Busca una palabra reservada mediante la tabla de hash perfecto.
+ * Las longitudes fuera de rango se descartan sin calcular el hash y la
+ * busqueda termina con una unica comparacion.
+ * @param word: Inicio de la palabra (no necesita terminar en '\0')
+ * @param length: Longitud de la palabra
+ * @return: Tipo de token correspondiente o TOKEN_IDENTIFIER si no es palabra reservada
+ */
+int lookupKeyword(const char* word, int length) {
+    if (length < KEYWORD_MIN_LENGTH || length > KEYWORD_MAX_LENGTH) {
+        return TOKEN_IDENTIFIER;
+    }
+
+    const KeywordEntry* entry = &keywordTable[KEYWORD_HASH((unsigned char)word[0],
+                                                           (unsigned char)word[length - 1], length)];
+    if (entry->length == length && memcmp(entry->word, word, length) == 0) {
+        return entry->type;
+    }
+
     return TOKEN_IDENTIFIER;
 }
 
+/**
+ * Verifica si una palabra es una palabra reservada del lenguaje
+ * @param word: Palabra a verificar
+ * @return: Tipo de token correspondiente o TOKEN_IDENTIFIER si no es palabra reservada
+ */
+int isKeyword(char* word) {
+    return lookupKeyword(word, (int)strlen(word));
+}
+
 /**
  * Verifica si un caracter es una letra
  * @param c: Caracter a verificar
  * @return: 1 si es letra, 0 en caso contrario
  */
 int isLetter(char c) {
-    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    if (!lexerTablesReady) {
+        initLexerTables();
+    }
+    return charClassTable[(unsigned char)c] == CC_LETTER;
 }
 
 /**
@@ -68,407 +286,279 @@ int isDigit(char c) {
 }
 
 /**
- * Omite espacios en blanco, tabulaciones y saltos de linea
+ * Obtiene el texto de un token dentro del codigo fuente
+ * @param token: Token a consultar
+ * @return: Puntero al primer caracter del lexema (no termina en '\0')
  */
-void skipWhitespace() {
-    while (sourceCode[currentPos] == ' ' || sourceCode[currentPos] == '\t' || 
-           sourceCode[currentPos] == '\n' || sourceCode[currentPos] == '\r') {
-        if (sourceCode[currentPos] == '\n') {
-            currentLine++;
-            currentColumn = 1;
-        } else {
-            currentColumn++;
-        }
-        currentPos++;
-    }
+const char* getTokenText(Token token) {
+    return &sourceCode[token.offset];
 }
 
 /**
- * Omite comentarios de linea que comienzan con //
+ * Construye el indice de comienzos de linea recorriendo el codigo fuente con
+ * el nucleo vectorizado que busca saltos de linea. El indice vive en la arena
+ * de la compilacion.
+ * @return: 1 si el indice quedo listo, 0 si no hubo memoria
  */
-void skipComment() {
-    if (sourceCode[currentPos] == '/' && sourceCode[currentPos + 1] == '/') {
-        while (sourceCode[currentPos] != '\n' && sourceCode[currentPos] != '\0') {
-            currentPos++;
-        }
-    }
-}
+static int buildLineIndex() {
+    size_t capacity = 1024;
+    size_t pos = 0;
 
-/**
- * Procesa identificadores y palabras reservadas
- * @return: Token de identificador o palabra reservada
- */
-Token processIdentifier() {
-    Token token;
-    token.line = currentLine;
-    token.column = currentColumn;
-    
-    int start = currentPos;
-    while (isLetter(sourceCode[currentPos]) || isDigit(sourceCode[currentPos])) {
-        currentPos++;
-        currentColumn++;
+    lineStarts = (size_t*)arenaAlloc(&compilationArena, capacity * sizeof(size_t));
+    if (lineStarts == NULL) {
+        return 0;
     }
-    
-    int length = currentPos - start;
-    strncpy(token.lexeme, &sourceCode[start], length);
-    token.lexeme[length] = '\0';
-    
-    token.type = isKeyword(token.lexeme);
-    return token;
-}
+    lineStarts[0] = 0;
+    lineStartCount = 1;
 
-/**
- * Procesa numeros enteros y reales
- * @return: Token numerico (entero o real)
- */
-Token processNumber() {
-    Token token;
-    token.line = currentLine;
-    token.column = currentColumn;
-    
-    int start = currentPos;
-    int hasDecimal = 0;
-    
-    // Procesar parte entera
-    while (isDigit(sourceCode[currentPos])) {
-        currentPos++;
-        currentColumn++;
-    }
-    
-    // Verificar si tiene parte decimal
-    if (sourceCode[currentPos] == '.') {
-        hasDecimal = 1;
-        currentPos++;
-        currentColumn++;
-        
-        // Procesar parte decimal
-        while (isDigit(sourceCode[currentPos])) {
-            currentPos++;
-            currentColumn++;
+    for (;;) {
+        pos = scanKernels.findLineEnd(sourceCode, pos);
+        if (pos >= sourceLength) {
+            break;
         }
+        if (sourceCode[pos] == '\n') {
+            if (lineStartCount == capacity) {
+                size_t* grown = (size_t*)arenaResize(&compilationArena, lineStarts, capacity * sizeof(size_t),
+                                                     capacity * 2 * sizeof(size_t));
+                if (grown == NULL) {
+                    releaseLineIndex();
+                    return 0;
+                }
+                lineStarts = grown;
+                capacity *= 2;
+            }
+            lineStarts[lineStartCount++] = pos + 1;
+        }
+        pos++; // Salto de linea o '\0' dentro del archivo
     }
-    
-    int length = currentPos - start;
-    strncpy(token.lexeme, &sourceCode[start], length);
-    token.lexeme[length] = '\0';
-    
-    if (hasDecimal) {
-        token.type = TOKEN_REAL_LITERAL;
-        token.value.realValue = atof(token.lexeme);
-    } else {
-        token.type = TOKEN_NUMBER;
-        token.value.intValue = atoi(token.lexeme);
-    }
-    
-    return token;
+    return 1;
 }
 
 /**
- * Procesa caracteres literales entre comillas simples
- * @return: Token de caracter literal o error
+ * Busca la linea que contiene una posicion del codigo fuente (busqueda binaria)
+ * @param offset: Posicion en sourceCode
+ * @return: Indice de la linea en lineStarts (comenzando en 0), o -1 sin indice
  */
-Token processCharLiteral() {
-    Token token;
-    token.line = currentLine;
-    token.column = currentColumn;
-    
-    currentPos++; // Saltar comilla inicial
-    currentColumn++;
-    
-    if (sourceCode[currentPos] == '\0' || sourceCode[currentPos] == '\n') {
-        token.type = TOKEN_ERROR;
-        strcpy(token.lexeme, "ERROR: Caracter literal no cerrado");
-        return token;
+static long findLineOfOffset(size_t offset) {
+    if (lineStarts == NULL && !buildLineIndex()) {
+        return -1;
     }
-    
-    token.value.charValue = sourceCode[currentPos];
-    sprintf(token.lexeme, "'%c'", token.value.charValue);
-    currentPos++;
-    currentColumn++;
-    
-    if (sourceCode[currentPos] != '\'') {
-        token.type = TOKEN_ERROR;
-        strcpy(token.lexeme, "ERROR: Caracter literal no cerrado");
-        return token;
+
+    size_t low = 0;
+    size_t high = lineStartCount;
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if (lineStarts[middle] <= offset) {
+            low = middle;
+        } else {
+            high = middle;
+        }
     }
-    
-    currentPos++; // Saltar comilla final
-    currentColumn++;
-    token.type = TOKEN_CHAR_LITERAL;
-    return token;
+    return (long)low;
 }
 
 /**
- * Procesa cadenas literales entre comillas dobles
- * @return: Token de cadena literal o error
+ * Calcula la linea de un token. Solo se usa al informar diagnosticos, por eso
+ * el lexer no cuenta lineas y se resuelve aqui con el indice de lineas.
+ * @param token: Token a ubicar
+ * @return: Linea del token (comenzando en 1)
  */
-Token processStringLiteral() {
-    Token token;
-    token.line = currentLine;
-    token.column = currentColumn;
-    
-    int start = currentPos;
-    currentPos++; // Saltar comilla inicial
-    currentColumn++;
-    
-    while (sourceCode[currentPos] != '"' && sourceCode[currentPos] != '\0' && sourceCode[currentPos] != '\n') {
-        currentPos++;
-        currentColumn++;
-    }
-    
-    if (sourceCode[currentPos] != '"') {
-        token.type = TOKEN_ERROR;
-        strcpy(token.lexeme, "ERROR: Cadena literal no cerrada");
-        return token;
-    }
-    
-    currentPos++; // Saltar comilla final
-    currentColumn++;
-    
-    int length = currentPos - start;
-    strncpy(token.lexeme, &sourceCode[start], length);
-    token.lexeme[length] = '\0';
-    
-    token.type = TOKEN_STRING_LITERAL;
-    return token;
+int getTokenLine(Token token) {
+    return (int)(findLineOfOffset(token.offset) + 1);
 }
 
 /**
- * Procesa operadores de dos caracteres
- * @return: Token de operador de dos caracteres o TOKEN_ERROR si no es valido
+ * Calcula la columna de un token a partir del comienzo de su linea
+ * @param token: Token a ubicar
+ * @return: Columna del token (comenzando en 1)
  */
-Token processTwoCharOperator() {
-    Token token;
-    token.line = currentLine;
-    token.column = currentColumn;
-    
-    char first = sourceCode[currentPos];
-    char second = sourceCode[currentPos + 1];
-    
-    if (first == ':' && second == '=') {
-        token.type = TOKEN_ASSIGN;
-        strcpy(token.lexeme, ":=");
-    } else if (first == '<' && second == '>') {
-        token.type = TOKEN_NOT_EQUAL;
-        strcpy(token.lexeme, "<>");
-    } else if (first == '<' && second == '=') {
-        token.type = TOKEN_LESS_EQUAL;
-        strcpy(token.lexeme, "<=");
-    } else if (first == '>' && second == '=') {
-        token.type = TOKEN_GREATER_EQUAL;
-        strcpy(token.lexeme, ">=");
+int getTokenColumn(Token token) {
+    long line = findLineOfOffset(token.offset);
+    size_t lineStart = 0;
+
+    if (line >= 0) {
+        lineStart = lineStarts[line];
     } else {
-        token.type = TOKEN_ERROR;
-        strcpy(token.lexeme, "ERROR: Operador no valido");
-    }
-    
-    if (token.type != TOKEN_ERROR) {
-        currentPos += 2;
-        currentColumn += 2;
+        // Sin memoria para el indice: se retrocede hasta el salto de linea anterior
+        lineStart = token.offset;
+        while (lineStart > 0 && sourceCode[lineStart - 1] != '\n') {
+            lineStart--;
+        }
     }
-    
-    return token;
+    return (int)(token.offset - lineStart + 1);
 }
 
 /**
- * Crea un token con informacion basica
- * @param type: Tipo del token
- * @param lexeme: Lexema del token
- * @return: Token creado
+ * Descarta el indice de lineas (se reconstruye al informar la proxima
+ * ubicacion; la memoria vuelve con la arena de la compilacion)
  */
-Token createBasicToken(TokenType type, char* lexeme) {
-    Token token;
-    token.type = type;
-    token.line = currentLine;
-    token.column = currentColumn;
-    strcpy(token.lexeme, lexeme);
-    return token;
+void releaseLineIndex() {
+    lineStarts = NULL;
+    lineStartCount = 0;
 }
 
 /**
- * Procesa operadores aritméticos
- * @param currentChar: Carácter actual
- * @param token: Token a modificar
- * @return: 1 si fue procesado, 0 si no
+ * Convierte una secuencia de digitos del codigo fuente a entero
+ * @param text: Primer digito
+ * @param length: Cantidad de digitos
+ * @return: Valor entero
  */
-int processArithmeticOperator(char currentChar, Token* token) {
-    if (currentChar == '+') {
-        *token = createBasicToken(TOKEN_PLUS, "+");
-        return 1;
-    }
-    if (currentChar == '-') {
-        *token = createBasicToken(TOKEN_MINUS, "-");
-        return 1;
-    }
-    if (currentChar == '*') {
-        *token = createBasicToken(TOKEN_MULTIPLY, "*");
-        return 1;
-    }
-    if (currentChar == '/') {
-        *token = createBasicToken(TOKEN_DIVIDE, "/");
-        return 1;
-    }
-    if (currentChar == '%') {
-        *token = createBasicToken(TOKEN_MOD, "%");
-        return 1;
+static int parseIntegerSlice(const char* text, int length) {
+    unsigned int value = 0;
+    for (int i = 0; i < length; i++) {
+        value = value * 10u + (unsigned int)(text[i] - '0');
     }
-    return 0;
+    return (int)value;
 }
 
 /**
- * Procesa operadores relacionales
- * @param currentChar: Carácter actual
- * @param token: Token a modificar
- * @return: 1 si fue procesado, 0 si no
+ * Convierte un numero real del codigo fuente (digitos '.' digitos)
+ * @param text: Primer caracter del numero
+ * @param length: Longitud del numero
+ * @return: Valor real
  */
-int processRelationalOperator(char currentChar, Token* token) {
-    if (currentChar == '=') {
-        *token = createBasicToken(TOKEN_EQUAL, "=");
-        return 1;
-    }
-    if (currentChar == '<') {
-        *token = createBasicToken(TOKEN_LESS, "<");
-        return 1;
+static float parseRealSlice(const char* text, int length) {
+    double value = 0.0, scale = 1.0;
+    int i = 0;
+
+    while (i < length && text[i] != '.') {
+        value = value * 10.0 + (text[i] - '0');
+        i++;
     }
-    if (currentChar == '>') {
-        *token = createBasicToken(TOKEN_GREATER, ">");
-        return 1;
+    for (i++; i < length; i++) {
+        scale /= 10.0;
+        value += (text[i] - '0') * scale;
     }
-    return 0;
+    return (float)value;
 }
 
 /**
- * Procesa delimitadores
- * @param currentChar: Carácter actual
- * @param token: Token a modificar
- * @return: 1 si fue procesado, 0 si no
+ * Completa el token aceptado por el automata segun el estado final.
+ * El lexema queda referenciado por posicion y longitud; solo los literales
+ * calculan su valor.
+ * @param token: Token a completar
+ * @param state: Estado en el que termino el automata
+ * @param start: Posicion inicial del lexema
+ * @param cursor: Recorrido ubicado al final del lexema
  */
-int processDelimiter(char currentChar, Token* token) {
-    if (currentChar == '(') {
-        *token = createBasicToken(TOKEN_LPAREN, "(");
-        return 1;
-    }
-    if (currentChar == ')') {
-        *token = createBasicToken(TOKEN_RPAREN, ")");
-        return 1;
-    }
-    if (currentChar == '{') {
-        *token = createBasicToken(TOKEN_LBRACE, "{");
-        return 1;
-    }
-    if (currentChar == '}') {
-        *token = createBasicToken(TOKEN_RBRACE, "}");
-        return 1;
-    }
-    if (currentChar == ';') {
-        *token = createBasicToken(TOKEN_SEMICOLON, ";");
-        return 1;
-    }
-    if (currentChar == ',') {
-        *token = createBasicToken(TOKEN_COMMA, ",");
-        return 1;
+static void finishToken(Token* token, LexerState state, size_t start, LexerCursor* cursor) {
+    token->type = stateTokenTypes[state];
+    token->offset = start;
+    token->length = (int)(cursor->pos - start);
+    token->value.intValue = 0;
+
+    switch (state) {
+        case LEX_START:
+        case LEX_COMMENT:
+            if (cursor->pos < sourceLength) {
+                // '\0' dentro del archivo: no es el fin del codigo fuente
+                token->type = TOKEN_ERROR;
+                token->offset = cursor->pos++;
+                token->length = 1;
+                token->value.intValue = LEXICAL_ERROR_UNKNOWN_CHAR;
+            }
+            break;
+        case LEX_IDENT:
+            token->type = lookupKeyword(&sourceCode[start], token->length);
+            if (token->type == TOKEN_IDENTIFIER) {
+                token->value.intValue = internName(cursor->names, start, token->length);
+            }
+            break;
+        case LEX_INT:
+            token->value.intValue = parseIntegerSlice(&sourceCode[start], token->length);
+            break;
+        case LEX_INT_DOT:
+        case LEX_REAL:
+            token->value.realValue = parseRealSlice(&sourceCode[start], token->length);
+            break;
+        case LEX_SINGLE:
+            token->type = singleCharTokens[(unsigned char)sourceCode[start]];
+            break;
+        case LEX_CHAR_CLOSED:
+            token->value.charValue = sourceCode[start + 1];
+            break;
+        case LEX_CHAR_OPEN:
+        case LEX_CHAR_BODY:
+            token->value.intValue = LEXICAL_ERROR_UNCLOSED_CHAR;
+            break;
+        case LEX_STRING:
+            token->value.intValue = LEXICAL_ERROR_UNCLOSED_STRING;
+            break;
+        case LEX_COLON:
+        case LEX_UNKNOWN:
+            token->value.intValue = LEXICAL_ERROR_UNKNOWN_CHAR;
+            break;
+        default:
+            break;
     }
-    return 0;
 }
 
 /**
- * Procesa operadores de un carácter
- * @param currentChar: Carácter actual
- * @return: Token de operador de un carácter
+ * Obtiene el siguiente token del código fuente recorriendo el automata:
+ * cada caracter cuesta una busqueda en la tabla de clases y otra en la de
+ * transiciones. Espacios, saltos de linea y comentarios vuelven al estado
+ * inicial sin producir token. Al entrar en un estado que se repite sobre
+ * si mismo (blancos, comentario, identificador, numero) la corrida completa
+ * se salta con los nucleos vectorizados de scan.c.
+ * Solo lee el codigo fuente y el recorrido recibido, por lo que varios hilos
+ * pueden analizar partes distintas del mismo codigo a la vez.
+ * @param cursor: Recorrido a avanzar (posicion y linea actual)
+ * @return: Token obtenido del análisis léxico
  */
-Token processSingleCharOperator(char currentChar) {
+Token scanToken(LexerCursor* cursor) {
     Token token;
-    token.line = currentLine;
-    token.column = currentColumn;
-    
-    // Intentar procesar operadores aritméticos
-    if (processArithmeticOperator(currentChar, &token)) {
-        currentPos++;
-        currentColumn++;
-        return token;
-    }
-    
-    // Intentar procesar operadores relacionales
-    if (processRelationalOperator(currentChar, &token)) {
-        currentPos++;
-        currentColumn++;
-        return token;
+    const unsigned char* text = (const unsigned char*)sourceCode;
+    size_t pos = cursor->pos;
+    size_t start = pos;
+    LexerState state = LEX_START;
+
+    for (;;) {
+        unsigned char c = text[pos];
+        LexerState next = (LexerState)transitionTable[state][charClassTable[c]];
+
+        if (next == LEX_EMIT) {
+            break;
+        }
+
+        pos++;
+        switch (next) {
+            case LEX_START:
+                // Se descarto un blanco o el fin de un comentario
+                pos = scanKernels.skipBlanks(sourceCode, pos);
+                start = pos;
+                break;
+            case LEX_IDENT:
+                pos = scanKernels.skipIdentifier(sourceCode, pos);
+                break;
+            case LEX_INT:
+            case LEX_REAL:
+                pos = scanKernels.skipDigits(sourceCode, pos);
+                break;
+            case LEX_COMMENT:
+                pos = scanKernels.findLineEnd(sourceCode, pos);
+                break;
+            default:
+                break;
+        }
+        state = next;
     }
-    
-    // Intentar procesar delimitadores
-    if (processDelimiter(currentChar, &token)) {
-        currentPos++;
-        currentColumn++;
-        return token;
+
+    if (state == LEX_COMMENT) {
+        start = pos; // Comentario final: el EOF se ubica al terminar el comentario
     }
-    
-    // Carácter desconocido
-    token.type = TOKEN_ERROR;
-    sprintf(token.lexeme, "ERROR: Carácter desconocido '%c'", currentChar);
-    currentPos++;
-    currentColumn++;
-    return token;
-}
 
-/**
- * Verifica si el carácter actual inicia un operador de dos caracteres
- * @param currentChar: Carácter actual
- * @return: 1 si puede ser operador de dos caracteres, 0 en caso contrario
- */
-int isTwoCharOperatorStart(char currentChar) {
-    return (currentChar == ':' && sourceCode[currentPos + 1] == '=') ||
-           (currentChar == '<' && (sourceCode[currentPos + 1] == '>' || sourceCode[currentPos + 1] == '=')) ||
-           (currentChar == '>' && sourceCode[currentPos + 1] == '=');
+    cursor->pos = pos;
+    finishToken(&token, state, start, cursor);
+    return token;
 }
 
 /**
- * Obtiene el siguiente token del código fuente
+ * Obtiene el siguiente token del analisis secuencial (currentPos)
  * @return: Token obtenido del análisis léxico
  */
 Token getNextToken() {
-    Token token;
-    
-    // Omitir espacios en blanco y comentarios
-    skipWhitespace();
-    skipComment();
-    skipWhitespace();
-    
-    // Verificar fin de archivo
-    if (sourceCode[currentPos] == '\0') {
-        token.type = TOKEN_EOF;
-        token.line = currentLine;
-        token.column = currentColumn;
-        strcpy(token.lexeme, "EOF");
-        return token;
-    }
-    
-    char currentChar = sourceCode[currentPos];
-    
-    // Identificadores y palabras reservadas
-    if (isLetter(currentChar)) {
-        return processIdentifier();
-    }
-    
-    // Números (enteros y reales)
-    if (isDigit(currentChar)) {
-        return processNumber();
-    }
-    
-    // Caracteres literales
-    if (currentChar == '\'') {
-        return processCharLiteral();
-    }
-    
-    // Cadenas literales
-    if (currentChar == '"') {
-        return processStringLiteral();
-    }
-    
-    // Operadores de dos caracteres
-    if (isTwoCharOperatorStart(currentChar)) {
-        return processTwoCharOperator();
-    }
-    
-    // Operadores de un carácter
-    return processSingleCharOperator(currentChar);
-}
\ No newline at end of file
+    LexerCursor cursor = {currentPos, &identifierNames};
+    Token token = scanToken(&cursor);
+    currentPos = cursor.pos;
+    return token;
+}
@@ -8,10 +8,11 @@ void printSymbolTable() {
     printf("%-15s %-10s %-12s %-10s\n", "Nombre", "Tipo", "Inicializada", "Valor");
     printf("------------------------------------------------\n");
     
-    Symbol* current = symbolTable;
     int total = 0, initialized = 0;
     
-    while (current != NULL) {
+    // Del ultimo declarado al primero
+    for (int i = symbolTable.count - 1; i >= 0; i--) {
+        Symbol* current = &symbolTable.entries[i];
         char typeStr[15], valueStr[20];
         dataTypeToString(current->type, typeStr);
         formatSymbolValue(current, valueStr);
@@ -22,7 +23,6 @@ void printSymbolTable() {
         
         total++;
         if (current->initialized) initialized++;
-        current = current->next;
     }
     
     printf("================================================\n");
@@ -31,63 +31,21 @@ void printSymbolTable() {
 }
 
 /**
- * Libera la memoria y reinicia el compilador
+ * Libera la memoria y reinicia el compilador. Los bloques de las arenas se
+ * conservan para la proxima compilacion.
  */
 void cleanup() {
-    int count = 0;
-    Symbol* current = symbolTable;
-    
-    // Liberar todos los simbolos de la lista enlazada
-    while (current != NULL) {
-        Symbol* next = current->next;
-        if (current != NULL) free(current);
-        current = next;
-        count++;
-    }
+    int count = symbolTable.count;
     
     // Reiniciar todas las variables globales
-    symbolTable = NULL;
+    releaseSymbolTable();
     currentPos = 0;
-    currentLine = 1;
-    currentColumn = 1;
     hasError = 0;
+    releaseLineIndex();
+    resetInternTable(&identifierNames);
+    resetArena(&compilationArena);
     
-    printf("Memoria liberada correctamente (%d simbolos).\n", count);
-}
-
-/**
- * Lee un archivo de codigo fuente
- * @param filename: Nombre del archivo a leer
- * @return: Contenido del archivo o NULL si hay error
- */
-char* readSourceFile(char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        printf("ERROR: No se pudo abrir el archivo '%s'\n", filename);
-        return NULL;
-    }
-    
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    char* content = (char*)malloc(fileSize + 1);
-    if (!content) {
-        printf("ERROR: No se pudo asignar memoria para el archivo\n");
-        fclose(file);
-        return NULL;
-    }
-    
-    size_t bytesRead = fread(content, 1, fileSize, file);
-    content[bytesRead] = '\0';
-    fclose(file);
-    
-    // Verificar si la lectura fue exitosa
-    if (bytesRead == 0 && fileSize > 0) {
-        printf("ADVERTENCIA: El archivo parece estar vacio o hubo error al leer\n");
-    }
-    
-    return content;
+    if (progressMessages) printf("Memoria liberada correctamente (%d simbolos).\n", count);
 }
 
 /**
@@ -133,19 +91,44 @@ char* getExampleSourceCode() {
 
 /**
  * Inicializa compilador y muestra resultados
- * @param sourceCode: Codigo fuente a procesar
+ * @param source: Codigo fuente a procesar
+ * @param options: Opciones de linea de comandos (modo del analisis lexico)
  * @return: 1 si la compilacion fue exitosa, 0 en caso contrario
  */
-int compileAndShowResults(char* sourceCode) {
-    if (!sourceCode) {
+int compileAndShowResults(SourceBuffer* source, CompilerOptions* options) {
+    TokenArray tokens;
+    TokenPipeline* pipeline = NULL;
+
+    if (!source || !source->data) {
         printf("ERROR: Codigo fuente es NULL\n");
         return 0;
     }
     
+    memset(&tokens, 0, sizeof(TokenArray));
     initSemantic();
     initParser();
-    initLexer(sourceCode);
+    maxErrors = options->maxErrors;
+    if (options->threadCount >= 0) {
+        // Todos los tokens se reconocen antes de analizar la sintaxis
+        if (!tokenizeSource(source, options->threadCount, &tokens)) {
+            return 0;
+        }
+        useTokenStream(&tokens);
+    } else if (options->pipeline && (pipeline = startTokenPipeline(source)) != NULL) {
+        useTokenPipeline(pipeline);
+    } else {
+        initLexer(source->data, source->length);
+    }
     parseProgram();
+    stopTokenPipeline(pipeline);
+    freeTokenArray(&tokens);
+
+    // Con el arbol completo y sin errores: grafo de flujo, codigo inalcanzable
+    // y variables leidas antes de recibir un valor
+    if (!hasError && buildControlFlowGraph()) {
+        propagateConditionalConstants();
+        checkDefiniteAssignment();
+    }
     
     int success = !hasError;
     printf(success ? "\nCOMPILACION EXITOSA\n" : "\nCOMPILACION FALLIDA\n");
@@ -153,28 +136,228 @@ int compileAndShowResults(char* sourceCode) {
     if (success) {
         printSymbolTable();
         printf("El programa es sintactica y semanticamente correcto.\n");
+    } else if (errorCount > 0) {
+        printf("Se encontraron errores durante el analisis (%d informados).\n", errorCount);
     } else {
         printf("Se encontraron errores durante el analisis.\n");
     }
     
+    if (options->printTree) {
+        printAst();
+    }
+    if (options->printGraph && success) {
+        printControlFlowGraph();
+    }
+    if (success && (options->printBytecode || options->execute || options->objectFile != NULL)) {
+        success = runCompiledProgram(options);
+    }
+    
     return success;
 }
 
+/**
+ * Traduce el programa compilado a codigo de la maquina virtual, lo muestra
+ * y lo ejecuta segun las opciones
+ * @param options: Opciones de linea de comandos
+ * @return: 1 si se tradujo y la ejecucion (si se pidio) termino sin errores
+ */
+int runCompiledProgram(CompilerOptions* options) {
+    VmStats stats;
+    if (!generateBytecode(!options->plainBytecode)) {
+        return 0;
+    }
+    if (options->printBytecode) {
+        printBytecode();
+    }
+    if (options->objectFile != NULL) {
+        size_t codeSize = 0;
+        if (!writeObjectFile(&programCode, options->objectFile, &codeSize)) {
+            return 0;
+        }
+        printf("\nObjeto ELF64 escrito en '%s' (%zu bytes de codigo x86-64)\n", options->objectFile, codeSize);
+        printf("Enlazar con: gcc %s runtime.o -lm -o programa\n", options->objectFile);
+    }
+    if (!options->execute) {
+        return 1;
+    }
+
+    memset(&stats, 0, sizeof(VmStats));
+    if (options->profile) {
+        stats.pairCounts = (unsigned long long*)calloc(OP_COUNT * OP_COUNT, sizeof(unsigned long long));
+        if (stats.pairCounts == NULL) {
+            printf("ERROR CRITICO: No se pudo asignar memoria para el perfil de la ejecucion\n");
+            return 0;
+        }
+    }
+
+    if (options->nativeCode) {
+        NativeProgram native;
+        if (compileNativeProgram(&programCode, &native)) {
+            printf("\n=== EJECUCION (codigo nativo, %zu bytes) ===\n", native.size);
+            fflush(stdout);
+            int finished = executeNativeProgram(&native, &stats);
+            printf("=== FIN DE LA EJECUCION ===\n");
+            releaseNativeProgram(&native);
+            return finished;
+        }
+        printf("\nADVERTENCIA: No se pudo generar codigo nativo%s; se usa la maquina virtual\n",
+               nativeCodeAvailable() ? "" : " (requiere Linux x86-64)");
+    }
+
+    printf("\n=== EJECUCION ===\n");
+    fflush(stdout);
+    int finished = executeProgram(&programCode, &stats);
+    printf("=== FIN DE LA EJECUCION (%llu instrucciones) ===\n", stats.instructions);
+    if (stats.pairCounts != NULL) {
+        printOpcodePairs(stats.pairCounts, 20);
+        free(stats.pairCounts);
+    }
+    return finished;
+}
+
 /**
  * Libera recursos del compilador
- * @param sourceCode: Codigo fuente a liberar
- * @param isFromFile: Si el codigo fue leido de archivo
+ * @param source: Codigo fuente a liberar (proyectado en memoria o en el heap)
  */
-void cleanupCompiler(char* sourceCode, int isFromFile) {
-    // Liberar codigo fuente solo si fue asignado dinamicamente
-    if (isFromFile && sourceCode != NULL) {
-        free(sourceCode);
-        sourceCode = NULL; // Evitar double-free
+void cleanupCompiler(SourceBuffer* source) {
+    if (source != NULL && source->data != NULL) {
+        releaseSource(source);
         printf("Codigo fuente liberado de memoria.\n");
     }
     
     // Liberar tabla de simbolos y reiniciar variables
     cleanup();
+    freeInternTable(&identifierNames);
+    freeArena(&compilationArena);
+}
+
+/**
+ * Muestra la forma de uso del compilador
+ * @param programName: Nombre del ejecutable
+ */
+void printUsage(char* programName) {
+    printf("Uso: %s [opciones] [archivo_fuente.txt | -]\n", programName);
+    printf("Opciones:\n");
+    printf("  --tokens   Lista los tokens reconocidos por el analizador lexico\n");
+    printf("  --arbol    Muestra el arbol sintactico construido por el parser\n");
+    printf("  --grafo    Muestra el grafo de flujo de control despues de eliminar el\n");
+    printf("             codigo inalcanzable\n");
+    printf("  --ejecutar Ejecuta el programa compilado en la maquina virtual\n");
+    printf("  --codigo   Muestra el codigo de la maquina virtual\n");
+    printf("  --perfil   Ejecuta el programa y muestra los pares de operaciones\n");
+    printf("             consecutivas mas frecuentes\n");
+    printf("  --jit      Ejecuta el programa traducido a codigo x86-64 en memoria\n");
+    printf("             (en lugar de la maquina virtual)\n");
+    printf("  --objeto A Escribe el programa como objeto ELF64 x86-64 en el archivo A,\n");
+    printf("             para enlazar con runtime.o\n");
+    printf("  --sin-fusion  Genera el codigo sin superinstrucciones\n");
+    printf("  --bench    Ejecuta las mediciones de rendimiento\n");
+    printf("  --hilos N  Reconoce todos los tokens antes de compilar, repartiendo el\n");
+    printf("             codigo entre N hilos (0 = un hilo por procesador)\n");
+    printf("  --tuberia  Ejecuta el analizador lexico en un hilo propio, en paralelo\n");
+    printf("             con el analisis sintactico\n");
+    printf("  --max-errores N  Detiene el analisis despues de informar N errores\n");
+    printf("             (0 = sin limite, por defecto %d)\n", DEFAULT_MAX_ERRORS);
+}
+
+/**
+ * Interpreta los argumentos de linea de comandos
+ * @param argc: Numero de argumentos
+ * @param argv: Argumentos de linea de comandos
+ * @param options: Estructura donde se guardan las opciones leidas
+ * @return: 1 si los argumentos son validos, 0 en caso contrario
+ */
+int parseArguments(int argc, char* argv[], CompilerOptions* options) {
+    memset(options, 0, sizeof(CompilerOptions));
+    options->threadCount = -1;
+    options->maxErrors = DEFAULT_MAX_ERRORS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tokens") == 0) {
+            options->printTokens = 1;
+        } else if (strcmp(argv[i], "--arbol") == 0) {
+            options->printTree = 1;
+        } else if (strcmp(argv[i], "--grafo") == 0) {
+            options->printGraph = 1;
+        } else if (strcmp(argv[i], "--ejecutar") == 0) {
+            options->execute = 1;
+        } else if (strcmp(argv[i], "--perfil") == 0) {
+            options->execute = 1;
+            options->profile = 1;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            options->execute = 1;
+            options->nativeCode = 1;
+        } else if (strcmp(argv[i], "--objeto") == 0) {
+            if (i + 1 >= argc) {
+                printf("ERROR: --objeto requiere el nombre del archivo a escribir\n");
+                return 0;
+            }
+            options->objectFile = argv[++i];
+        } else if (strcmp(argv[i], "--sin-fusion") == 0) {
+            options->plainBytecode = 1;
+        } else if (strcmp(argv[i], "--codigo") == 0) {
+            options->printBytecode = 1;
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            options->benchmark = 1;
+        } else if (strcmp(argv[i], "--tuberia") == 0) {
+            options->pipeline = 1;
+        } else if (strcmp(argv[i], "--hilos") == 0) {
+            char* end = NULL;
+            if (i + 1 < argc) {
+                i++;
+                options->threadCount = (int)strtol(argv[i], &end, 10);
+            }
+            if (end == NULL || end == argv[i] || *end != '\0' || options->threadCount < 0) {
+                printf("ERROR: --hilos requiere una cantidad de hilos (0 o mas)\n");
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--max-errores") == 0) {
+            char* end = NULL;
+            if (i + 1 < argc) {
+                i++;
+                options->maxErrors = (int)strtol(argv[i], &end, 10);
+            }
+            if (end == NULL || end == argv[i] || *end != '\0' || options->maxErrors < 0) {
+                printf("ERROR: --max-errores requiere una cantidad de errores (0 = sin limite)\n");
+                return 0;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            printf("ERROR: Opcion desconocida '%s'\n", argv[i]);
+            return 0;
+        } else if (options->sourceFile == NULL) {
+            options->sourceFile = argv[i];
+        } else {
+            printf("ERROR: Demasiados argumentos\n");
+            return 0;
+        }
+    }
+
+    if (options->pipeline && options->threadCount >= 0) {
+        printf("ERROR: --tuberia y --hilos no se pueden combinar\n");
+        return 0;
+    }
+    if (options->profile && options->nativeCode) {
+        printf("ERROR: --perfil y --jit no se pueden combinar\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Lista todos los tokens del codigo fuente
+ * @param source: Codigo fuente a tokenizar
+ */
+void printAllTokens(SourceBuffer* source) {
+    printf("=== TOKENS ===\n");
+    initLexer(source->data, source->length);
+    printToken(currentToken);
+
+    while (currentToken.type != TOKEN_EOF) {
+        currentToken = getNextToken();
+        printToken(currentToken);
+    }
+    printf("\n");
 }
 
 /**
@@ -184,31 +367,46 @@ void cleanupCompiler(char* sourceCode, int isFromFile) {
  * @return: Codigo de salida (0 = exito, 1 = error)
  */
 int main(int argc, char* argv[]) {
-    if (argc > 2) {
-        printf("ERROR: Demasiados argumentos\nUso: %s [archivo_fuente.txt]\n", argv[0]);
+    CompilerOptions options;
+    if (!parseArguments(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    // Obtener codigo fuente (el archivo se proyecta en memoria, "-" lee stdin)
+    SourceBuffer source;
+    int isFromFile = (options.sourceFile != NULL);
+    int loaded = isFromFile ? loadSourceFile(options.sourceFile, &source)
+                            : loadSourceString(getExampleSourceCode(), &source);
+    
+    if (!loaded) {
+        printf("ERROR: No se pudo obtener el codigo fuente\n");
         return 1;
     }
     
+    if (options.benchmark) {
+        runBenchmarks(isFromFile ? &source : NULL);
+        releaseSource(&source);
+        return 0;
+    }
+    
     printf("=== COMPILADOR SSL - TRABAJO FINAL ===\n");
     printf("Tipos soportados: entero, caracter, real\n");
     printf("Sentencias: si-sino, mientras, repetir-hasta\n");
     printf("=====================================\n\n");
     
-    // Obtener codigo fuente
-    int isFromFile = (argc == 2);
-    char* sourceCode = isFromFile ? readSourceFile(argv[1]) : getExampleSourceCode();
+    if (!isFromFile) printf("Usando codigo de ejemplo para demostracion:\n\n");
+    printf("CODIGO FUENTE:\n");
+    fwrite(source.data, 1, source.length, stdout);
+    printf("\n=====================================\n\n");
     
-    if (!sourceCode) {
-        printf("ERROR: No se pudo obtener el codigo fuente\n");
-        return 1;
+    if (options.printTokens) {
+        printAllTokens(&source);
     }
     
-    if (!isFromFile) printf("Usando codigo de ejemplo para demostracion:\n\n");
-    printf("CODIGO FUENTE:\n%s\n=====================================\n\n", sourceCode);
-    
     // Compilar y mostrar resultados
-    int success = compileAndShowResults(sourceCode);
-    cleanupCompiler(sourceCode, isFromFile);
+    int success = compileAndShowResults(&source, &options);
+    cleanupCompiler(&source);
     
     return success ? 0 : 1;
-}
\ No newline at end of file
+}
@@ -0,0 +1,391 @@
+#include "compilador.h"
+
+/*
+ * Escritura de un objeto ELF64 relocalizable (x86-64) con el programa
+ * traducido por generateMachineCode, sin ensamblador externo. Se enlaza con
+ * la biblioteca de ejecucion (runtime.c), que tiene main, leer y escribir:
+ *
+ *     gcc programa.o runtime.o -lm -o programa
+ *
+ * El objeto define:
+ *   sslProgram        funcion del programa (recibe el arreglo de registros)
+ *   sslRegisterCount  cantidad de registros (4 bytes cada uno)
+ *   sslErrorMessages  mensajes de los errores de ejecucion, ya con la linea
+ *
+ * y usa sslRead, sslWrite y fmodf, que completa el enlazador (call rel32
+ * con relocaciones R_X86_64_PLT32). Si una instruccion falla, sslProgram
+ * devuelve la posicion de su mensaje dentro de sslErrorMessages.
+ */
+
+/* Secciones del objeto, en el orden de la tabla de secciones */
+enum {
+    SECTION_NULL,
+    SECTION_TEXT,
+    SECTION_RODATA,
+    SECTION_SYMTAB,
+    SECTION_STRTAB,
+    SECTION_RELA_TEXT,
+    SECTION_SHSTRTAB,
+    SECTION_NOTE_STACK,          // Pila no ejecutable
+    SECTION_COUNT
+};
+
+/* Simbolos del objeto, en el orden de la tabla de simbolos */
+enum {
+    SYMBOL_NULL,
+    SYMBOL_PROGRAM,
+    SYMBOL_REGISTER_COUNT,
+    SYMBOL_ERROR_MESSAGES,
+    SYMBOL_READ,                 // Indefinidos: los resuelve el enlazador
+    SYMBOL_WRITE,
+    SYMBOL_FMODF,
+    SYMBOL_COUNT
+};
+
+/* Valores de ELF usados */
+#define ELF_HEADER_SIZE 64
+#define ELF_SECTION_HEADER_SIZE 64
+#define ELF_SYMBOL_SIZE 24
+#define ELF_RELA_SIZE 24
+#define ELF_TYPE_RELOCATABLE 1
+#define ELF_MACHINE_X86_64 62
+#define SECTION_TYPE_PROGBITS 1
+#define SECTION_TYPE_SYMTAB 2
+#define SECTION_TYPE_STRTAB 3
+#define SECTION_TYPE_RELA 4
+#define SECTION_FLAG_ALLOC 0x2
+#define SECTION_FLAG_EXEC 0x4
+#define SECTION_FLAG_INFO_LINK 0x40
+#define SYMBOL_GLOBAL_FUNC 0x12
+#define SYMBOL_GLOBAL_OBJECT 0x11
+#define SYMBOL_GLOBAL_NOTYPE 0x10
+#define RELOCATION_PLT32 4
+
+/* Buffer de bytes del archivo */
+typedef struct {
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+    int failed;                  // Falto memoria
+} ObjectBuffer;
+
+/* Posicion y tamano de una seccion dentro del archivo */
+typedef struct {
+    size_t offset;
+    size_t size;
+} SectionExtent;
+
+/**
+ * Agrega bytes al final del buffer
+ * @param buffer: Buffer destino
+ * @param bytes: Bytes a agregar (NULL para agregar ceros)
+ * @param count: Cantidad de bytes
+ */
+static void putBytes(ObjectBuffer* buffer, const void* bytes, size_t count) {
+    if (buffer->failed) {
+        return;
+    }
+    if (buffer->length + count > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity < buffer->length + count) capacity *= 2;
+
+        unsigned char* data = (unsigned char*)realloc(buffer->data, capacity);
+        if (data == NULL) {
+            buffer->failed = 1;
+            return;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+    if (bytes != NULL) {
+        memcpy(buffer->data + buffer->length, bytes, count);
+    } else {
+        memset(buffer->data + buffer->length, 0, count);
+    }
+    buffer->length += count;
+}
+
+/**
+ * Agrega un entero sin signo en little endian
+ * @param buffer: Buffer destino
+ * @param value: Valor
+ * @param size: Bytes del valor (1, 2, 4 u 8)
+ */
+static void putValue(ObjectBuffer* buffer, unsigned long long value, int size) {
+    unsigned char bytes[8];
+
+    for (int i = 0; i < size; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    putBytes(buffer, bytes, (size_t)size);
+}
+
+/**
+ * Completa con ceros hasta una posicion multiplo de la alineacion
+ * @param buffer: Buffer destino
+ * @param alignment: Alineacion (potencia de 2)
+ */
+static void alignBuffer(ObjectBuffer* buffer, size_t alignment) {
+    putBytes(buffer, NULL, (alignment - buffer->length % alignment) % alignment);
+}
+
+/**
+ * Calcula la posicion de cada nombre en una tabla de cadenas de ELF (los
+ * nombres seguidos, cada uno terminado en '\0')
+ * @param names: Nombres; el primero es la cadena vacia
+ * @param count: Cantidad de nombres
+ * @param offsets: Posicion de cada nombre
+ */
+static void computeStringOffsets(const char* const* names, int count, unsigned int* offsets) {
+    unsigned int offset = 0;
+
+    for (int i = 0; i < count; i++) {
+        offsets[i] = offset;
+        offset += (unsigned int)strlen(names[i]) + 1;
+    }
+}
+
+/**
+ * Agrega una tabla de cadenas de ELF (ver computeStringOffsets)
+ * @param buffer: Buffer destino
+ * @param names: Nombres
+ * @param count: Cantidad de nombres
+ */
+static void putStringTable(ObjectBuffer* buffer, const char* const* names, int count) {
+    for (int i = 0; i < count; i++) {
+        putBytes(buffer, names[i], strlen(names[i]) + 1);
+    }
+}
+
+/**
+ * Agrega una entrada de la tabla de simbolos
+ * @param buffer: Buffer destino
+ * @param name: Posicion del nombre en .strtab
+ * @param info: Ligadura y tipo
+ * @param section: Seccion que lo define (0 = indefinido)
+ * @param value: Posicion dentro de la seccion
+ * @param size: Tamano
+ */
+static void putSymbol(ObjectBuffer* buffer, unsigned int name, unsigned int info, unsigned int section,
+                      unsigned long long value, unsigned long long size) {
+    putValue(buffer, name, 4);
+    putValue(buffer, info, 1);
+    putValue(buffer, 0, 1);      // Visibilidad por defecto
+    putValue(buffer, section, 2);
+    putValue(buffer, value, 8);
+    putValue(buffer, size, 8);
+}
+
+/**
+ * Agrega un encabezado de seccion
+ * @param buffer: Buffer destino
+ * @param name: Posicion del nombre en .shstrtab
+ * @param type: Tipo de seccion
+ * @param flags: Atributos
+ * @param extent: Posicion y tamano en el archivo
+ * @param link: Seccion asociada
+ * @param info: Informacion segun el tipo
+ * @param alignment: Alineacion
+ * @param entrySize: Tamano de cada entrada (tablas)
+ */
+static void putSectionHeader(ObjectBuffer* buffer, unsigned int name, unsigned int type, unsigned long long flags,
+                             SectionExtent extent, unsigned int link, unsigned int info,
+                             unsigned long long alignment, unsigned long long entrySize) {
+    putValue(buffer, name, 4);
+    putValue(buffer, type, 4);
+    putValue(buffer, flags, 8);
+    putValue(buffer, 0, 8);      // Direccion (se asigna al enlazar)
+    putValue(buffer, extent.offset, 8);
+    putValue(buffer, extent.size, 8);
+    putValue(buffer, link, 4);
+    putValue(buffer, info, 4);
+    putValue(buffer, alignment, 8);
+    putValue(buffer, entrySize, 8);
+}
+
+/**
+ * Arma los mensajes de los errores de ejecucion posibles (los mismos de la
+ * maquina virtual) y el codigo de falla de cada instruccion
+ * @param program: Programa de la maquina virtual
+ * @param messages: Buffer donde se agregan los mensajes (terminados en '\0')
+ * @param failureCodes: Posicion del mensaje de cada instruccion que puede fallar
+ */
+static void buildErrorMessages(const BytecodeProgram* program, ObjectBuffer* messages, int* failureCodes) {
+    for (unsigned int pc = 0; pc < program->count; pc++) {
+        const Instruction* instruction = &program->code[pc];
+        char message[256];
+
+        failureCodes[pc] = 0;
+        if (instruction->opcode == OP_READ_I || instruction->opcode == OP_READ_R ||
+            instruction->opcode == OP_READ_C) {
+            snprintf(message, sizeof(message),
+                     "ERROR DE EJECUCION en linea %d: Entrada no valida para la variable '%s'\n",
+                     program->lines[pc], symbolTable.entries[instruction->a].name);
+        } else if (instruction->opcode == OP_DIV_I || instruction->opcode == OP_MOD_I ||
+                   ((instruction->opcode == OP_DIVK_I || instruction->opcode == OP_MODK_I) &&
+                    instruction->c == 0)) {
+            snprintf(message, sizeof(message), "ERROR DE EJECUCION en linea %d: Division por cero\n",
+                     program->lines[pc]);
+        } else {
+            continue;
+        }
+        failureCodes[pc] = (int)messages->length;
+        putBytes(messages, message, strlen(message) + 1);
+    }
+    if (messages->length == 0) {
+        putValue(messages, 0, 1);
+    }
+}
+
+/**
+ * Escribe el programa traducido como objeto ELF64 relocalizable
+ * @param program: Programa de la maquina virtual
+ * @param path: Archivo de salida
+ * @param codeSize: Si no es NULL, recibe los bytes de codigo
+ * @return: 1 si se escribio el archivo, 0 si no
+ */
+int writeObjectFile(const BytecodeProgram* program, const char* path, size_t* codeSize) {
+    static const char* const symbolNames[SYMBOL_COUNT] = {
+        "", "sslProgram", "sslRegisterCount", "sslErrorMessages", "sslRead", "sslWrite", "fmodf"
+    };
+    static const char* const sectionNames[SECTION_COUNT] = {
+        "", ".text", ".rodata", ".symtab", ".strtab", ".rela.text", ".shstrtab", ".note.GNU-stack"
+    };
+    static const unsigned int callSymbols[] = {SYMBOL_READ, SYMBOL_WRITE, SYMBOL_FMODF};
+    unsigned int symbolNameOffsets[SYMBOL_COUNT];
+    unsigned int sectionNameOffsets[SECTION_COUNT];
+    ObjectBuffer file, messages;
+    SectionExtent extents[SECTION_COUNT];
+    MachineCode code;
+    int* failureCodes = (int*)malloc((program->count ? program->count : 1) * sizeof(int));
+    int success = 0;
+
+    memset(&file, 0, sizeof(ObjectBuffer));
+    memset(&messages, 0, sizeof(ObjectBuffer));
+    memset(extents, 0, sizeof(extents));
+    if (failureCodes == NULL) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el objeto\n");
+        return 0;
+    }
+    buildErrorMessages(program, &messages, failureCodes);
+    if (messages.failed || !generateMachineCode(program, failureCodes, 1, &code)) {
+        printf("ERROR CRITICO: No se pudo traducir el programa a codigo x86-64\n");
+        free(failureCodes);
+        free(messages.data);
+        return 0;
+    }
+
+    // Encabezado: se completa la posicion de la tabla de secciones al final
+    putBytes(&file, NULL, ELF_HEADER_SIZE);
+
+    extents[SECTION_TEXT].offset = file.length;
+    putBytes(&file, code.bytes, code.length);
+    extents[SECTION_TEXT].size = code.length;
+
+    alignBuffer(&file, 4);
+    extents[SECTION_RODATA].offset = file.length;
+    putValue(&file, program->registerCount, 4);
+    putBytes(&file, messages.data, messages.length);
+    extents[SECTION_RODATA].size = file.length - extents[SECTION_RODATA].offset;
+
+    computeStringOffsets(symbolNames, SYMBOL_COUNT, symbolNameOffsets);
+    computeStringOffsets(sectionNames, SECTION_COUNT, sectionNameOffsets);
+
+    alignBuffer(&file, 8);
+    extents[SECTION_SYMTAB].offset = file.length;
+    putSymbol(&file, 0, 0, 0, 0, 0);
+    putSymbol(&file, symbolNameOffsets[SYMBOL_PROGRAM], SYMBOL_GLOBAL_FUNC, SECTION_TEXT, 0, code.length);
+    putSymbol(&file, symbolNameOffsets[SYMBOL_REGISTER_COUNT], SYMBOL_GLOBAL_OBJECT, SECTION_RODATA, 0, 4);
+    putSymbol(&file, symbolNameOffsets[SYMBOL_ERROR_MESSAGES], SYMBOL_GLOBAL_OBJECT, SECTION_RODATA, 4,
+              messages.length);
+    for (int symbol = SYMBOL_READ; symbol <= SYMBOL_FMODF; symbol++) {
+        putSymbol(&file, symbolNameOffsets[symbol], SYMBOL_GLOBAL_NOTYPE, 0, 0, 0);
+    }
+    extents[SECTION_SYMTAB].size = file.length - extents[SECTION_SYMTAB].offset;
+
+    extents[SECTION_STRTAB].offset = file.length;
+    putStringTable(&file, symbolNames, SYMBOL_COUNT);
+    extents[SECTION_STRTAB].size = file.length - extents[SECTION_STRTAB].offset;
+
+    alignBuffer(&file, 8);
+    extents[SECTION_RELA_TEXT].offset = file.length;
+    for (unsigned int i = 0; i < code.callCount; i++) {
+        putValue(&file, code.calls[i].position, 8);
+        putValue(&file, ((unsigned long long)callSymbols[code.calls[i].function] << 32) | RELOCATION_PLT32, 8);
+        putValue(&file, (unsigned long long)-4LL, 8);   // El desplazamiento se cuenta desde el final
+    }
+    extents[SECTION_RELA_TEXT].size = file.length - extents[SECTION_RELA_TEXT].offset;
+
+    extents[SECTION_SHSTRTAB].offset = file.length;
+    putStringTable(&file, sectionNames, SECTION_COUNT);
+    extents[SECTION_SHSTRTAB].size = file.length - extents[SECTION_SHSTRTAB].offset;
+
+    extents[SECTION_NOTE_STACK].offset = file.length;
+
+    alignBuffer(&file, 8);
+    size_t sectionHeaders = file.length;
+    putBytes(&file, NULL, ELF_SECTION_HEADER_SIZE);
+    putSectionHeader(&file, sectionNameOffsets[SECTION_TEXT], SECTION_TYPE_PROGBITS,
+                     SECTION_FLAG_ALLOC | SECTION_FLAG_EXEC, extents[SECTION_TEXT], 0, 0, 16, 0);
+    putSectionHeader(&file, sectionNameOffsets[SECTION_RODATA], SECTION_TYPE_PROGBITS, SECTION_FLAG_ALLOC,
+                     extents[SECTION_RODATA], 0, 0, 4, 0);
+    putSectionHeader(&file, sectionNameOffsets[SECTION_SYMTAB], SECTION_TYPE_SYMTAB, 0, extents[SECTION_SYMTAB],
+                     SECTION_STRTAB, SYMBOL_PROGRAM, 8, ELF_SYMBOL_SIZE);
+    putSectionHeader(&file, sectionNameOffsets[SECTION_STRTAB], SECTION_TYPE_STRTAB, 0, extents[SECTION_STRTAB],
+                     0, 0, 1, 0);
+    putSectionHeader(&file, sectionNameOffsets[SECTION_RELA_TEXT], SECTION_TYPE_RELA, SECTION_FLAG_INFO_LINK,
+                     extents[SECTION_RELA_TEXT], SECTION_SYMTAB, SECTION_TEXT, 8, ELF_RELA_SIZE);
+    putSectionHeader(&file, sectionNameOffsets[SECTION_SHSTRTAB], SECTION_TYPE_STRTAB, 0,
+                     extents[SECTION_SHSTRTAB], 0, 0, 1, 0);
+    putSectionHeader(&file, sectionNameOffsets[SECTION_NOTE_STACK], SECTION_TYPE_PROGBITS, 0,
+                     extents[SECTION_NOTE_STACK], 0, 0, 1, 0);
+
+    if (!file.failed) {
+        static const unsigned char identification[16] = {0x7F, 'E', 'L', 'F', 2 /* 64 bits */,
+                                                         1 /* little endian */, 1 /* version */};
+        ObjectBuffer header;
+
+        memset(&header, 0, sizeof(ObjectBuffer));
+        putBytes(&header, identification, sizeof(identification));
+        putValue(&header, ELF_TYPE_RELOCATABLE, 2);
+        putValue(&header, ELF_MACHINE_X86_64, 2);
+        putValue(&header, 1, 4);                     // Version
+        putValue(&header, 0, 8);                     // Sin punto de entrada
+        putValue(&header, 0, 8);                     // Sin encabezados de programa
+        putValue(&header, sectionHeaders, 8);
+        putValue(&header, 0, 4);                     // Atributos
+        putValue(&header, ELF_HEADER_SIZE, 2);
+        putValue(&header, 0, 2);
+        putValue(&header, 0, 2);
+        putValue(&header, ELF_SECTION_HEADER_SIZE, 2);
+        putValue(&header, SECTION_COUNT, 2);
+        putValue(&header, SECTION_SHSTRTAB, 2);
+        if (!header.failed) {
+            memcpy(file.data, header.data, ELF_HEADER_SIZE);
+
+            FILE* output = fopen(path, "wb");
+            if (output == NULL) {
+                printf("ERROR: No se pudo crear el archivo '%s'\n", path);
+            } else {
+                success = fwrite(file.data, 1, file.length, output) == file.length;
+                success = (fclose(output) == 0) && success;
+                if (!success) {
+                    printf("ERROR: No se pudo escribir el archivo '%s'\n", path);
+                }
+            }
+        }
+        free(header.data);
+    }
+    if (file.failed) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el objeto\n");
+    }
+    if (success && codeSize != NULL) {
+        *codeSize = code.length;
+    }
+
+    releaseMachineCode(&code);
+    free(failureCodes);
+    free(messages.data);
+    free(file.data);
+    return success;
+}
@@ -2,12 +2,132 @@
 
 /* Variables globales del analizador sintactico */
 int hasError = 0;
+int progressMessages = 1;
+int errorCount = 0;
+int maxErrors = DEFAULT_MAX_ERRORS;
+
+/* Errores registrados, incluidos los suprimidos (marca los nodos con error) */
+static int registeredErrors = 0;
+
+/* Modo panico: despues de un error sintactico se descartan tokens hasta un
+   punto de sincronizacion y los errores intermedios no se informan */
+static int panicMode = 0;
+
+/* Los informes de error quedan fuera de las funciones recursivas del analisis:
+   si se expanden en linea, sus buffers de mensaje agrandan el marco de pila de
+   cada nivel de anidamiento de bloques */
+#if defined(__GNUC__)
+#define PARSER_COLD __attribute__((noinline, cold))
+#else
+#define PARSER_COLD
+#endif
+
+/* Precedencia de los operadores (mayor = liga mas fuerte) */
+#define PREC_NONE 0
+#define PREC_OR 1
+#define PREC_AND 2
+#define PREC_NOT 3
+#define PREC_RELATIONAL 4
+#define PREC_ADDITIVE 5
+#define PREC_MULTIPLICATIVE 6
+
+/* Operador pendiente en la pila del analisis de expresiones */
+typedef struct {
+    Token token;               // Operador, o '(' para un parentesis abierto
+    int precedence;            // PREC_* (PREC_NONE para el parentesis)
+    int prefix;                // 1 para el "no" prefijo (un solo operando)
+    int errorMark;             // registeredErrors al apilarlo
+} PendingOperator;
+
+/* Operando ya analizado: un subarbol completo al final de expressionNodes */
+typedef struct {
+    DataType type;
+    int condition;             // 1 si es una comparacion o una combinacion logica
+    unsigned int size;         // Nodos del subarbol (0 si faltaba el operando y ya se informo)
+    int constant;              // 1 si el subarbol es un literal (valor conocido al compilar)
+    TokenValue value;          // Valor del literal
+} PendingOperand;
+
+/* Pila de trabajo del analisis de expresiones (memoria de la arena) */
+typedef struct {
+    void* items;
+    unsigned int count;
+    unsigned int capacity;
+} ExpressionStack;
+
+static ExpressionStack expressionNodes;    // AstNode en postorden
+static ExpressionStack pendingOperators;   // PendingOperator
+static ExpressionStack pendingOperands;    // PendingOperand
+static int expressionOutOfMemory = 0;      // Una pila no pudo crecer: se abandona la expresion
+
+/* Secuencia de tokens reconocida por adelantado (NULL: se pide cada token al lexer) */
+static TokenArray* tokenStream = NULL;
+static size_t tokenStreamIndex = 0;
+
+/* Tuberia con el lexer en otro hilo (NULL si no se usa) */
+static TokenPipeline* tokenPipeline = NULL;
 
 /**
  * Inicializa el analizador sintactico
  */
 void initParser() {
     hasError = 0;
+    errorCount = 0;
+    panicMode = 0;
+    registeredErrors = 0;
+    memset(&expressionNodes, 0, sizeof(ExpressionStack));
+    memset(&pendingOperators, 0, sizeof(ExpressionStack));
+    memset(&pendingOperands, 0, sizeof(ExpressionStack));
+    initAst();
+    initControlFlowGraph();
+    tokenStream = NULL;
+    tokenStreamIndex = 0;
+    tokenPipeline = NULL;
+}
+
+/**
+ * Hace que el analizador recorra por indice una secuencia de tokens ya
+ * reconocida en lugar de intercalar cada token con el analizador lexico
+ * @param tokens: Secuencia terminada en TOKEN_EOF
+ */
+void useTokenStream(TokenArray* tokens) {
+    tokenStream = tokens;
+    tokenStreamIndex = 0;
+    currentToken = getStreamToken(tokens, 0);
+}
+
+/**
+ * Hace que el analizador reciba los tokens del lexer que corre en otro hilo
+ * @param pipeline: Tuberia ya iniciada
+ */
+void useTokenPipeline(TokenPipeline* pipeline) {
+    tokenPipeline = pipeline;
+    currentToken = receiveToken(pipeline);
+}
+
+/**
+ * Obtiene el siguiente token, de la secuencia ya reconocida, de la tuberia o del lexer.
+ * Al llegar al final se sigue devolviendo TOKEN_EOF, igual que getNextToken.
+ * @return: Token siguiente
+ */
+static Token advanceToken() {
+    if (tokenStream == NULL) {
+        return tokenPipeline != NULL ? receiveToken(tokenPipeline) : getNextToken();
+    }
+    if (tokenStreamIndex + 1 < tokenStream->count) {
+        tokenStreamIndex++;
+    }
+    return getStreamToken(tokenStream, tokenStreamIndex);
+}
+
+/**
+ * Informa que el token actual no es el esperado
+ * @param expected: Tipo de token esperado
+ */
+static PARSER_COLD void reportUnexpectedToken(TokenType expected) {
+    char message[100];
+    snprintf(message, sizeof(message), "Se esperaba token tipo %d, se encontro %d", expected, currentToken.type);
+    syntaxError(message);
 }
 
 /**
@@ -16,40 +136,111 @@ void initParser() {
  */
 void match(TokenType expected) {
     if (currentToken.type == expected) {
-        currentToken = getNextToken();
+        // Un delimitador esperado indica que el parser volvio a estar en fase
+        if (expected == TOKEN_SEMICOLON || expected == TOKEN_LBRACE || expected == TOKEN_RBRACE) {
+            panicMode = 0;
+        }
+        currentToken = advanceToken();
     } else {
-        char message[100];
-        sprintf(message, "Se esperaba token tipo %d, se encontro %d", expected, currentToken.type);
-        syntaxError(message);
+        reportUnexpectedToken(expected);
     }
 }
 
+/**
+ * Indica si ya se informaron tantos errores como permite maxErrors
+ * @return: 1 si el analisis debe detenerse, 0 en caso contrario
+ */
+int errorLimitReached() {
+    return maxErrors > 0 && errorCount >= maxErrors;
+}
+
+/**
+ * Registra un error y decide si se informa. En modo panico el error es
+ * consecuencia de uno sintactico anterior y no se muestra; tampoco se
+ * muestran errores despues de alcanzar el limite.
+ * @param syntactic: 1 si es un error sintactico (inicia el modo panico)
+ * @return: 1 si hay que mostrar el mensaje, 0 si se suprime
+ */
+PARSER_COLD int registerError(int syntactic) {
+    hasError = 1;
+    registeredErrors++;
+    markAstError();
+    if (panicMode || errorLimitReached()) {
+        return 0;
+    }
+    if (syntactic) {
+        panicMode = 1;
+    }
+    errorCount++;
+    return 1;
+}
+
+/**
+ * Indica si un token puede comenzar una declaracion o una sentencia que no
+ * sea asignacion (puntos de sincronizacion del modo panico)
+ * @param type: Tipo de token
+ * @return: 1 si comienza una declaracion o sentencia
+ */
+static int startsStatement(TokenType type) {
+    return type == TOKEN_ENTERO || type == TOKEN_CARACTER || type == TOKEN_REAL ||
+           type == TOKEN_SI || type == TOKEN_MIENTRAS || type == TOKEN_REPETIR ||
+           type == TOKEN_LEER || type == TOKEN_ESCRIBIR;
+}
+
+/**
+ * Sale del modo panico descartando tokens hasta despues de un ';' o hasta
+ * un '}' o el comienzo de una declaracion o sentencia
+ */
+static PARSER_COLD void synchronize() {
+    while (currentToken.type != TOKEN_EOF && currentToken.type != TOKEN_RBRACE &&
+           !startsStatement(currentToken.type)) {
+        TokenType skipped = currentToken.type;
+        currentToken = advanceToken();
+        if (skipped == TOKEN_SEMICOLON) {
+            break;
+        }
+    }
+    panicMode = 0;
+}
+
 /**
  * Maneja errores sintacticos
  * @param message: Mensaje descriptivo del error
  */
-void syntaxError(char* message) {
-    hasError = 1;
-    printf("ERROR SINTACTICO en linea %d, columna %d: %s\n", currentToken.line, currentToken.column, message);
-    printf("Token actual: %s\n", currentToken.lexeme);
+PARSER_COLD void syntaxError(char* message) {
+    char lexemeStr[80];
+    if (!registerError(1)) {
+        return;
+    }
+    formatTokenLexeme(currentToken, lexemeStr, sizeof(lexemeStr));
+    printf("ERROR SINTACTICO en linea %d, columna %d: %s\n", getTokenLine(currentToken), getTokenColumn(currentToken), message);
+    printf("Token actual: %s\n", lexemeStr);
 }
 
 /**
- * Analiza el programa completo
+ * Analiza el programa completo y construye su arbol sintactico (programAst)
  * Gramatica: Programa -> { Declaracion | Sentencia }
  */
 void parseProgram() {
-    printf("Iniciando analisis sintactico...\n");
+    if (progressMessages) printf("Iniciando analisis sintactico...\n");
     
-    while (currentToken.type != TOKEN_EOF && !hasError) {
+    beginAstNode(AST_PROGRAM, currentToken);
+    while (currentToken.type != TOKEN_EOF && !errorLimitReached()) {
         if (currentToken.type == TOKEN_ENTERO || currentToken.type == TOKEN_CARACTER || currentToken.type == TOKEN_REAL) {
             parseDeclaration();
         } else {
             parseStatement();
         }
+        if (panicMode) {
+            synchronize();
+        }
     }
+    endAstNode();
     
-    if (!hasError) {
+    if (errorLimitReached()) {
+        printf("Se alcanzo el limite de %d errores; el analisis se detuvo.\n", maxErrors);
+    }
+    if (!hasError && progressMessages) {
         printf("Analisis sintactico completado exitosamente.\n");
     }
 }
@@ -90,6 +281,28 @@ DataType parseDataType() {
     return varType;
 }
 
+/**
+ * Guarda en un nodo del arbol el simbolo al que se refiere su nombre, asi
+ * las fases siguientes no dependen de los ambitos que ya se cerraron
+ * @param node: Indice del nodo (se ignora si no se pudo crear)
+ * @param symbol: Simbolo resuelto (NULL si no esta declarado)
+ */
+static void setAstSymbol(unsigned int node, const Symbol* symbol) {
+    if (node < programAst.count) {
+        programAst.nodes[node].value.intValue = symbol != NULL ? (int)(symbol - symbolTable.entries) : -1;
+    }
+}
+
+/**
+ * Informa que el identificador actual ya esta declarado en el mismo ambito
+ */
+static PARSER_COLD void reportDuplicateDeclaration() {
+    char message[100];
+    snprintf(message, sizeof(message), "Variable '%.*s' ya declarada",
+             currentToken.length, getTokenText(currentToken));
+    syntaxError(message);
+}
+
 /**
  * Procesa un identificador en una declaracion
  * @param varType: Tipo de dato de la variable
@@ -100,11 +313,13 @@ void processVariableDeclaration(DataType varType) {
         return;
     }
     
-    Symbol* symbol = insertSymbol(currentToken.lexeme, varType);
+    Symbol* symbol = insertSymbol(currentToken.value.intValue, getTokenText(currentToken), currentToken.length, varType);
     if (symbol == NULL) {
-        char message[100];
-        sprintf(message, "Variable '%s' ya declarada", currentToken.lexeme);
-        syntaxError(message);
+        reportDuplicateDeclaration();
+    } else {
+        unsigned int node = addAstLeaf(AST_DECLARATION, currentToken);
+        setAstSymbol(node, symbol);
+        if (node < programAst.count) programAst.nodes[node].dataType = (unsigned char)varType;
     }
     match(TOKEN_IDENTIFIER);
 }
@@ -161,7 +376,7 @@ void parseStatement() {
                             parseWriteStatement();
                         } else {
                             syntaxError("Sentencia no valida");
-                            currentToken = getNextToken(); // Intentar recuperacion
+                            currentToken = advanceToken(); // Siempre se avanza al menos un token
                         }
                     }
                 }
@@ -170,6 +385,31 @@ void parseStatement() {
     }
 }
 
+/**
+ * Informa que el identificador actual no esta declarado
+ */
+static PARSER_COLD void reportUndeclaredVariable() {
+    char message[100];
+    snprintf(message, sizeof(message), "Variable '%.*s' no declarada",
+             currentToken.length, getTokenText(currentToken));
+    semanticError(message);
+}
+
+/**
+ * Busca la variable del identificador actual. Si no esta declarada se
+ * informa y se declara en el ambito actual con TYPE_ERROR, asi los usos
+ * siguientes no repiten el error ni provocan errores de tipos en cadena.
+ * @return: Simbolo de la variable (TYPE_ERROR si no estaba declarada), o NULL si no hubo memoria
+ */
+static Symbol* resolveVariable() {
+    Symbol* var = lookupSymbol(currentToken.value.intValue);
+    if (var == NULL) {
+        reportUndeclaredVariable();
+        var = insertSymbol(currentToken.value.intValue, getTokenText(currentToken), currentToken.length, TYPE_ERROR);
+    }
+    return var;
+}
+
 /**
  * Verifica la variable en una asignacion
  * @return: Puntero al simbolo de la variable o NULL si hay error
@@ -180,13 +420,7 @@ Symbol* processAssignmentVariable() {
         return NULL;
     }
     
-    Symbol* var = lookupSymbol(currentToken.lexeme);
-    if (var == NULL) {
-        char message[100];
-        sprintf(message, "Variable '%s' no declarada", currentToken.lexeme);
-        semanticError(message);
-    }
-    
+    Symbol* var = resolveVariable();
     match(TOKEN_IDENTIFIER);
     return var;
 }
@@ -194,37 +428,81 @@ Symbol* processAssignmentVariable() {
 /**
  * Verifica la compatibilidad de tipos en la asignacion
  * @param var: Variable que recibe la asignacion
+ * @param exprType: Tipo de la expresion asignada (TYPE_ERROR si ya se informo un error en ella)
  */
-void checkAssignmentSemantics(Symbol* var) {
-    if (var != NULL) {
-        DataType exprType = checkExpressionType();
+void checkAssignmentSemantics(Symbol* var, DataType exprType) {
+    if (var != NULL && var->type != TYPE_ERROR && exprType != TYPE_ERROR) {
         checkAssignmentCompatibility(var, exprType);
     }
 }
 
+/**
+ * Registra en la variable el valor asignado si la expresion quedo plegada
+ * en un literal; si no, la variable pasa a tener un valor desconocido
+ * @param var: Variable que recibe la asignacion
+ * @param exprType: Tipo de la expresion (TYPE_ERROR si tuvo errores)
+ * @param exprNode: Indice de la raiz de la expresion en programAst
+ */
+static void propagateAssignment(Symbol* var, DataType exprType, unsigned int exprNode) {
+    ConstantValue assigned, converted;
+    const AstNode* node = exprNode < programAst.count ? &programAst.nodes[exprNode] : NULL;
+
+    if (var == NULL || var->type == TYPE_ERROR || exprType == TYPE_ERROR || node == NULL ||
+        (node->kind != AST_INT_LITERAL && node->kind != AST_REAL_LITERAL && node->kind != AST_CHAR_LITERAL)) {
+        assignKnownValue(var, NULL);
+        return;
+    }
+    assigned.type = (DataType)node->dataType;
+    assigned.value = node->value;
+    assignKnownValue(var, convertConstant(&assigned, var->type, &converted) ? &converted : NULL);
+}
+
 /**
  * Analiza sentencias de asignacion
  * Gramática: Asignacion -> Identificador := Expresion ;
  */
 void parseAssignment() {
+    unsigned int node = beginAstNode(AST_ASSIGN, currentToken);
     Symbol* var = processAssignmentVariable();
+    setAstSymbol(node, var);
     match(TOKEN_ASSIGN);
-    parseExpression();
-    checkAssignmentSemantics(var);
+    unsigned int exprNode = programAst.count;
+    DataType exprType = parseExpression();
+    checkAssignmentSemantics(var, exprType);
+    propagateAssignment(var, exprType, exprNode);
     match(TOKEN_SEMICOLON);
+    endAstNode();
 }
 
 /**
- * Analiza un bloque de sentencias entre llaves
+ * Analiza un bloque entre llaves. El bloque abre un ambito: sus declaraciones
+ * ocultan las exteriores del mismo nombre y dejan de verse al cerrarlo.
+ * Gramatica: Bloque -> { { Declaracion | Sentencia } }
  */
 void parseBlock() {
+    beginAstNode(AST_BLOCK, currentToken);
     match(TOKEN_LBRACE);
+    int scoped = enterScope();
+    if (!scoped) {
+        hasError = 1;
+    }
     
-    while (currentToken.type != TOKEN_RBRACE && currentToken.type != TOKEN_EOF && !hasError) {
-        parseStatement();
+    while (currentToken.type != TOKEN_RBRACE && currentToken.type != TOKEN_EOF && !errorLimitReached()) {
+        if (currentToken.type == TOKEN_ENTERO || currentToken.type == TOKEN_CARACTER || currentToken.type == TOKEN_REAL) {
+            parseDeclaration();
+        } else {
+            parseStatement();
+        }
+        if (panicMode) {
+            synchronize();
+        }
     }
     
+    if (scoped) {
+        exitScope();
+    }
     match(TOKEN_RBRACE);
+    endAstNode();
 }
 
 /**
@@ -247,14 +525,20 @@ void parseElseBlock() {
 }
 
 /**
- * Analiza sentencias condicionales SI
+ * Analiza sentencias condicionales SI. Los valores asignados en una rama no
+ * se conocen en la otra ni despues de la sentencia.
  * Gramática: SentenciaSi -> si ( Condicion ) { Sentencia* } [ sino { Sentencia* } ]
  */
 void parseIfStatement() {
+    beginAstNode(AST_IF, currentToken);
     match(TOKEN_SI);
     parseIfCondition();
+    size_t branchMark = markConstants();
     parseBlock();
+    forgetConstantsSince(branchMark);
     parseElseBlock();
+    forgetConstantsSince(branchMark);
+    endAstNode();
 }
 
 /**
@@ -267,13 +551,21 @@ void parseWhileCondition() {
 }
 
 /**
- * Analiza sentencias de bucle MIENTRAS
+ * Analiza sentencias de bucle MIENTRAS. La condicion y el cuerpo no usan los
+ * valores conocidos antes del bucle, y los asignados en el cuerpo no se
+ * conocen despues (el cuerpo puede no ejecutarse).
  * Gramática: SentenciaMientras -> mientras ( Condicion ) { Sentencia* }
  */
 void parseWhileStatement() {
+    beginAstNode(AST_WHILE, currentToken);
     match(TOKEN_MIENTRAS);
+    unsigned int outerBarrier = enterConstantLoop();
+    size_t loopMark = markConstants();
     parseWhileCondition();
     parseBlock();
+    forgetConstantsSince(loopMark);
+    exitConstantLoop(outerBarrier);
+    endAstNode();
 }
 
 /**
@@ -288,13 +580,19 @@ void parseUntilCondition() {
 }
 
 /**
- * Analiza sentencias de bucle REPETIR HASTA
+ * Analiza sentencias de bucle REPETIR HASTA. El cuerpo no usa los valores
+ * conocidos antes del bucle; los que asigna en linea recta valen en cada
+ * vuelta, asi que se siguen conociendo en la condicion y despues del bucle.
  * Gramática: SentenciaRepetir -> repetir { Sentencia* } hasta ( Condicion ) ;
  */
 void parseRepeatStatement() {
+    beginAstNode(AST_REPEAT, currentToken);
     match(TOKEN_REPETIR);
+    unsigned int outerBarrier = enterConstantLoop();
     parseBlock();
     parseUntilCondition();
+    exitConstantLoop(outerBarrier);
+    endAstNode();
 }
 
 /**
@@ -306,15 +604,13 @@ void processReadIdentifier() {
         return;
     }
     
-    Symbol* var = lookupSymbol(currentToken.lexeme);
-    if (var == NULL) {
-        char message[100];
-        sprintf(message, "Variable '%s' no declarada", currentToken.lexeme);
-        semanticError(message);
-    } else {
+    Symbol* var = resolveVariable();
+    if (var != NULL) {
         var->initialized = 1; // Marcar como inicializada después de leer
     }
+    assignKnownValue(var, NULL);
     
+    setAstSymbol(addAstLeaf(AST_READ, currentToken), var);
     match(TOKEN_IDENTIFIER);
 }
 
@@ -351,99 +647,463 @@ void parseReadStatement() {
  * Gramática: SentenciaEscribir -> escribir ( Expresion ) ;
  */
 void parseWriteStatement() {
+    beginAstNode(AST_WRITE, currentToken);
     match(TOKEN_ESCRIBIR);
     parseWriteParameters();
     match(TOKEN_SEMICOLON);
+    endAstNode();
 }
 
 /**
- * Analiza expresiones aritméticas
- * Gramática: Expresion -> Termino { ( + | - ) Termino }
+ * Duplica la capacidad de una pila del analisis de expresiones
+ * @param stack: Pila a agrandar
+ * @param itemSize: Tamano de cada elemento
+ * @return: 1 si se pudo agrandar, 0 si no hubo memoria
  */
-void parseExpression() {
-    parseTerm();
-    
-    while (currentToken.type == TOKEN_PLUS || currentToken.type == TOKEN_MINUS) {
-        match(currentToken.type);
-        parseTerm();
+static int growExpressionStack(ExpressionStack* stack, size_t itemSize) {
+    unsigned int capacity = stack->capacity ? stack->capacity * 2 : 64;
+    void* grown = arenaResize(&compilationArena, stack->items, (size_t)stack->capacity * itemSize,
+                              (size_t)capacity * itemSize);
+    if (grown == NULL) {
+        if (!hasError) printf("ERROR CRITICO: No se pudo asignar memoria para analizar la expresion\n");
+        hasError = 1;
+        expressionOutOfMemory = 1;
+        return 0;
     }
+    stack->items = grown;
+    stack->capacity = capacity;
+    return 1;
 }
 
 /**
- * Analiza términos de expresiones
- * Gramática: Termino -> Factor { ( * | / | % ) Factor }
+ * Reserva el lugar de un elemento mas en una pila del analisis de expresiones
+ * @param stack: Pila
+ * @param itemSize: Tamano de cada elemento
+ * @return: Puntero al lugar libre, o NULL si no hubo memoria
  */
-void parseTerm() {
-    parseFactor();
-    
-    while (currentToken.type == TOKEN_MULTIPLY || currentToken.type == TOKEN_DIVIDE || currentToken.type == TOKEN_MOD) {
-        match(currentToken.type);
-        parseFactor();
+static inline void* pushExpressionItem(ExpressionStack* stack, size_t itemSize) {
+    if (stack->count == stack->capacity && !growExpressionStack(stack, itemSize)) {
+        return NULL;
     }
+    return (char*)stack->items + (size_t)stack->count++ * itemSize;
 }
 
 /**
- * Analiza factores de expresiones
- * Gramática: Factor -> Identificador | Numero | NumeroReal | CaracterLiteral | ( Expresion )
+ * Agrega un nodo al postorden de la expresion (en nextSibling queda el
+ * tamano de su subarbol, como espera addAstPostorder)
+ * @param kind: Clase de nodo
+ * @param token: Token que origina el nodo
+ * @param type: Tipo calculado
+ * @param childCount: Cantidad de hijos (los subarboles anteriores)
+ * @param size: Nodos del subarbol, contando este
+ * @param flags: AST_FLAG_*
+ * @return: 1 si se agrego, 0 si no hubo memoria
  */
-void parseFactor() {
-    if (currentToken.type == TOKEN_IDENTIFIER) {
-        Symbol* var = lookupSymbol(currentToken.lexeme);
-        if (var == NULL) {
-            char message[100];
-            sprintf(message, "Variable '%s' no declarada", currentToken.lexeme);
-            semanticError(message);
+static int emitExpressionNode(AstKind kind, Token token, DataType type, unsigned int childCount,
+                              unsigned int size, unsigned char flags) {
+    AstNode* node = (AstNode*)pushExpressionItem(&expressionNodes, sizeof(AstNode));
+    if (node == NULL) {
+        return 0;
+    }
+    node->kind = (unsigned char)kind;
+    node->op = (unsigned char)token.type;
+    node->dataType = (unsigned char)type;
+    node->flags = flags;
+    node->childCount = childCount;
+    node->nextSibling = size;
+    node->value = token.value;
+    node->offset = token.offset;
+    return 1;
+}
+
+/**
+ * Agrega al postorden el literal de un valor conocido al compilar
+ * @param constant: Valor
+ * @param offset: Posicion en sourceCode de lo que el literal reemplaza
+ * @param flags: AST_FLAG_* (AST_FLAG_FOLDED si no estaba en el codigo)
+ * @return: 1 si se agrego, 0 si no hubo memoria
+ */
+static int emitConstantNode(const ConstantValue* constant, size_t offset, unsigned char flags) {
+    Token token;
+    AstKind kind = constant->type == TYPE_REAL ? AST_REAL_LITERAL :
+                   constant->type == TYPE_CARACTER ? AST_CHAR_LITERAL : AST_INT_LITERAL;
+    token.type = constant->type == TYPE_REAL ? TOKEN_REAL_LITERAL :
+                 constant->type == TYPE_CARACTER ? TOKEN_CHAR_LITERAL : TOKEN_NUMBER;
+    token.offset = offset;
+    token.length = 0;
+    token.value = constant->value;
+    return emitExpressionNode(kind, token, constant->type, 0, 1, flags);
+}
+
+/**
+ * Apila un operando ya analizado
+ * @param type: Tipo del operando
+ * @param condition: 1 si es una condicion
+ * @param size: Nodos de su subarbol (0 si el operando faltaba)
+ * @param value: Valor si el operando es un literal (NULL si no se conoce)
+ */
+static void pushOperand(DataType type, int condition, unsigned int size, const TokenValue* value) {
+    PendingOperand* operand = (PendingOperand*)pushExpressionItem(&pendingOperands, sizeof(PendingOperand));
+    if (operand != NULL) {
+        operand->type = type;
+        operand->condition = condition;
+        operand->size = size;
+        operand->constant = value != NULL && size > 0;
+        if (value != NULL) {
+            operand->value = *value;
+        }
+    }
+}
+
+/**
+ * Apila un operador (o un parentesis abierto) y avanza al token siguiente
+ * @param token: Operador
+ * @param precedence: PREC_* del operador
+ * @param prefix: 1 si es un operador prefijo
+ */
+static void pushOperator(Token token, int precedence, int prefix) {
+    PendingOperator* pending = (PendingOperator*)pushExpressionItem(&pendingOperators, sizeof(PendingOperator));
+    if (pending != NULL) {
+        pending->token = token;
+        pending->precedence = precedence;
+        pending->prefix = prefix;
+        pending->errorMark = registeredErrors;
+    }
+}
+
+/**
+ * Obtiene el operando de la cima de la pila
+ * @return: Operando, o NULL si la pila esta vacia
+ */
+static PendingOperand* topOperand() {
+    return pendingOperands.count > 0 ? &((PendingOperand*)pendingOperands.items)[pendingOperands.count - 1] : NULL;
+}
+
+/**
+ * Obtiene el operador de la cima de la pila
+ * @return: Operador, o NULL si la pila esta vacia
+ */
+static PendingOperator* topOperator() {
+    return pendingOperators.count > 0 ? &((PendingOperator*)pendingOperators.items)[pendingOperators.count - 1] : NULL;
+}
+
+/**
+ * Obtiene la precedencia de un token en posicion de operador binario
+ * @param type: Tipo de token
+ * @param condition: 1 si se analiza una condicion (admite operadores
+ *                   relacionales y logicos)
+ * @return: PREC_* del operador, o PREC_NONE si termina la expresion
+ */
+static int binaryPrecedence(TokenType type, int condition) {
+    switch (type) {
+        case TOKEN_MULTIPLY:
+        case TOKEN_DIVIDE:
+        case TOKEN_MOD:
+            return PREC_MULTIPLICATIVE;
+        case TOKEN_PLUS:
+        case TOKEN_MINUS:
+            return PREC_ADDITIVE;
+        case TOKEN_EQUAL:
+        case TOKEN_NOT_EQUAL:
+        case TOKEN_LESS:
+        case TOKEN_LESS_EQUAL:
+        case TOKEN_GREATER:
+        case TOKEN_GREATER_EQUAL:
+            return condition ? PREC_RELATIONAL : PREC_NONE;
+        case TOKEN_AND:
+        case TOKEN_NOT:                // "c1 no c2" se lee como "c1 y no c2"
+            return condition ? PREC_AND : PREC_NONE;
+        case TOKEN_OR:
+            return condition ? PREC_OR : PREC_NONE;
+        default:
+            return PREC_NONE;
+    }
+}
+
+/**
+ * Verifica que el operando de un operador logico sea una condicion
+ * @param operand: Operando
+ */
+static void requireCondition(const PendingOperand* operand) {
+    if (operand->size > 0 && !operand->condition) {
+        syntaxError("Se esperaba operador relacional en condición");
+    }
+}
+
+/**
+ * Verifica que el operando de un operador relacional sea un valor
+ * @param operand: Operando
+ */
+static void requireValue(const PendingOperand* operand) {
+    if (operand->size > 0 && operand->condition) {
+        syntaxError("Se esperaba operador lógico entre condiciones");
+    }
+}
+
+/**
+ * Calcula el tipo de una operacion aritmetica con las reglas del analizador
+ * semantico. Si un operando ya tuvo un error no se informa otro.
+ * @param leftType: Tipo del operando izquierdo
+ * @param rightType: Tipo del operando derecho
+ * @param operator: Operador aritmetico
+ * @return: Tipo del resultado
+ */
+static DataType combineArithmeticTypes(DataType leftType, DataType rightType, TokenType operator) {
+    if (leftType == TYPE_ERROR || rightType == TYPE_ERROR) {
+        return TYPE_ERROR;
+    }
+    return checkArithmeticOperation(leftType, rightType, operator);
+}
+
+/**
+ * Calcula al compilar una operacion aritmetica entre dos literales y
+ * reemplaza sus nodos por el literal del resultado
+ * @param op: Operador
+ * @param left: Operando izquierdo
+ * @param right: Operando derecho
+ * @param type: Tipo del resultado
+ * @return: 1 si se plego (el resultado quedo apilado), 0 si no
+ */
+static int foldOperator(const PendingOperator* op, const PendingOperand* left, const PendingOperand* right,
+                        DataType type) {
+    ConstantValue a = {left->type, left->value};
+    ConstantValue b = {right->type, right->value};
+    ConstantValue result;
+
+    if (!left->constant || !right->constant || op->errorMark != registeredErrors) {
+        return 0;
+    }
+    if ((op->token.type == TOKEN_DIVIDE || op->token.type == TOKEN_MOD) && isZeroConstant(&b)) {
+        if (progressMessages) printf("ADVERTENCIA: División por cero en una expresión constante\n");
+        return 0;
+    }
+    if (!foldArithmetic(op->token.type, &a, &b, type, &result)) {
+        return 0;
+    }
+    expressionNodes.count -= left->size + right->size;
+    pushOperand(type, 0, (unsigned int)emitConstantNode(&result, op->token.offset, AST_FLAG_FOLDED), &result.value);
+    return 1;
+}
+
+/**
+ * Aplica el operador de la cima de la pila a sus operandos: calcula el tipo,
+ * agrega el nodo al postorden y deja el resultado como operando. Una
+ * operacion aritmetica entre literales se reemplaza por su resultado.
+ */
+static void reduceOperator() {
+    PendingOperator op = ((PendingOperator*)pendingOperators.items)[--pendingOperators.count];
+    PendingOperand right = ((PendingOperand*)pendingOperands.items)[--pendingOperands.count];
+    PendingOperand left = {TYPE_ERROR, 0, 0, 0, {0}};
+    TokenType operator = op.token.type;
+    DataType type = TYPE_ERROR;
+    int condition = 1;
+
+    if (!op.prefix) {
+        left = ((PendingOperand*)pendingOperands.items)[--pendingOperands.count];
+    }
+
+    if (op.prefix || operator == TOKEN_AND || operator == TOKEN_OR) {
+        requireCondition(&right);
+        if ((op.prefix || left.type == TYPE_LOGICO) && right.type == TYPE_LOGICO) {
+            type = TYPE_LOGICO;
+        }
+    } else if (op.precedence == PREC_RELATIONAL) {
+        requireValue(&right);
+        if (left.type != TYPE_ERROR && right.type != TYPE_ERROR && !left.condition && !right.condition &&
+            checkRelationalOperation(left.type, right.type)) {
+            type = TYPE_LOGICO;
         }
-        match(TOKEN_IDENTIFIER);
     } else {
-        if (currentToken.type == TOKEN_NUMBER) {
-            match(TOKEN_NUMBER);
-        } else {
-            if (currentToken.type == TOKEN_REAL_LITERAL) {
-                match(TOKEN_REAL_LITERAL);
-            } else {
-                if (currentToken.type == TOKEN_CHAR_LITERAL) {
-                    match(TOKEN_CHAR_LITERAL);
-                } else {
-                    if (currentToken.type == TOKEN_LPAREN) {
-                        match(TOKEN_LPAREN);
-                        parseExpression();
-                        match(TOKEN_RPAREN);
-                    } else {
-                        syntaxError("Se esperaba identificador, número o expresión entre paréntesis");
-                    }
-                }
-            }
+        type = combineArithmeticTypes(left.type, right.type, operator);
+        condition = 0;
+        if (foldOperator(&op, &left, &right, type)) {
+            return;
         }
     }
+
+    unsigned char flags = op.errorMark != registeredErrors ? AST_FLAG_ERROR : 0;
+    unsigned int size = 1 + left.size + right.size;
+    emitExpressionNode(op.prefix ? AST_NOT : AST_BINARY, op.token, type,
+                       (unsigned int)((left.size > 0) + (right.size > 0)), size, flags);
+    pushOperand(type, condition, size, NULL);
 }
 
 /**
- * Analiza condiciones lógicas
- * Gramática: Condicion -> Expresion OperadorRelacional Expresion { OperadorLogico Condicion }
+ * Aplica los operadores pendientes que ligan al menos tanto como precedence,
+ * sin pasar de un parentesis abierto
+ * @param precedence: Precedencia del operador que sigue
  */
-void parseCondition() {
-    parseExpression();
-    
-    // Verificar operador relacional
-    if (currentToken.type == TOKEN_EQUAL || currentToken.type == TOKEN_NOT_EQUAL ||
-        currentToken.type == TOKEN_LESS || currentToken.type == TOKEN_LESS_EQUAL ||
-        currentToken.type == TOKEN_GREATER || currentToken.type == TOKEN_GREATER_EQUAL) {
-        match(currentToken.type);
-        parseExpression();
+static void reduceOperators(int precedence) {
+    PendingOperator* top;
+    while (!expressionOutOfMemory && (top = topOperator()) != NULL &&
+           top->token.type != TOKEN_LPAREN && top->precedence >= precedence) {
+        reduceOperator();
+    }
+}
+
+/**
+ * Analiza un operando simple (variable o literal) y lo agrega al postorden.
+ * Una variable cuyo valor se conoce se reemplaza por ese valor.
+ * @return: 1 si el token actual era un operando, 0 si no
+ */
+static int parseOperand() {
+    DataType type;
+    AstKind kind;
+    Token token = currentToken;
+    ConstantValue known;
+
+    if (token.type == TOKEN_IDENTIFIER) {
+        Symbol* var = resolveVariable();
+        if (var == NULL) {
+            match(TOKEN_IDENTIFIER);
+            pushOperand(TYPE_ERROR, 0, 0, NULL);
+            return 1;
+        }
+        if (getKnownValue(var, &known)) {
+            match(TOKEN_IDENTIFIER);
+            pushOperand(known.type, 0, (unsigned int)emitConstantNode(&known, token.offset, AST_FLAG_FOLDED),
+                        &known.value);
+            return 1;
+        }
+        token.value.intValue = (int)(var - symbolTable.entries);
+        type = var->type;
+        kind = AST_VARIABLE;
+    } else if (token.type == TOKEN_NUMBER) {
+        type = TYPE_ENTERO;
+        kind = AST_INT_LITERAL;
+    } else if (token.type == TOKEN_REAL_LITERAL) {
+        type = TYPE_REAL;
+        kind = AST_REAL_LITERAL;
+    } else if (token.type == TOKEN_CHAR_LITERAL) {
+        type = TYPE_CARACTER;
+        kind = AST_CHAR_LITERAL;
     } else {
-        syntaxError("Se esperaba operador relacional en condición");
+        return 0;
     }
-    
-    // Verificar operadores lógicos
-    while (currentToken.type == TOKEN_AND || currentToken.type == TOKEN_OR) {
-        match(currentToken.type);
-        parseCondition();
+
+    match(token.type);
+    pushOperand(type, 0, (unsigned int)emitExpressionNode(kind, token, type, 0, 1, 0),
+                kind == AST_VARIABLE ? NULL : &token.value);
+    return 1;
+}
+
+/**
+ * Analiza una expresion o una condicion por precedencia de operadores con
+ * pilas explicitas: no hay recursion por nivel de precedencia, por
+ * parentesis ni por operador logico, asi que el uso de la pila nativa no
+ * depende del largo ni del anidamiento de la expresion. El arbol se arma en
+ * postorden y se agrega al programa al terminar.
+ * @param condition: 1 para una condicion (operadores relacionales y logicos)
+ * @return: Tipo del resultado (TYPE_ERROR si no es valido)
+ */
+static DataType parseOperatorExpression(int condition) {
+    unsigned int openParens = 0;
+    int expectOperand = 1;
+
+    expressionNodes.count = pendingOperators.count = pendingOperands.count = 0;
+    expressionOutOfMemory = 0;
+    while (!expressionOutOfMemory) {
+        TokenType type = currentToken.type;
+
+        if (expectOperand) {
+            if (type == TOKEN_LPAREN) {
+                pushOperator(currentToken, PREC_NONE, 0);
+                openParens++;
+                match(TOKEN_LPAREN);
+            } else if (type == TOKEN_NOT && condition) {
+                pushOperator(currentToken, PREC_NOT, 1);
+                match(TOKEN_NOT);
+            } else {
+                if (!parseOperand()) {
+                    syntaxError("Se esperaba identificador, número o expresión entre paréntesis");
+                    pushOperand(TYPE_ERROR, 0, 0, NULL);
+                }
+                expectOperand = 0;
+            }
+            continue;
+        }
+
+        if (type == TOKEN_RPAREN && openParens > 0) {
+            reduceOperators(PREC_NONE);
+            pendingOperators.count--;    // El parentesis abierto
+            openParens--;
+            match(TOKEN_RPAREN);
+            continue;
+        }
+
+        int precedence = binaryPrecedence(type, condition);
+        if (precedence == PREC_NONE) {
+            break;
+        }
+        reduceOperators(precedence);
+        PendingOperand* left = topOperand();
+        if (precedence == PREC_RELATIONAL) {
+            requireValue(left);
+        } else if (precedence <= PREC_AND) {
+            requireCondition(left);
+        }
+
+        if (type == TOKEN_NOT) {
+            Token conjunction = currentToken;
+            conjunction.type = TOKEN_AND;
+            pushOperator(conjunction, PREC_AND, 0);
+            pushOperator(currentToken, PREC_NOT, 1);
+        } else {
+            pushOperator(currentToken, precedence, 0);
+        }
+        match(type);
+        expectOperand = 1;
     }
-    
-    // Manejar operador NOT
-    if (currentToken.type == TOKEN_NOT) {
-        match(TOKEN_NOT);
-        parseCondition();
+
+    if (expressionOutOfMemory) {
+        return TYPE_ERROR;
+    }
+
+    // Parentesis sin cerrar: se informa el que falta en el token actual
+    while (openParens > 0) {
+        reduceOperators(PREC_NONE);
+        pendingOperators.count--;
+        openParens--;
+        match(TOKEN_RPAREN);
+    }
+    reduceOperators(PREC_NONE);
+
+    PendingOperand* result = topOperand();
+    if (expressionOutOfMemory || result == NULL) {
+        return TYPE_ERROR;    // Sin memoria (ya informado)
+    }
+    if (condition) {
+        requireCondition(result);
     }
-}
\ No newline at end of file
+    DataType resultType = result->type;
+    if (condition && !result->condition) {
+        resultType = TYPE_ERROR;
+    }
+    addAstPostorder((AstNode*)expressionNodes.items, expressionNodes.count);
+    return resultType;
+}
+
+/**
+ * Analiza expresiones aritméticas
+ * Gramática: Expresion -> Termino { ( + | - ) Termino }
+ *            Termino -> Factor { ( * | / | % ) Factor }
+ *            Factor -> Identificador | Numero | NumeroReal | CaracterLiteral | ( Expresion )
+ * @return: Tipo de la expresion (TYPE_ERROR si no es valida)
+ */
+DataType parseExpression() {
+    return parseOperatorExpression(0);
+}
+
+/**
+ * Analiza condiciones lógicas. De menor a mayor precedencia: o, y, no
+ * (prefijo), operadores relacionales y luego los aritmeticos; los
+ * parentesis pueden agrupar condiciones. El "no Condicion" despues de una
+ * condicion se lee como "y no Condicion".
+ * Gramática: Condicion -> Conjuncion { o Conjuncion }
+ *            Conjuncion -> Negacion { ( y | no ) Negacion }
+ *            Negacion -> no Negacion | Expresion OperadorRelacional Expresion | ( Condicion )
+ * @return: TYPE_LOGICO, o TYPE_ERROR si alguna comparacion no es valida
+ */
+DataType parseCondition() {
+    return parseOperatorExpression(1);
+}
@@ -0,0 +1,204 @@
+#define _DEFAULT_SOURCE
+#include "compilador.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && defined(__GNUC__)
+#include <pthread.h>
+#include <sched.h>
+#define PIPELINE_AVAILABLE 1
+#else
+#define PIPELINE_AVAILABLE 0
+#endif
+
+/*
+ * Tuberia lexer -> parser: el analizador lexico corre en su propio hilo y
+ * deja los tokens en un anillo acotado de un productor y un consumidor. Cada
+ * lado es duenio de un indice y solo lee el del otro con semantica
+ * acquire/release, asi que no hacen falta cerrojos. Los indices se publican
+ * por lotes para no mover la linea de cache en cada token.
+ */
+
+/* Cantidad de posiciones del anillo (potencia de 2) */
+#define PIPELINE_RING_SIZE 2048
+
+/* Cada cuantos tokens se publica el indice propio */
+#define PIPELINE_BATCH 32
+
+/* Esperas activas antes de ceder el procesador */
+#define PIPELINE_SPINS 64
+
+/* Tamano de una linea de cache, para que los indices no la compartan */
+#define PIPELINE_CACHE_LINE 64
+
+struct TokenPipeline {
+    Token slots[PIPELINE_RING_SIZE];
+
+    // Lado del productor (hilo del lexer)
+    size_t head;                       // Tokens publicados (solo lo escribe el productor)
+    char headPadding[PIPELINE_CACHE_LINE - sizeof(size_t)];
+
+    // Lado del consumidor (hilo del parser)
+    size_t tail;                       // Tokens consumidos (solo lo escribe el consumidor)
+    char tailPadding[PIPELINE_CACHE_LINE - sizeof(size_t)];
+
+    int stop;                          // El consumidor abandona el analisis
+    char stopPadding[PIPELINE_CACHE_LINE - sizeof(int)];
+
+    // Copias locales del consumidor (las del productor viven en su pila)
+    size_t consumerTail;               // Proximo token a leer
+    size_t consumerHead;               // Ultimo head visto por el consumidor
+    Token lastToken;                   // Ultimo token entregado (TOKEN_EOF al terminar)
+
+#if PIPELINE_AVAILABLE
+    pthread_t thread;
+#endif
+};
+
+#if PIPELINE_AVAILABLE
+/**
+ * Espera a que el otro hilo avance: primero en activo y luego cediendo el
+ * procesador, para no acaparar un nucleo compartido
+ * @param spins: Cantidad de esperas consecutivas (se incrementa)
+ */
+static void waitForPeer(int* spins) {
+    if (++(*spins) < PIPELINE_SPINS) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    } else {
+        sched_yield();
+    }
+}
+
+/**
+ * Hilo productor: analiza el codigo fuente completo y deja cada token en el
+ * anillo. Termina con el TOKEN_EOF o cuando el consumidor pide detenerse.
+ * @param argument: Tuberia (TokenPipeline*)
+ * @return: NULL
+ */
+static void* produceTokens(void* argument) {
+    TokenPipeline* pipeline = (TokenPipeline*)argument;
+    LexerCursor cursor = {0, &identifierNames};
+    size_t head = 0;                   // Proximo token a escribir
+    size_t tail = 0;                   // Ultimo tail visto por el productor
+
+    for (;;) {
+        Token token = scanToken(&cursor);
+
+        if (head - tail == PIPELINE_RING_SIZE) {
+            int spins = 0;
+            __atomic_store_n(&pipeline->head, head, __ATOMIC_RELEASE);
+            while (head - (tail = __atomic_load_n(&pipeline->tail, __ATOMIC_ACQUIRE)) == PIPELINE_RING_SIZE) {
+                if (__atomic_load_n(&pipeline->stop, __ATOMIC_ACQUIRE)) {
+                    return NULL;
+                }
+                waitForPeer(&spins);
+            }
+        }
+
+        pipeline->slots[head & (PIPELINE_RING_SIZE - 1)] = token;
+        head++;
+        if (token.type == TOKEN_EOF) {
+            __atomic_store_n(&pipeline->head, head, __ATOMIC_RELEASE);
+            return NULL;
+        }
+        if (head % PIPELINE_BATCH == 0) {
+            __atomic_store_n(&pipeline->head, head, __ATOMIC_RELEASE);
+            if (__atomic_load_n(&pipeline->stop, __ATOMIC_RELAXED)) {
+                return NULL;
+            }
+        }
+    }
+}
+
+/**
+ * Espera hasta que haya al menos count tokens publicados sin consumir.
+ * Antes de esperar publica el tail propio, asi el productor nunca queda
+ * bloqueado por un anillo que en realidad ya se vacio.
+ * @param pipeline: Tuberia
+ * @param count: Cantidad de tokens necesarios (como maximo PIPELINE_RING_SIZE)
+ */
+static void waitForTokens(TokenPipeline* pipeline, size_t count) {
+    int spins = 0;
+    if (pipeline->consumerHead - pipeline->consumerTail >= count) {
+        return;
+    }
+
+    __atomic_store_n(&pipeline->tail, pipeline->consumerTail, __ATOMIC_RELEASE);
+    for (;;) {
+        pipeline->consumerHead = __atomic_load_n(&pipeline->head, __ATOMIC_ACQUIRE);
+        if (pipeline->consumerHead - pipeline->consumerTail >= count) {
+            return;
+        }
+        waitForPeer(&spins);
+    }
+}
+#endif
+
+/**
+ * Inicia el analizador lexico en un hilo propio sobre el codigo fuente
+ * @param source: Codigo fuente
+ * @return: Tuberia lista para recibir tokens, o NULL si no se pudo crear el
+ *          hilo (el llamador debe usar el analisis intercalado)
+ */
+TokenPipeline* startTokenPipeline(SourceBuffer* source) {
+#if PIPELINE_AVAILABLE
+    // El anillo vive en la arena de la compilacion; el hilo del lexer solo
+    // escribe en el y en identifierNames, que tiene memoria propia
+    TokenPipeline* pipeline = (TokenPipeline*)arenaAlloc(&compilationArena, sizeof(TokenPipeline));
+    if (pipeline == NULL) {
+        return NULL;
+    }
+    memset(pipeline, 0, sizeof(TokenPipeline));
+
+    // Las tablas del lexer se preparan antes de lanzar el hilo
+    initLexer(source->data, source->length);
+    if (pthread_create(&pipeline->thread, NULL, produceTokens, pipeline) != 0) {
+        return NULL;
+    }
+    return pipeline;
+#else
+    (void)source;
+    return NULL;
+#endif
+}
+
+/**
+ * Recibe el siguiente token del hilo del lexer. Despues del TOKEN_EOF se
+ * sigue devolviendo TOKEN_EOF, igual que getNextToken.
+ * @param pipeline: Tuberia en uso
+ * @return: Token siguiente
+ */
+Token receiveToken(TokenPipeline* pipeline) {
+#if PIPELINE_AVAILABLE
+    if (pipeline->lastToken.type == TOKEN_EOF && pipeline->consumerTail > 0) {
+        return pipeline->lastToken;
+    }
+
+    waitForTokens(pipeline, 1);
+    pipeline->lastToken = pipeline->slots[pipeline->consumerTail & (PIPELINE_RING_SIZE - 1)];
+    pipeline->consumerTail++;
+    if (pipeline->consumerTail % PIPELINE_BATCH == 0) {
+        __atomic_store_n(&pipeline->tail, pipeline->consumerTail, __ATOMIC_RELEASE);
+    }
+    return pipeline->lastToken;
+#else
+    (void)pipeline;
+    return currentToken;
+#endif
+}
+
+/**
+ * Detiene el hilo del lexer (aunque no haya llegado al final). La memoria de
+ * la tuberia vuelve con la arena de la compilacion.
+ * @param pipeline: Tuberia a cerrar
+ */
+void stopTokenPipeline(TokenPipeline* pipeline) {
+    if (pipeline == NULL) {
+        return;
+    }
+#if PIPELINE_AVAILABLE
+    __atomic_store_n(&pipeline->stop, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&pipeline->tail, pipeline->consumerTail, __ATOMIC_RELEASE);
+    pthread_join(pipeline->thread, NULL);
+#endif
+}
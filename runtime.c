@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Biblioteca de ejecucion de los programas compilados a objeto ELF
+ * (--objeto, ver object.c). No usa nada del compilador: se enlaza con el
+ * objeto generado para obtener un ejecutable sin interprete.
+ *
+ *     gcc programa.o runtime.o -lm -o programa
+ *
+ * Lectura y escritura dan los mismos resultados que la maquina virtual
+ * (readRuntimeValue y writeRuntimeValue en vm.c).
+ */
+
+/* Clase del valor de leer/escribir (orden de OP_READ_* y OP_WRITE_*) */
+enum {
+    RUNTIME_ENTERO,
+    RUNTIME_REAL,
+    RUNTIME_CARACTER
+};
+
+/* Definidos por el objeto generado */
+extern int sslProgram(void* registers);
+extern const unsigned int sslRegisterCount;
+extern const char sslErrorMessages[];
+
+/**
+ * Lee un valor de la entrada estandar para leer(variable)
+ * @param kind: RUNTIME_ENTERO, RUNTIME_REAL o RUNTIME_CARACTER
+ * @param destination: Registro de la variable (4 bytes)
+ * @return: 1 si se leyo un valor valido, 0 si no
+ */
+int sslRead(int kind, void* destination) {
+    fflush(stdout);
+    if (kind == RUNTIME_REAL) {
+        float value;
+        if (scanf("%f", &value) != 1) {
+            return 0;
+        }
+        memcpy(destination, &value, sizeof(float));
+        return 1;
+    }
+    if (kind == RUNTIME_CARACTER) {
+        char value;
+        int extended;
+        if (scanf(" %c", &value) != 1) {
+            return 0;
+        }
+        extended = value;
+        memcpy(destination, &extended, sizeof(int));
+        return 1;
+    }
+    int value;
+    if (scanf("%d", &value) != 1) {
+        return 0;
+    }
+    memcpy(destination, &value, sizeof(int));
+    return 1;
+}
+
+/**
+ * Escribe un valor para escribir(expresion)
+ * @param kind: Clase del valor
+ * @param bits: Contenido del registro
+ */
+void sslWrite(int kind, int bits) {
+    float real;
+
+    switch (kind) {
+        case RUNTIME_REAL:
+            memcpy(&real, &bits, sizeof(float));
+            printf("%g\n", real);
+            break;
+        case RUNTIME_CARACTER:
+            printf("%c\n", (char)bits);
+            break;
+        default:
+            printf("%d\n", bits);
+            break;
+    }
+}
+
+/**
+ * Ejecuta el programa compilado. Las variables empiezan en cero.
+ * @return: 0 si el programa termino, 1 si se detuvo por un error de ejecucion
+ */
+int main(void) {
+    void* registers = calloc(sslRegisterCount ? sslRegisterCount : 1, sizeof(int));
+
+    if (registers == NULL) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para los registros del programa\n");
+        return 1;
+    }
+
+    int failure = sslProgram(registers);
+    fflush(stdout);
+    if (failure >= 0) {
+        fputs(sslErrorMessages + failure, stdout);
+    }
+    free(registers);
+    return failure >= 0;
+}
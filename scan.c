@@ -0,0 +1,285 @@
+#include "compilador.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define SCAN_HAS_X86 1
+#else
+#define SCAN_HAS_X86 0
+#endif
+
+/*
+ * Nucleos que encuentran el final de las corridas largas del analizador
+ * lexico (blancos, cuerpos de comentario, identificadores y digitos).
+ * Todos asumen que el texto termina en '\0' seguido de SOURCE_PADDING bytes
+ * en cero: el cero corta cualquier corrida y las lecturas de 16/32 bytes que
+ * comienzan antes del fin nunca salen del buffer.
+ */
+
+/* ========== VERSIONES ESCALARES ========== */
+
+/**
+ * Avanza sobre espacios, tabulaciones, retornos de carro y saltos de linea
+ * @param text: Codigo fuente
+ * @param pos: Posicion inicial
+ * @return: Posicion del primer caracter que no es blanco
+ */
+static size_t skipBlanksScalar(const char* text, size_t pos) {
+    for (;;) {
+        char c = text[pos];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+            return pos;
+        }
+        pos++;
+    }
+}
+
+/**
+ * Avanza sobre letras, digitos y guiones bajos
+ * @param text: Codigo fuente
+ * @param pos: Posicion inicial
+ * @return: Posicion del primer caracter que no forma parte del identificador
+ */
+static size_t skipIdentifierScalar(const char* text, size_t pos) {
+    while (isLetter(text[pos]) || isDigit(text[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * Avanza sobre digitos decimales
+ * @param text: Codigo fuente
+ * @param pos: Posicion inicial
+ * @return: Posicion del primer caracter que no es digito
+ */
+static size_t skipDigitsScalar(const char* text, size_t pos) {
+    while (isDigit(text[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+/**
+ * Busca el fin de la linea actual (cuerpo de un comentario)
+ * @param text: Codigo fuente
+ * @param pos: Posicion inicial
+ * @return: Posicion del salto de linea o del '\0' final
+ */
+static size_t findLineEndScalar(const char* text, size_t pos) {
+    while (text[pos] != '\n' && text[pos] != '\0') {
+        pos++;
+    }
+    return pos;
+}
+
+#if SCAN_HAS_X86
+/* ========== VERSIONES SSE2 (16 BYTES POR PASO) ========== */
+
+/**
+ * Mascara de bytes dentro del rango [low, high] (solo ASCII)
+ */
+static inline __m128i rangeMask128(__m128i bytes, char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(low - 1)),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(high + 1), bytes));
+}
+
+/**
+ * Mascara de bytes que pueden formar parte de un identificador
+ */
+static inline __m128i identifierMask128(__m128i bytes) {
+    __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    __m128i mask = rangeMask128(lower, 'a', 'z');
+    mask = _mm_or_si128(mask, rangeMask128(bytes, '0', '9'));
+    return _mm_or_si128(mask, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')));
+}
+
+static size_t skipBlanksSse2(const char* text, size_t pos) {
+    for (;;) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(text + pos));
+        __m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+                                      _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t')));
+        blanks = _mm_or_si128(blanks, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r')));
+        blanks = _mm_or_si128(blanks, _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(blanks);
+        if (bits != 0xFFFFu) {
+            return pos + (size_t)__builtin_ctz(~bits);
+        }
+        pos += 16;
+    }
+}
+
+static size_t skipIdentifierSse2(const char* text, size_t pos) {
+    for (;;) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(text + pos));
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(identifierMask128(bytes));
+        if (bits != 0xFFFFu) {
+            return pos + (size_t)__builtin_ctz(~bits);
+        }
+        pos += 16;
+    }
+}
+
+static size_t skipDigitsSse2(const char* text, size_t pos) {
+    for (;;) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(text + pos));
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(rangeMask128(bytes, '0', '9'));
+        if (bits != 0xFFFFu) {
+            return pos + (size_t)__builtin_ctz(~bits);
+        }
+        pos += 16;
+    }
+}
+
+static size_t findLineEndSse2(const char* text, size_t pos) {
+    for (;;) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(text + pos));
+        __m128i stops = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')),
+                                     _mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(stops);
+        if (bits != 0) {
+            return pos + (size_t)__builtin_ctz(bits);
+        }
+        pos += 16;
+    }
+}
+
+/* ========== VERSIONES AVX2 (32 BYTES POR PASO) ========== */
+
+__attribute__((target("avx2")))
+static inline __m256i rangeMask256(__m256i bytes, char low, char high) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(low - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), bytes));
+}
+
+__attribute__((target("avx2")))
+static size_t skipBlanksAvx2(const char* text, size_t pos) {
+    for (;;) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(text + pos));
+        __m256i blanks = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                                         _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t')));
+        blanks = _mm256_or_si256(blanks, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r')));
+        blanks = _mm256_or_si256(blanks, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(blanks);
+        if (bits != 0xFFFFFFFFu) {
+            return pos + (size_t)__builtin_ctz(~bits);
+        }
+        pos += 32;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t skipIdentifierAvx2(const char* text, size_t pos) {
+    for (;;) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(text + pos));
+        __m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+        __m256i mask = _mm256_or_si256(rangeMask256(lower, 'a', 'z'), rangeMask256(bytes, '0', '9'));
+        mask = _mm256_or_si256(mask, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')));
+
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(mask);
+        if (bits != 0xFFFFFFFFu) {
+            return pos + (size_t)__builtin_ctz(~bits);
+        }
+        pos += 32;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t skipDigitsAvx2(const char* text, size_t pos) {
+    for (;;) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(text + pos));
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(rangeMask256(bytes, '0', '9'));
+        if (bits != 0xFFFFFFFFu) {
+            return pos + (size_t)__builtin_ctz(~bits);
+        }
+        pos += 32;
+    }
+}
+
+__attribute__((target("avx2")))
+static size_t findLineEndAvx2(const char* text, size_t pos) {
+    for (;;) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(text + pos));
+        __m256i stops = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')),
+                                        _mm256_cmpeq_epi8(bytes, _mm256_setzero_si256()));
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(stops);
+        if (bits != 0) {
+            return pos + (size_t)__builtin_ctz(bits);
+        }
+        pos += 32;
+    }
+}
+#endif
+
+/* ========== SELECCION EN TIEMPO DE EJECUCION ========== */
+
+/* Nucleos activos (por defecto los escalares hasta llamar a selectScanKernels) */
+ScanKernels scanKernels = {
+    skipBlanksScalar, skipIdentifierScalar, skipDigitsScalar, findLineEndScalar
+};
+
+/* Indica si ya se eligieron los nucleos (automaticamente o a pedido) */
+static int scanKernelsSelected = 0;
+
+/**
+ * Detecta el mejor juego de instrucciones disponible en el procesador
+ * @return: Nivel de nucleos mas rapido soportado
+ */
+ScanKernelLevel detectScanKernelLevel() {
+#if SCAN_HAS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SCAN_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SCAN_SSE2;
+#endif
+    return SCAN_SCALAR;
+}
+
+/**
+ * Activa los nucleos de un nivel determinado
+ * @param level: Nivel deseado
+ * @return: 1 si el nivel esta soportado y quedo activo, 0 en caso contrario
+ */
+int selectScanKernels(ScanKernelLevel level) {
+    if (level > detectScanKernelLevel()) {
+        return 0;
+    }
+    scanKernelsSelected = 1;
+
+#if SCAN_HAS_X86
+    if (level == SCAN_AVX2) {
+        ScanKernels avx2 = {skipBlanksAvx2, skipIdentifierAvx2, skipDigitsAvx2, findLineEndAvx2};
+        scanKernels = avx2;
+        return 1;
+    }
+    if (level == SCAN_SSE2) {
+        ScanKernels sse2 = {skipBlanksSse2, skipIdentifierSse2, skipDigitsSse2, findLineEndSse2};
+        scanKernels = sse2;
+        return 1;
+    }
+#endif
+
+    ScanKernels scalar = {skipBlanksScalar, skipIdentifierScalar, skipDigitsScalar, findLineEndScalar};
+    scanKernels = scalar;
+    return 1;
+}
+
+/**
+ * Elige los nucleos mas rapidos del procesador, salvo que ya se haya
+ * seleccionado un nivel explicitamente
+ */
+void initScanKernels() {
+    if (!scanKernelsSelected) {
+        selectScanKernels(detectScanKernelLevel());
+    }
+}
+
+/**
+ * Obtiene el nombre de un nivel de nucleos
+ * @param level: Nivel a describir
+ * @return: Nombre del nivel
+ */
+const char* scanKernelLevelName(ScanKernelLevel level) {
+    static const char* names[] = {"escalar", "SSE2", "AVX2"};
+    return names[level];
+}
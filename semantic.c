@@ -1,29 +1,95 @@
 #include "compilador.h"
 
-/* Variables globales del analizador semantico */
-Symbol* symbolTable = NULL;
+/* Variables globales del analizador semantico (la memoria de la tabla vive
+   en la arena de la compilacion) */
+SymbolTable symbolTable = {NULL, 0, 0, NULL, 0, NULL, 0, 0, 0};
 
 /**
- * Inicializa el analizador semantico
+ * Inicializa el analizador semantico con la tabla de simbolos vacia y sin
+ * valores conocidos
  */
 void initSemantic() {
-    symbolTable = NULL;
+    memset(&symbolTable, 0, sizeof(SymbolTable));
+    initConstants();
 }
 
 /**
- * Busca un simbolo en la tabla de simbolos
- * @param name: Nombre del simbolo a buscar
+ * Indica si la declaracion de un simbolo sigue visible: su ambito es el
+ * global o sigue abierto en la pila
+ * @param symbol: Simbolo de la tabla
+ * @return: 1 si esta visible, 0 si su bloque ya termino
+ */
+static inline int isSymbolVisible(const Symbol* symbol) {
+    return symbol->depth == 0 ||
+           (symbol->depth <= symbolTable.depth && symbolTable.openScopes[symbol->depth] == symbol->scopeSerial);
+}
+
+/**
+ * Obtiene la declaracion visible de un nombre. Las declaraciones vencidas
+ * que encuentra se saltan por el enlace shadowed y el indice queda apuntando
+ * a la visible, asi cada declaracion vencida se recorre una sola vez.
+ * @param nameId: Numero del nombre en identifierNames
+ * @return: Posicion del simbolo en la tabla, o -1 si no hay ninguno visible
+ */
+static int findVisibleSymbol(int nameId) {
+    if (nameId < 0 || nameId >= symbolTable.indexCapacity) {
+        return -1;
+    }
+    int index = symbolTable.indexByName[nameId];
+    while (index >= 0 && !isSymbolVisible(&symbolTable.entries[index])) {
+        index = symbolTable.entries[index].shadowed;
+    }
+    symbolTable.indexByName[nameId] = index;
+    return index;
+}
+
+/**
+ * Busca un simbolo visible en el ambito actual o en los que lo contienen
+ * @param nameId: Numero del nombre en identifierNames (valor del token identificador)
  * @return: Puntero al simbolo encontrado o NULL si no existe
  */
-Symbol* lookupSymbol(char* name) {
-    Symbol* current = symbolTable;
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return current;
+Symbol* lookupSymbol(int nameId) {
+    int index = findVisibleSymbol(nameId);
+    return index >= 0 ? &symbolTable.entries[index] : NULL;
+}
+
+/**
+ * Abre un ambito nuevo (bloque entre llaves) dentro del actual
+ * @return: 1 si se abrio, 0 si no hubo memoria
+ */
+int enterScope() {
+    if (symbolTable.depth + 1 >= symbolTable.scopeCapacity) {
+        int capacity = symbolTable.scopeCapacity ? symbolTable.scopeCapacity * 2 : 32;
+        unsigned int* grown = (unsigned int*)arenaResize(&compilationArena, symbolTable.openScopes,
+                                                         (size_t)symbolTable.scopeCapacity * sizeof(unsigned int),
+                                                         (size_t)capacity * sizeof(unsigned int));
+        if (grown == NULL) {
+            printf("ERROR CRITICO: No se pudo asignar memoria para los ambitos\n");
+            return 0;
         }
-        current = current->next;
+        symbolTable.openScopes = grown;
+        symbolTable.scopeCapacity = capacity;
     }
-    return NULL;
+    symbolTable.depth++;
+    symbolTable.openScopes[symbolTable.depth] = ++symbolTable.scopeSerial;
+    return 1;
+}
+
+/**
+ * Cierra el ambito actual. No recorre sus declaraciones: dejan de ser
+ * visibles porque su numero de ambito ya no esta en la pila.
+ */
+void exitScope() {
+    if (symbolTable.depth > 0) {
+        symbolTable.depth--;
+    }
+}
+
+/**
+ * Descarta la tabla de simbolos (su memoria vuelve con la arena de la compilacion)
+ */
+void releaseSymbolTable() {
+    memset(&symbolTable, 0, sizeof(SymbolTable));
 }
 
 /**
@@ -40,33 +106,50 @@ void initializeSymbolValue(Symbol* symbol, DataType type) {
 }
 
 /**
- * Crea y configura un nuevo simbolo
- * @param name: Nombre del simbolo
+ * Crea y configura un nuevo simbolo al final del arreglo de la tabla (todavia
+ * no se puede encontrar por nombre; ver insertSymbolInTable). Los punteros a
+ * simbolos son validos hasta la proxima declaracion, que puede mover el arreglo.
+ * @param nameId: Numero del nombre en identifierNames
+ * @param name: Nombre del simbolo (no necesita terminar en '\0')
+ * @param length: Longitud del nombre
  * @param type: Tipo de dato del simbolo
  * @return: Puntero al simbolo creado o NULL si hay error
  */
-Symbol* createSymbol(char* name, DataType type) {
-    if (name == NULL || strlen(name) == 0) {
+Symbol* createSymbol(int nameId, const char* name, int length, DataType type) {
+    if (name == NULL || length <= 0) {
         return NULL;
     }
     
-    Symbol* newSymbol = (Symbol*)malloc(sizeof(Symbol));
-    if (newSymbol == NULL) {
-        printf("ERROR CRITICO: No se pudo asignar memoria para el simbolo '%s'\n", name);
-        return NULL;
+    if (symbolTable.count == symbolTable.capacity) {
+        int capacity = symbolTable.capacity ? symbolTable.capacity * 2 : 64;
+        Symbol* grown = (Symbol*)arenaResize(&compilationArena, symbolTable.entries,
+                                             (size_t)symbolTable.capacity * sizeof(Symbol),
+                                             (size_t)capacity * sizeof(Symbol));
+        if (grown == NULL) {
+            printf("ERROR CRITICO: No se pudo asignar memoria para el simbolo '%.*s'\n", length, name);
+            return NULL;
+        }
+        symbolTable.entries = grown;
+        symbolTable.capacity = capacity;
     }
+    Symbol* newSymbol = &symbolTable.entries[symbolTable.count];
     
-    // Verificar que el nombre no sea demasiado largo
-    if (strlen(name) >= MAX_IDENTIFIER_LENGTH) {
-        printf("ERROR: Nombre de variable demasiado largo: '%s'\n", name);
-        free(newSymbol);
+    // El nombre se copia una sola vez, al declarar la variable
+    newSymbol->name = arenaCopyText(&compilationArena, name, (size_t)length);
+    if (newSymbol->name == NULL) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para el simbolo '%.*s'\n", length, name);
         return NULL;
     }
+    symbolTable.count++;
     
-    strcpy(newSymbol->name, name);
+    newSymbol->nameLength = length;
+    newSymbol->nameId = nameId;
     newSymbol->type = type;
     newSymbol->initialized = 0;
-    newSymbol->next = NULL;
+    newSymbol->shadowed = -1;
+    newSymbol->depth = symbolTable.depth;
+    newSymbol->scopeSerial = symbolTable.depth > 0 ? symbolTable.openScopes[symbolTable.depth] : 0;
+    newSymbol->constantSerial = 0;
     
     initializeSymbolValue(newSymbol, type);
     
@@ -74,41 +157,63 @@ Symbol* createSymbol(char* name, DataType type) {
 }
 
 /**
- * Inserta un simbolo en la tabla de simbolos
- * @param symbol: Simbolo a insertar
+ * Registra un simbolo creado con createSymbol para que se encuentre por nombre.
+ * Oculta la declaracion visible del mismo nombre, que vuelve a encontrarse
+ * al cerrar el ambito del simbolo.
+ * @param symbol: Simbolo a insertar (elemento del arreglo de la tabla)
  * @return: 1 si se inserto correctamente, 0 en caso contrario
  */
 int insertSymbolInTable(Symbol* symbol) {
-    if (symbol == NULL) {
+    if (symbol == NULL || symbol->nameId < 0) {
         return 0;
     }
     
-    symbol->next = symbolTable;
-    symbolTable = symbol;
+    if (symbol->nameId >= symbolTable.indexCapacity) {
+        int capacity = symbolTable.indexCapacity ? symbolTable.indexCapacity : 256;
+        while (capacity <= symbol->nameId) {
+            capacity *= 2;
+        }
+        int* grown = (int*)arenaResize(&compilationArena, symbolTable.indexByName,
+                                       (size_t)symbolTable.indexCapacity * sizeof(int),
+                                       (size_t)capacity * sizeof(int));
+        if (grown == NULL) {
+            return 0;
+        }
+        memset(grown + symbolTable.indexCapacity, 0xFF, (size_t)(capacity - symbolTable.indexCapacity) * sizeof(int));
+        symbolTable.indexByName = grown;
+        symbolTable.indexCapacity = capacity;
+    }
+    
+    symbol->shadowed = findVisibleSymbol(symbol->nameId);
+    symbolTable.indexByName[symbol->nameId] = (int)(symbol - symbolTable.entries);
     return 1;
 }
 
 /**
- * Inserta un nuevo simbolo en la tabla de simbolos
- * @param name: Nombre del simbolo
+ * Inserta un nuevo simbolo en el ambito actual
+ * @param nameId: Numero del nombre en identifierNames
+ * @param name: Nombre del simbolo (no necesita terminar en '\0')
+ * @param length: Longitud del nombre
  * @param type: Tipo de dato del simbolo
- * @return: Puntero al simbolo insertado o NULL si ya existe o hay error
+ * @return: Puntero al simbolo insertado o NULL si ya existe en este ambito o hay error
  */
-Symbol* insertSymbol(char* name, DataType type) {
-    // Verificar si el simbolo ya existe
-    if (lookupSymbol(name) != NULL) {
+Symbol* insertSymbol(int nameId, const char* name, int length, DataType type) {
+    // Verificar si el simbolo ya existe en el mismo ambito (uno exterior se
+    // oculta, igual que el que se agrego al informar un uso sin declarar)
+    Symbol* existing = lookupSymbol(nameId);
+    if (existing != NULL && existing->depth == symbolTable.depth && existing->type != TYPE_ERROR) {
         return NULL; // Ya existe
     }
     
     // Crear nuevo simbolo
-    Symbol* newSymbol = createSymbol(name, type);
+    Symbol* newSymbol = createSymbol(nameId, name, length, type);
     if (newSymbol == NULL) {
         return NULL;
     }
     
     // Insertar en la tabla
     if (!insertSymbolInTable(newSymbol)) {
-        free(newSymbol);
+        symbolTable.count--;
         return NULL;
     }
     
@@ -126,40 +231,6 @@ DataType getTokenDataType(TokenType type) {
            (type == TOKEN_REAL || type == TOKEN_REAL_LITERAL) ? TYPE_REAL : TYPE_ERROR;
 }
 
-/**
- * Verifica el tipo de una expresión simple (para análisis básico)
- * Esta función proporciona una verificación básica de tipos
- * @return: Tipo de dato de la expresión
- */
-DataType checkExpressionType() {
-    // Esta es una implementación simplificada
-    // En un compilador real, se necesitaría un análisis más complejo
-    
-    // Para este ejemplo, asumimos que la expresión es del tipo del último token procesado
-    if (currentToken.type == TOKEN_NUMBER) {
-        return TYPE_ENTERO;
-    }
-    
-    if (currentToken.type == TOKEN_REAL_LITERAL) {
-        return TYPE_REAL;
-    }
-    
-    if (currentToken.type == TOKEN_CHAR_LITERAL) {
-        return TYPE_CARACTER;
-    }
-    
-    if (currentToken.type == TOKEN_IDENTIFIER) {
-        Symbol* var = lookupSymbol(currentToken.lexeme);
-        if (var != NULL) {
-            return var->type;
-        }
-        return TYPE_ERROR;
-    }
-    
-    // Tipo por defecto para expresiones aritméticas
-    return TYPE_ENTERO;
-}
-
 /**
  * Verifica compatibilidad para asignacion a variable entera
  * @param var: Variable entera
@@ -171,13 +242,13 @@ void checkIntegerAssignment(Symbol* var, DataType exprType) {
     }
     
     if (exprType == TYPE_REAL) {
-        printf("ADVERTENCIA: Asignación de real a entero puede causar pérdida de precisión\n");
+        if (progressMessages) printf("ADVERTENCIA: Asignación de real a entero puede causar pérdida de precisión\n");
     } else if (exprType == TYPE_CARACTER) {
-        printf("ADVERTENCIA: Asignacion de caracter a entero (conversion automatica)\n");
+        if (progressMessages) printf("ADVERTENCIA: Asignacion de caracter a entero (conversion automatica)\n");
     } else {
-        char message[100];
-        sprintf(message, "Incompatibilidad de tipos: no se puede asignar tipo %d a variable entera '%s'", 
-               exprType, var->name);
+        char message[128];
+        snprintf(message, sizeof(message), "Incompatibilidad de tipos: no se puede asignar tipo %d a variable entera '%s'", 
+                 exprType, var->name);
         semanticError(message);
     }
 }
@@ -193,13 +264,13 @@ void checkRealAssignment(Symbol* var, DataType exprType) {
     }
     
     if (exprType == TYPE_ENTERO) {
-        printf("INFO: Conversion automatica de entero a real\n");
+        if (progressMessages) printf("INFO: Conversion automatica de entero a real\n");
     } else if (exprType == TYPE_CARACTER) {
-        printf("ADVERTENCIA: Asignacion de caracter a real (conversion automatica)\n");
+        if (progressMessages) printf("ADVERTENCIA: Asignacion de caracter a real (conversion automatica)\n");
     } else {
-        char message[100];
-        sprintf(message, "Incompatibilidad de tipos: no se puede asignar tipo %d a variable real '%s'", 
-               exprType, var->name);
+        char message[128];
+        snprintf(message, sizeof(message), "Incompatibilidad de tipos: no se puede asignar tipo %d a variable real '%s'", 
+                 exprType, var->name);
         semanticError(message);
     }
 }
@@ -215,11 +286,11 @@ void checkCharacterAssignment(Symbol* var, DataType exprType) {
     }
     
     if (exprType == TYPE_ENTERO) {
-        printf("ADVERTENCIA: Asignacion de entero a caracter (conversion automatica)\n");
+        if (progressMessages) printf("ADVERTENCIA: Asignacion de entero a caracter (conversion automatica)\n");
     } else {
-        char message[100];
-        sprintf(message, "Incompatibilidad de tipos: no se puede asignar tipo %d a variable caracter '%s'", 
-               exprType, var->name);
+        char message[128];
+        snprintf(message, sizeof(message), "Incompatibilidad de tipos: no se puede asignar tipo %d a variable caracter '%s'", 
+                 exprType, var->name);
         semanticError(message);
     }
 }
@@ -274,21 +345,10 @@ void checkAssignmentCompatibility(Symbol* var, DataType exprType) {
  * @param message: Mensaje descriptivo del error
  */
 void semanticError(char* message) {
-    hasError = 1;
-    printf("ERROR SEMANTICO en línea %d: %s\n", currentLine, message);
-}
-
-/**
- * Verifica que todas las variables utilizadas estén inicializadas
- * @param name: Nombre de la variable a verificar
- */
-void checkVariableInitialization(char* name) {
-    Symbol* var = lookupSymbol(name);
-    if (var != NULL && !var->initialized) {
-        char message[100];
-        sprintf(message, "Variable '%s' utilizada sin inicializar", name);
-        printf("ADVERTENCIA: %s\n", message);
+    if (!registerError(0)) {
+        return;
     }
+    printf("ERROR SEMANTICO en línea %d: %s\n", getTokenLine(currentToken), message);
 }
 
 /**
@@ -298,7 +358,7 @@ void checkVariableInitialization(char* name) {
  */
 DataType checkIntegerArithmetic(TokenType operator) {
     if (operator == TOKEN_DIVIDE) {
-        printf("ADVERTENCIA: División entera puede causar pérdida de precisión\n");
+        if (progressMessages) printf("ADVERTENCIA: División entera puede causar pérdida de precisión\n");
     }
     return TYPE_ENTERO;
 }
@@ -379,7 +439,7 @@ DataType checkArithmeticOperation(DataType leftType, DataType rightType, TokenTy
     
     if (resultType == TYPE_ERROR) {
         char message[100];
-        sprintf(message, "Operación aritmética no válida entre tipos %d y %d", leftType, rightType);
+        snprintf(message, sizeof(message), "Operación aritmética no válida entre tipos %d y %d", leftType, rightType);
         semanticError(message);
     }
     
@@ -411,7 +471,7 @@ int checkRelationalOperation(DataType leftType, DataType rightType) {
     }
     
     char message[100];
-    sprintf(message, "Comparación no válida entre tipos %d y %d", leftType, rightType);
+    snprintf(message, sizeof(message), "Comparación no válida entre tipos %d y %d", leftType, rightType);
     semanticError(message);
     return 0;
 }
\ No newline at end of file
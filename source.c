@@ -0,0 +1,187 @@
+#define _DEFAULT_SOURCE
+#include "compilador.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define SOURCE_USE_MMAP 1
+#else
+#define SOURCE_USE_MMAP 0
+#endif
+
+/* Tamano de bloque para leer entradas sin tamano conocido (tuberias, stdin) */
+#define SOURCE_READ_CHUNK (1 << 20)
+
+/**
+ * Reserva un buffer en el heap para el codigo fuente con el relleno en cero
+ * @param source: Buffer a inicializar
+ * @param capacity: Cantidad de bytes de texto que se podran guardar
+ * @return: 1 si se pudo reservar, 0 en caso contrario
+ */
+static int allocateSourceBuffer(SourceBuffer* source, size_t capacity) {
+    source->data = (char*)calloc(capacity + SOURCE_PADDING, 1);
+    source->length = 0;
+    source->mappedSize = 0;
+
+    if (source->data == NULL) {
+        printf("ERROR: No se pudo asignar memoria para el archivo\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Lee una entrada sin tamano conocido (tuberia o stdin) copiandola al heap
+ * @param file: Flujo de entrada abierto
+ * @param source: Buffer donde se guarda el contenido
+ * @return: 1 si la lectura fue exitosa, 0 en caso contrario
+ */
+static int readSourceStream(FILE* file, SourceBuffer* source) {
+    size_t capacity = SOURCE_READ_CHUNK;
+    if (!allocateSourceBuffer(source, capacity)) {
+        return 0;
+    }
+
+    for (;;) {
+        size_t bytesRead = fread(source->data + source->length, 1, capacity - source->length, file);
+        source->length += bytesRead;
+        if (source->length < capacity) {
+            break;
+        }
+
+        char* newData = (char*)realloc(source->data, capacity * 2 + SOURCE_PADDING);
+        if (newData == NULL) {
+            printf("ERROR: No se pudo asignar memoria para el archivo\n");
+            releaseSource(source);
+            return 0;
+        }
+        source->data = newData;
+        capacity *= 2;
+    }
+
+    if (ferror(file)) {
+        printf("ERROR: Fallo la lectura del codigo fuente\n");
+        releaseSource(source);
+        return 0;
+    }
+
+    memset(source->data + source->length, 0, SOURCE_PADDING);
+    return 1;
+}
+
+#if SOURCE_USE_MMAP
+/**
+ * Proyecta un archivo regular en memoria sin copiarlo. Se reserva primero una
+ * region anonima con el relleno y el archivo se proyecta sobre su inicio, de
+ * modo que despues del texto siempre hay bytes en cero.
+ * @param fd: Descriptor del archivo abierto
+ * @param length: Tamano del archivo
+ * @param source: Buffer donde se guarda la proyeccion
+ * @return: 1 si se pudo proyectar, 0 en caso contrario
+ */
+static int mapSourceFile(int fd, size_t length, SourceBuffer* source) {
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mappedSize = (length + SOURCE_PADDING + pageSize - 1) / pageSize * pageSize;
+
+    char* base = (char*)mmap(NULL, mappedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return 0;
+    }
+
+    if (length > 0 &&
+        mmap(base, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mappedSize);
+        return 0;
+    }
+
+    // El analizador recorre el archivo una sola vez, de principio a fin
+    madvise(base, mappedSize, MADV_SEQUENTIAL);
+
+    source->data = base;
+    source->length = length;
+    source->mappedSize = mappedSize;
+    return 1;
+}
+#endif
+
+/**
+ * Carga un archivo de codigo fuente. Los archivos regulares se proyectan en
+ * memoria; las tuberias, stdin ("-") y los sistemas sin mmap se leen al heap.
+ * @param filename: Nombre del archivo a leer ("-" para la entrada estandar)
+ * @param source: Buffer donde se deja el codigo fuente
+ * @return: 1 si la carga fue exitosa, 0 en caso contrario
+ */
+int loadSourceFile(const char* filename, SourceBuffer* source) {
+    if (strcmp(filename, "-") == 0) {
+        return readSourceStream(stdin, source);
+    }
+
+#if SOURCE_USE_MMAP
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("ERROR: No se pudo abrir el archivo '%s'\n", filename);
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+        mapSourceFile(fd, (size_t)info.st_size, source)) {
+        close(fd);
+        return 1;
+    }
+    close(fd);
+#endif
+
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        printf("ERROR: No se pudo abrir el archivo '%s'\n", filename);
+        return 0;
+    }
+
+    int success = readSourceStream(file, source);
+    fclose(file);
+    return success;
+}
+
+/**
+ * Carga el codigo fuente desde una cadena en memoria (codigo de ejemplo)
+ * @param text: Texto terminado en '\0'
+ * @param source: Buffer donde se deja una copia con relleno
+ * @return: 1 si la carga fue exitosa, 0 en caso contrario
+ */
+int loadSourceString(const char* text, SourceBuffer* source) {
+    size_t length = strlen(text);
+    if (!allocateSourceBuffer(source, length)) {
+        return 0;
+    }
+
+    memcpy(source->data, text, length);
+    source->length = length;
+    return 1;
+}
+
+/**
+ * Libera el codigo fuente (deshace la proyeccion o libera el heap)
+ * @param source: Buffer a liberar
+ */
+void releaseSource(SourceBuffer* source) {
+    if (source->data == NULL) {
+        return;
+    }
+
+#if SOURCE_USE_MMAP
+    if (source->mappedSize > 0) {
+        munmap(source->data, source->mappedSize);
+    } else {
+        free(source->data);
+    }
+#else
+    free(source->data);
+#endif
+
+    source->data = NULL;
+    source->length = 0;
+    source->mappedSize = 0;
+}
@@ -0,0 +1,348 @@
+#define _DEFAULT_SOURCE
+#include "compilador.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#define TOKENS_USE_THREADS 1
+#else
+#define TOKENS_USE_THREADS 0
+#endif
+
+/*
+ * Analisis lexico por adelantado y en paralelo. El lenguaje solo tiene
+ * comentarios de linea y los literales no cruzan saltos de linea, por lo que
+ * despues de un '\n' siempre comienza un token nuevo: el codigo se divide en
+ * bloques terminados en salto de linea y cada hilo los analiza por separado.
+ */
+
+/* Cantidad maxima de hilos del analisis paralelo */
+#define TOKENS_MAX_THREADS 64
+
+/* Tamano minimo de un bloque; por debajo no conviene lanzar otro hilo */
+#define TOKENS_MIN_CHUNK (64 * 1024)
+
+/* Bloque del codigo fuente asignado a un hilo */
+typedef struct {
+    size_t start;          // Primer byte del bloque
+    size_t end;            // Primer byte del bloque siguiente (despues de un '\n')
+    int isLast;            // El ultimo bloque tambien produce el TOKEN_EOF
+    size_t firstToken;     // Posicion del primer token en la secuencia unida (suma prefija)
+    TokenArray tokens;     // Tokens del bloque
+    InternTable names;     // Identificadores del bloque (el primero usa identifierNames)
+    int* remap;            // Numero local -> numero en identifierNames (NULL: sin cambios)
+    Arena scratch;         // Memoria propia del hilo (se libera al unir los bloques)
+    TokenArray* output;    // Secuencia unida
+    int ok;                // 0 si no hubo memoria para los tokens
+} TokenChunk;
+
+/**
+ * Obtiene la cantidad de procesadores disponibles
+ * @return: Cantidad de procesadores (al menos 1)
+ */
+int detectProcessorCount() {
+#if TOKENS_USE_THREADS && defined(_SC_NPROCESSORS_ONLN)
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0) {
+        return count > TOKENS_MAX_THREADS ? TOKENS_MAX_THREADS : (int)count;
+    }
+#endif
+    return 1;
+}
+
+/**
+ * Reserva espacio para una secuencia de tokens (un arreglo por campo)
+ * @param tokens: Secuencia a inicializar
+ * @param capacity: Cantidad de tokens a reservar
+ * @param arena: Arena donde viven los arreglos
+ * @return: 1 si se pudo reservar, 0 en caso contrario
+ */
+static int reserveTokenArray(TokenArray* tokens, size_t capacity, Arena* arena) {
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    tokens->types = (unsigned char*)arenaAlloc(arena, capacity * sizeof(unsigned char));
+    tokens->offsets = (size_t*)arenaAlloc(arena, capacity * sizeof(size_t));
+    tokens->lengths = (int*)arenaAlloc(arena, capacity * sizeof(int));
+    tokens->values = (TokenValue*)arenaAlloc(arena, capacity * sizeof(TokenValue));
+    tokens->count = 0;
+    tokens->capacity = capacity;
+    tokens->arena = arena;
+
+    if (!tokens->types || !tokens->offsets || !tokens->lengths || !tokens->values) {
+        freeTokenArray(tokens);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Duplica la capacidad de una secuencia de tokens
+ * @param tokens: Secuencia a agrandar
+ * @return: 1 si se pudo agrandar, 0 si no hubo memoria
+ */
+static int growTokenArray(TokenArray* tokens) {
+    size_t oldCapacity = tokens->capacity;
+    size_t capacity = oldCapacity * 2;
+    Arena* arena = tokens->arena;
+    void* grown;
+
+    if ((grown = arenaResize(arena, tokens->types, oldCapacity * sizeof(unsigned char), capacity * sizeof(unsigned char))) == NULL) return 0;
+    tokens->types = (unsigned char*)grown;
+    if ((grown = arenaResize(arena, tokens->offsets, oldCapacity * sizeof(size_t), capacity * sizeof(size_t))) == NULL) return 0;
+    tokens->offsets = (size_t*)grown;
+    if ((grown = arenaResize(arena, tokens->lengths, oldCapacity * sizeof(int), capacity * sizeof(int))) == NULL) return 0;
+    tokens->lengths = (int*)grown;
+    if ((grown = arenaResize(arena, tokens->values, oldCapacity * sizeof(TokenValue), capacity * sizeof(TokenValue))) == NULL) return 0;
+    tokens->values = (TokenValue*)grown;
+
+    tokens->capacity = capacity;
+    return 1;
+}
+
+/**
+ * Agrega un token al final de la secuencia, repartiendo sus campos
+ * @param tokens: Secuencia destino
+ * @param token: Token a agregar
+ * @return: 1 si se agrego, 0 si no hubo memoria
+ */
+static int appendToken(TokenArray* tokens, Token token) {
+    if (tokens->count == tokens->capacity && !growTokenArray(tokens)) {
+        return 0;
+    }
+
+    size_t index = tokens->count++;
+    tokens->types[index] = (unsigned char)token.type;
+    tokens->offsets[index] = token.offset;
+    tokens->lengths[index] = token.length;
+    tokens->values[index] = token.value;
+    return 1;
+}
+
+/**
+ * Arma un token a partir de los campos guardados en una posicion
+ * @param tokens: Secuencia de tokens
+ * @param index: Posicion del token (menor que tokens->count)
+ * @return: Token completo
+ */
+Token getStreamToken(const TokenArray* tokens, size_t index) {
+    Token token;
+    token.type = (TokenType)tokens->types[index];
+    token.offset = tokens->offsets[index];
+    token.length = tokens->lengths[index];
+    token.value = tokens->values[index];
+    return token;
+}
+
+/**
+ * Descarta una secuencia de tokens (la memoria vuelve con su arena)
+ * @param tokens: Secuencia a descartar
+ */
+void freeTokenArray(TokenArray* tokens) {
+    memset(tokens, 0, sizeof(TokenArray));
+}
+
+/**
+ * Libera la memoria propia de un bloque
+ * @param chunk: Bloque ya unido (o descartado)
+ */
+static void releaseChunk(TokenChunk* chunk) {
+    freeTokenArray(&chunk->tokens);
+    freeInternTable(&chunk->names);
+    freeArena(&chunk->scratch);
+    chunk->remap = NULL;
+}
+
+/**
+ * Primera fase: analiza un bloque con su propio recorrido. Un bloque unico
+ * deja sus tokens en la arena de la compilacion; si hay varios, cada uno usa
+ * su propia arena hasta la union.
+ * @param argument: Bloque a analizar (TokenChunk*)
+ * @return: NULL
+ */
+static void* lexChunk(void* argument) {
+    TokenChunk* chunk = (TokenChunk*)argument;
+    LexerCursor cursor = {chunk->start, chunk->start == 0 ? &identifierNames : &chunk->names};
+    Arena* arena = (chunk->start == 0 && chunk->isLast) ? &compilationArena : &chunk->scratch;
+
+    // Estimacion de un token cada tres bytes para evitar casi todas las copias
+    chunk->ok = reserveTokenArray(&chunk->tokens, (chunk->end - chunk->start) / 3 + 16, arena);
+    while (chunk->ok) {
+        Token token = scanToken(&cursor);
+        if (token.offset >= chunk->end && !chunk->isLast) {
+            break; // Pertenece al bloque siguiente
+        }
+        chunk->ok = appendToken(&chunk->tokens, token);
+        if (token.type == TOKEN_EOF) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Segunda fase: copia los tokens del bloque a su lugar en la secuencia unida.
+ * Las posiciones son absolutas; solo los numeros de los identificadores se
+ * traducen de la tabla local del bloque a identifierNames.
+ * @param argument: Bloque a copiar (TokenChunk*)
+ * @return: NULL
+ */
+static void* stitchChunk(void* argument) {
+    TokenChunk* chunk = (TokenChunk*)argument;
+    TokenArray* output = chunk->output;
+    size_t first = chunk->firstToken;
+    size_t count = chunk->tokens.count;
+
+    memcpy(output->types + first, chunk->tokens.types, count * sizeof(unsigned char));
+    memcpy(output->offsets + first, chunk->tokens.offsets, count * sizeof(size_t));
+    memcpy(output->lengths + first, chunk->tokens.lengths, count * sizeof(int));
+    memcpy(output->values + first, chunk->tokens.values, count * sizeof(TokenValue));
+    if (chunk->remap != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            TokenValue* value = &output->values[first + i];
+            if (output->types[first + i] == TOKEN_IDENTIFIER && value->intValue >= 0) {
+                value->intValue = chunk->remap[value->intValue];
+            }
+        }
+    }
+    releaseChunk(chunk);
+    return NULL;
+}
+
+/**
+ * Ejecuta una fase sobre todos los bloques, un hilo por bloque. Si no hay
+ * hilos disponibles los bloques se procesan en secuencia.
+ * @param phase: Funcion a ejecutar sobre cada bloque
+ * @param chunks: Bloques
+ * @param chunkCount: Cantidad de bloques
+ */
+static void runChunkPhase(void* (*phase)(void*), TokenChunk* chunks, int chunkCount) {
+#if TOKENS_USE_THREADS
+    pthread_t threads[TOKENS_MAX_THREADS];
+    int started[TOKENS_MAX_THREADS];
+
+    // El hilo actual se encarga del primer bloque
+    for (int i = 1; i < chunkCount; i++) {
+        started[i] = pthread_create(&threads[i], NULL, phase, &chunks[i]) == 0;
+    }
+    phase(&chunks[0]);
+    for (int i = 1; i < chunkCount; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            phase(&chunks[i]);
+        }
+    }
+#else
+    for (int i = 0; i < chunkCount; i++) {
+        phase(&chunks[i]);
+    }
+#endif
+}
+
+/**
+ * Divide el codigo fuente en bloques que terminan despues de un salto de linea
+ * @param length: Longitud del codigo fuente
+ * @param threadCount: Cantidad de hilos pedida
+ * @param chunks: Bloques resultantes
+ * @return: Cantidad de bloques
+ */
+static int splitIntoChunks(size_t length, int threadCount, TokenChunk* chunks) {
+    size_t maxChunks = length / TOKENS_MIN_CHUNK + 1;
+    size_t target;
+    int chunkCount = 0;
+    size_t start = 0;
+
+    if ((size_t)threadCount > maxChunks) {
+        threadCount = (int)maxChunks;
+    }
+    target = length / (size_t)threadCount;
+
+    while (chunkCount < threadCount) {
+        size_t end = length;
+        if (chunkCount < threadCount - 1 && start + target < length) {
+            const char* newline = (const char*)memchr(sourceCode + start + target, '\n',
+                                                      length - (start + target));
+            end = newline ? (size_t)(newline - sourceCode) + 1 : length;
+        }
+
+        memset(&chunks[chunkCount], 0, sizeof(TokenChunk));
+        chunks[chunkCount].start = start;
+        chunks[chunkCount].end = end;
+        chunkCount++;
+        start = end;
+        if (end == length) {
+            break;
+        }
+    }
+
+    chunks[chunkCount - 1].isLast = 1;
+    return chunkCount;
+}
+
+/**
+ * Analiza todo el codigo fuente por adelantado repartiendolo entre varios
+ * hilos. Cada hilo produce los tokens de su bloque; con la suma prefija de
+ * las cantidades de tokens cada bloque se copia a su lugar en una sola
+ * secuencia terminada en TOKEN_EOF, identica a la que produce getNextToken.
+ * @param source: Codigo fuente
+ * @param threadCount: Cantidad de hilos (0 para usar todos los procesadores)
+ * @param tokens: Secuencia resultante (en la arena de la compilacion)
+ * @return: 1 si el analisis fue exitoso, 0 si no hubo memoria
+ */
+int tokenizeSource(SourceBuffer* source, int threadCount, TokenArray* tokens) {
+    TokenChunk chunks[TOKENS_MAX_THREADS];
+    int chunkCount;
+    int ok = 1;
+    size_t total = 0;
+
+    initLexer(source->data, source->length);
+    if (threadCount <= 0) {
+        threadCount = detectProcessorCount();
+    }
+    if (threadCount > TOKENS_MAX_THREADS) {
+        threadCount = TOKENS_MAX_THREADS;
+    }
+
+    chunkCount = splitIntoChunks(source->length, threadCount, chunks);
+    runChunkPhase(lexChunk, chunks, chunkCount);
+
+    // Con un solo bloque los tokens ya estan en su lugar
+    if (chunkCount == 1 && chunks[0].ok) {
+        *tokens = chunks[0].tokens;
+        return 1;
+    }
+
+    // Suma prefija de las cantidades de tokens. Los nombres locales de cada
+    // bloque se internan en orden, asi los numeros coinciden con los del
+    // analisis secuencial.
+    for (int i = 0; i < chunkCount; i++) {
+        ok = ok && chunks[i].ok;
+        chunks[i].firstToken = total;
+        chunks[i].output = tokens;
+        total += chunks[i].tokens.count;
+
+        InternTable* names = &chunks[i].names;
+        if (i > 0 && ok && names->count > 0) {
+            chunks[i].remap = (int*)arenaAlloc(&chunks[i].scratch, (size_t)names->count * sizeof(int));
+            ok = chunks[i].remap != NULL;
+            for (int id = 0; ok && id < names->count; id++) {
+                chunks[i].remap[id] = internNameHashed(&identifierNames, names->offsets[id],
+                                                       names->lengths[id], names->hashes[id]);
+            }
+        }
+    }
+
+    if (!ok || !reserveTokenArray(tokens, total, &compilationArena)) {
+        for (int i = 0; i < chunkCount; i++) {
+            releaseChunk(&chunks[i]);
+        }
+        memset(tokens, 0, sizeof(TokenArray));
+        printf("ERROR: No se pudo asignar memoria para los tokens\n");
+        return 0;
+    }
+
+    runChunkPhase(stitchChunk, chunks, chunkCount);
+    tokens->count = total;
+    return 1;
+}
@@ -8,8 +8,8 @@
  * @param typeStr: Buffer donde almacenar el resultado
  */
 void dataTypeToString(DataType type, char* typeStr) {
-    static const char* typeNames[] = {"entero", "caracter", "real", "error"};
-    strcpy(typeStr, (type >= TYPE_ENTERO && type <= TYPE_ERROR) ? typeNames[type] : "desconocido");
+    static const char* typeNames[] = {"entero", "caracter", "real", "error", "logico"};
+    strcpy(typeStr, (type >= TYPE_ENTERO && type <= TYPE_LOGICO) ? typeNames[type] : "desconocido");
 }
 
 /**
@@ -22,8 +22,8 @@ void tokenTypeToString(TokenType tokenType, char* tokenStr) {
         "IDENTIFICADOR", "NUMERO", "CARACTER", "REAL", "CADENA",
         "TIPO_ENTERO", "TIPO_CARACTER", "TIPO_REAL",
         "SI", "SINO", "MIENTRAS", "REPETIR", "HASTA", "LEER", "ESCRIBIR",
-        "ASIGNACION", "SUMA", "RESTA", "MULTIPLICACION", "DIVISION", "MODULO",
-        "MENOR", "MAYOR", "MENOR_IGUAL", "MAYOR_IGUAL", "IGUAL", "DIFERENTE",
+        "SUMA", "RESTA", "MULTIPLICACION", "DIVISION", "MODULO", "ASIGNACION",
+        "IGUAL", "DIFERENTE", "MENOR", "MENOR_IGUAL", "MAYOR", "MAYOR_IGUAL",
         "Y", "O", "NO", "PARENTESIS_IZQ", "PARENTESIS_DER", "LLAVE_IZQ", 
         "LLAVE_DER", "PUNTO_COMA", "COMA", "FIN_ARCHIVO", "ERROR"
     };
@@ -43,7 +43,7 @@ void tokenTypeToString(TokenType tokenType, char* tokenStr) {
  * @return: 1 si es valido, 0 en caso contrario
  */
 int isValidIdentifier(char* identifier) {
-    if (identifier == NULL || strlen(identifier) == 0) {
+    if (identifier == NULL || identifier[0] == '\0') {
         return 0;
     }
     
@@ -53,14 +53,16 @@ int isValidIdentifier(char* identifier) {
     }
     
     // Resto de caracteres deben ser letras, digitos o guion bajo
-    for (int i = 1; identifier[i] != '\0'; i++) {
-        if (!isLetter(identifier[i]) && !isDigit(identifier[i])) {
+    int length = 1;
+    while (identifier[length] != '\0') {
+        if (!isLetter(identifier[length]) && !isDigit(identifier[length])) {
             return 0;
         }
+        length++;
     }
     
-    // Verificar que no sea palabra reservada
-    return (isKeyword(identifier) == TOKEN_IDENTIFIER);
+    // Verificar que no sea palabra reservada (misma busqueda que el analizador lexico)
+    return (lookupKeyword(identifier, length) == TOKEN_IDENTIFIER);
 }
 
 /**
@@ -95,12 +97,13 @@ int isValidRealNumber(char* realStr) {
 /* ========== FUNCIONES DE FORMATO Y PRESENTACION ========== */
 
 /**
- * Formatea un valor de simbolo como cadena
+ * Formatea un valor de simbolo como cadena. Solo se muestra el valor que la
+ * propagacion de constantes conoce al final del programa (o de su bloque).
  * @param symbol: Simbolo cuyo valor se quiere formatear
  * @param valueStr: Buffer donde almacenar el resultado
  */
 void formatSymbolValue(Symbol* symbol, char* valueStr) {
-    if (!symbol || !symbol->initialized) {
+    if (!symbol || !symbol->initialized || symbol->constantSerial == 0) {
         strcpy(valueStr, "N/A");
     } else if (symbol->type == TYPE_ENTERO) {
         sprintf(valueStr, "%d", symbol->value.intValue);
@@ -123,6 +126,40 @@ void formatLocation(int line, int column, char* locationStr) {
     sprintf(locationStr, "linea %d, columna %d", line, column);
 }
 
+/**
+ * Formatea el lexema de un token para mostrarlo en mensajes
+ * @param token: Token cuyo lexema se quiere mostrar
+ * @param lexemeStr: Buffer donde almacenar el resultado
+ * @param size: Tamano del buffer (los lexemas mas largos se recortan)
+ */
+void formatTokenLexeme(Token token, char* lexemeStr, int size) {
+    if (token.type == TOKEN_EOF) {
+        snprintf(lexemeStr, size, "EOF");
+    } else if (token.type == TOKEN_ERROR && token.value.intValue == LEXICAL_ERROR_UNCLOSED_CHAR) {
+        snprintf(lexemeStr, size, "ERROR: Caracter literal no cerrado");
+    } else if (token.type == TOKEN_ERROR && token.value.intValue == LEXICAL_ERROR_UNCLOSED_STRING) {
+        snprintf(lexemeStr, size, "ERROR: Cadena literal no cerrada");
+    } else if (token.type == TOKEN_ERROR && isprint((unsigned char)getTokenText(token)[0])) {
+        snprintf(lexemeStr, size, "ERROR: Carácter desconocido '%c'", getTokenText(token)[0]);
+    } else if (token.type == TOKEN_ERROR) {
+        snprintf(lexemeStr, size, "ERROR: Carácter desconocido (codigo %d)", (unsigned char)getTokenText(token)[0]);
+    } else {
+        snprintf(lexemeStr, size, "%.*s", token.length, getTokenText(token));
+    }
+}
+
+/**
+ * Imprime un token con su tipo, lexema y ubicacion
+ * @param token: Token a imprimir
+ */
+void printToken(Token token) {
+    char tokenStr[20], locationStr[50], lexemeStr[80];
+    tokenTypeToString(token.type, tokenStr);
+    formatLocation(getTokenLine(token), getTokenColumn(token), locationStr);
+    formatTokenLexeme(token, lexemeStr, sizeof(lexemeStr));
+    printf("%-24s %-15s %s\n", locationStr, tokenStr, lexemeStr);
+}
+
 /* ========== FUNCIONES DE DIAGNOSTICO ========== */
 
 /**
@@ -130,15 +167,7 @@ void formatLocation(int line, int column, char* locationStr) {
  * @return: Numero de simbolos
  */
 int countSymbols() {
-    int count = 0;
-    Symbol* current = symbolTable;
-    
-    while (current != NULL) {
-        count++;
-        current = current->next;
-    }
-    
-    return count;
+    return symbolTable.count;
 }
 
 /**
@@ -146,15 +175,13 @@ int countSymbols() {
  */
 void displaySymbolTableStatistics() {
     int total = 0, initialized = 0, integers = 0, reals = 0, chars = 0;
-    Symbol* current = symbolTable;
-    
-    while (current != NULL) {
+    for (int i = 0; i < symbolTable.count; i++) {
+        const Symbol* current = &symbolTable.entries[i];
         total++;
         if (current->initialized) initialized++;
         if (current->type == TYPE_ENTERO) integers++;
         else if (current->type == TYPE_REAL) reals++;
         else if (current->type == TYPE_CARACTER) chars++;
-        current = current->next;
     }
     
     printf("\n=== ESTADISTICAS ===\n");
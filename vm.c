@@ -0,0 +1,520 @@
+#include "compilador.h"
+#include <limits.h>
+#include <math.h>
+
+#if defined(__GNUC__) && !defined(VM_SWITCH_DISPATCH)
+#define VM_THREADED 1
+#else
+#define VM_THREADED 0
+#endif
+
+/*
+ * Maquina virtual de registros. Los registros no guardan su tipo: la
+ * traduccion ya eligio la operacion de cada tipo (ADD_I, ADD_R, LT_I...) y
+ * agrego las conversiones, asi que ninguna instruccion pregunta que clase de
+ * valor tiene. Enteros, caracteres y logicos se guardan como int; los
+ * caracteres ya reducidos a char.
+ *
+ * La aritmetica entera da la vuelta como la de la maquina, igual que el
+ * plegado de constantes. La division o el resto entero por cero detienen el
+ * programa con un error de ejecucion.
+ *
+ * Con GCC o Clang el ciclo usa hilado directo: antes de ejecutar, cada
+ * instruccion se copia con la direccion de la etiqueta que la implementa y
+ * cada implementacion termina saltando a la de la siguiente (goto calculado),
+ * sin volver a un switch central. Cada operacion tiene asi su propio salto
+ * indirecto, que el procesador predice por separado. Con otros compiladores
+ * (o definiendo VM_SWITCH_DISPATCH) las mismas implementaciones quedan como
+ * casos de un switch.
+ */
+
+/* Instruccion preparada para ejecutar */
+typedef struct {
+    const void* handler;         // Etiqueta que la implementa (hilado directo)
+    int a, b, c;
+    unsigned char opcode;
+} ThreadedInstruction;
+
+#if VM_THREADED
+#define VM_CASE(op) vm_##op:
+#define VM_HANDLER(op) [op] = &&vm_##op
+#define VM_DISPATCH() do { executed++; goto *ip->handler; } while (0)
+#else
+#define VM_CASE(op) case op:
+#define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT() do { ip++; VM_DISPATCH(); } while (0)
+#define VM_JUMP(target) do { ip = code + (target); VM_DISPATCH(); } while (0)
+#define REG(operand) registers[ip->operand]
+
+/* Registro: un valor sin tipo */
+typedef union {
+    int intValue;                // Enteros, caracteres y logicos
+    float realValue;
+} VmRegister;
+
+/**
+ * Convierte un real a entero. Fuera del rango de los enteros (o si no es un
+ * numero) el resultado es INT_MIN, como la conversion de la maquina.
+ * @param value: Real a convertir
+ * @return: Parte entera del valor
+ */
+static inline int realToInteger(float value) {
+    return (value >= -2147483648.0f && value < 2147483648.0f) ? (int)value : INT_MIN;
+}
+
+/**
+ * Obtiene el real guardado en el operando constante de una instruccion
+ * @param bits: Bits del real
+ * @return: Valor
+ */
+static inline float constantAsReal(int bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+/**
+ * Divide dos enteros (el divisor no es cero). INT_MIN / -1 da la vuelta.
+ * @param a: Dividendo
+ * @param b: Divisor
+ * @return: Cociente
+ */
+static inline int integerDivide(int a, int b) {
+    return (a == INT_MIN && b == -1) ? INT_MIN : a / b;
+}
+
+/**
+ * Resto de dos enteros (el divisor no es cero). INT_MIN % -1 es cero.
+ * @param a: Dividendo
+ * @param b: Divisor
+ * @return: Resto con el signo del dividendo
+ */
+static inline int integerRemainder(int a, int b) {
+    return b == -1 ? 0 : a % b;
+}
+
+/**
+ * Informa un error de ejecucion
+ * @param program: Programa en ejecucion
+ * @param pc: Instruccion que fallo
+ * @param message: Descripcion del error
+ */
+static void runtimeError(const BytecodeProgram* program, unsigned int pc, const char* message) {
+    fflush(stdout);
+    printf("ERROR DE EJECUCION en linea %d: %s\n", program->lines[pc], message);
+}
+
+/**
+ * Informa el error de ejecucion de una instruccion que fallo: una lectura
+ * sin un valor valido o una division entera por cero
+ * @param program: Programa en ejecucion
+ * @param pc: Instruccion que fallo
+ */
+void reportRuntimeError(const BytecodeProgram* program, unsigned int pc) {
+    const Instruction* instruction = &program->code[pc];
+
+    if (instruction->opcode == OP_READ_I || instruction->opcode == OP_READ_R ||
+        instruction->opcode == OP_READ_C) {
+        char message[160];
+        snprintf(message, sizeof(message), "Entrada no valida para la variable '%s'",
+                 symbolTable.entries[instruction->a].name);
+        runtimeError(program, pc, message);
+    } else {
+        runtimeError(program, pc, "Division por cero");
+    }
+}
+
+/**
+ * Lee un valor de la entrada estandar para leer(variable). Tambien la llama
+ * el codigo nativo (jit.c).
+ * @param opcode: OP_READ_I, OP_READ_R u OP_READ_C
+ * @param destination: Registro de la variable (4 bytes)
+ * @return: 1 si se leyo un valor valido, 0 si no
+ */
+int readRuntimeValue(OpCode opcode, void* destination) {
+    VmRegister* target = (VmRegister*)destination;
+
+    fflush(stdout);
+    if (opcode == OP_READ_R) {
+        return scanf("%f", &target->realValue) == 1;
+    }
+    if (opcode == OP_READ_C) {
+        char value;
+        if (scanf(" %c", &value) != 1) {
+            return 0;
+        }
+        target->intValue = value;
+        return 1;
+    }
+    return scanf("%d", &target->intValue) == 1;
+}
+
+/**
+ * Escribe un valor para escribir(expresion). Tambien la llama el codigo
+ * nativo (jit.c).
+ * @param opcode: OP_WRITE_I, OP_WRITE_R u OP_WRITE_C
+ * @param bits: Contenido del registro
+ */
+void writeRuntimeValue(OpCode opcode, int bits) {
+    switch (opcode) {
+        case OP_WRITE_R:
+            printf("%g\n", constantAsReal(bits));
+            break;
+        case OP_WRITE_C:
+            printf("%c\n", (char)bits);
+            break;
+        default:
+            printf("%d\n", bits);
+            break;
+    }
+}
+
+/**
+ * Calcula una suma de control (FNV-1a) de los valores finales de las
+ * variables, para comparar dos formas de ejecutar el mismo programa
+ * @param registers: Registros del programa (4 bytes cada uno)
+ * @param count: Cantidad de registros de variables
+ * @return: Suma de control
+ */
+unsigned int registerChecksum(const void* registers, unsigned int count) {
+    const unsigned char* bytes = (const unsigned char*)registers;
+    unsigned int hash = 2166136261u;
+
+    for (size_t i = 0; i < (size_t)count * sizeof(VmRegister); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Ejecuta un programa traducido. Las variables empiezan en cero.
+ * @param program: Programa de la maquina virtual
+ * @param stats: Estadisticas (puede ser NULL). Si stats->pairCounts no es
+ *               NULL se cuenta cada par de operaciones ejecutadas una detras
+ *               de otra en pairCounts[anterior * OP_COUNT + siguiente].
+ * @return: 1 si el programa termino, 0 si se detuvo por un error de ejecucion
+ */
+int executeProgram(const BytecodeProgram* program, VmStats* stats) {
+#if VM_THREADED
+    static const void* const handlers[OP_COUNT] = {
+        VM_HANDLER(OP_HALT), VM_HANDLER(OP_LOADK), VM_HANDLER(OP_MOVE),
+        VM_HANDLER(OP_CVT_I2R), VM_HANDLER(OP_CVT_R2I), VM_HANDLER(OP_CVT_I2C),
+        VM_HANDLER(OP_ADD_I), VM_HANDLER(OP_SUB_I), VM_HANDLER(OP_MUL_I), VM_HANDLER(OP_DIV_I), VM_HANDLER(OP_MOD_I),
+        VM_HANDLER(OP_ADD_R), VM_HANDLER(OP_SUB_R), VM_HANDLER(OP_MUL_R), VM_HANDLER(OP_DIV_R), VM_HANDLER(OP_MOD_R),
+        VM_HANDLER(OP_EQ_I), VM_HANDLER(OP_NE_I), VM_HANDLER(OP_LT_I),
+        VM_HANDLER(OP_LE_I), VM_HANDLER(OP_GT_I), VM_HANDLER(OP_GE_I),
+        VM_HANDLER(OP_EQ_R), VM_HANDLER(OP_NE_R), VM_HANDLER(OP_LT_R),
+        VM_HANDLER(OP_LE_R), VM_HANDLER(OP_GT_R), VM_HANDLER(OP_GE_R),
+        VM_HANDLER(OP_JUMP), VM_HANDLER(OP_JUMP_IF), VM_HANDLER(OP_JUMP_IF_NOT),
+        VM_HANDLER(OP_READ_I), VM_HANDLER(OP_READ_R), VM_HANDLER(OP_READ_C),
+        VM_HANDLER(OP_WRITE_I), VM_HANDLER(OP_WRITE_R), VM_HANDLER(OP_WRITE_C),
+        VM_HANDLER(OP_ADDK_I), VM_HANDLER(OP_SUBK_I), VM_HANDLER(OP_MULK_I), VM_HANDLER(OP_DIVK_I), VM_HANDLER(OP_MODK_I),
+        VM_HANDLER(OP_ADDK_R), VM_HANDLER(OP_SUBK_R), VM_HANDLER(OP_MULK_R), VM_HANDLER(OP_DIVK_R), VM_HANDLER(OP_MODK_R),
+        VM_HANDLER(OP_JEQ_I), VM_HANDLER(OP_JNE_I), VM_HANDLER(OP_JLT_I),
+        VM_HANDLER(OP_JLE_I), VM_HANDLER(OP_JGT_I), VM_HANDLER(OP_JGE_I),
+        VM_HANDLER(OP_JEQK_I), VM_HANDLER(OP_JNEK_I), VM_HANDLER(OP_JLTK_I),
+        VM_HANDLER(OP_JLEK_I), VM_HANDLER(OP_JGTK_I), VM_HANDLER(OP_JGEK_I)
+    };
+#endif
+    unsigned long long* pairCounts = stats != NULL ? stats->pairCounts : NULL;
+    ThreadedInstruction* code = (ThreadedInstruction*)malloc((program->count ? program->count : 1) *
+                                                             sizeof(ThreadedInstruction));
+    VmRegister* registers = (VmRegister*)calloc(program->registerCount ? program->registerCount : 1,
+                                                sizeof(VmRegister));
+    const ThreadedInstruction* ip = code;
+    unsigned long long executed = 0;
+    unsigned int previous = OP_COUNT;    // Operacion anterior (para el perfil)
+    int success = 1;
+
+    if (code == NULL || registers == NULL) {
+        printf("ERROR CRITICO: No se pudo asignar memoria para los registros de la maquina virtual\n");
+        free(code);
+        free(registers);
+        return 0;
+    }
+    for (unsigned int i = 0; i < program->count; i++) {
+        const Instruction* instruction = &program->code[i];
+        code[i].opcode = instruction->opcode;
+        code[i].a = instruction->a;
+        code[i].b = instruction->b;
+        code[i].c = instruction->c;
+#if VM_THREADED
+        code[i].handler = instruction->opcode >= OP_COUNT ? &&vm_invalid
+                        : pairCounts != NULL ? &&vm_profile
+                        : handlers[instruction->opcode];
+#else
+        code[i].handler = NULL;
+#endif
+    }
+
+#if VM_THREADED
+    VM_DISPATCH();
+
+vm_profile:
+    // Con perfil todas las instrucciones pasan por aqui antes de su etiqueta
+    if (previous < OP_COUNT) pairCounts[previous * OP_COUNT + ip->opcode]++;
+    previous = ip->opcode;
+    goto *handlers[ip->opcode];
+#else
+dispatch:
+    executed++;
+    if (pairCounts != NULL) {
+        if (previous < OP_COUNT && ip->opcode < OP_COUNT) pairCounts[previous * OP_COUNT + ip->opcode]++;
+        previous = ip->opcode;
+    }
+    switch (ip->opcode) {
+#endif
+
+    VM_CASE(OP_HALT)
+        goto finish;
+    VM_CASE(OP_LOADK)
+        REG(a).intValue = ip->b;
+        VM_NEXT();
+    VM_CASE(OP_MOVE)
+        REG(a) = REG(b);
+        VM_NEXT();
+    VM_CASE(OP_CVT_I2R)
+        REG(a).realValue = (float)REG(b).intValue;
+        VM_NEXT();
+    VM_CASE(OP_CVT_R2I)
+        REG(a).intValue = realToInteger(REG(b).realValue);
+        VM_NEXT();
+    VM_CASE(OP_CVT_I2C)
+        REG(a).intValue = (char)REG(b).intValue;
+        VM_NEXT();
+
+    VM_CASE(OP_ADD_I)
+        REG(a).intValue = (int)((unsigned int)REG(b).intValue + (unsigned int)REG(c).intValue);
+        VM_NEXT();
+    VM_CASE(OP_SUB_I)
+        REG(a).intValue = (int)((unsigned int)REG(b).intValue - (unsigned int)REG(c).intValue);
+        VM_NEXT();
+    VM_CASE(OP_MUL_I)
+        REG(a).intValue = (int)((unsigned int)REG(b).intValue * (unsigned int)REG(c).intValue);
+        VM_NEXT();
+    VM_CASE(OP_DIV_I)
+        if (REG(c).intValue == 0) goto divisionByZero;
+        REG(a).intValue = integerDivide(REG(b).intValue, REG(c).intValue);
+        VM_NEXT();
+    VM_CASE(OP_MOD_I)
+        if (REG(c).intValue == 0) goto divisionByZero;
+        REG(a).intValue = integerRemainder(REG(b).intValue, REG(c).intValue);
+        VM_NEXT();
+
+    VM_CASE(OP_ADD_R)
+        REG(a).realValue = REG(b).realValue + REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_SUB_R)
+        REG(a).realValue = REG(b).realValue - REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_MUL_R)
+        REG(a).realValue = REG(b).realValue * REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_DIV_R)
+        REG(a).realValue = REG(b).realValue / REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_MOD_R)
+        REG(a).realValue = fmodf(REG(b).realValue, REG(c).realValue);
+        VM_NEXT();
+
+    VM_CASE(OP_EQ_I)
+        REG(a).intValue = REG(b).intValue == REG(c).intValue;
+        VM_NEXT();
+    VM_CASE(OP_NE_I)
+        REG(a).intValue = REG(b).intValue != REG(c).intValue;
+        VM_NEXT();
+    VM_CASE(OP_LT_I)
+        REG(a).intValue = REG(b).intValue < REG(c).intValue;
+        VM_NEXT();
+    VM_CASE(OP_LE_I)
+        REG(a).intValue = REG(b).intValue <= REG(c).intValue;
+        VM_NEXT();
+    VM_CASE(OP_GT_I)
+        REG(a).intValue = REG(b).intValue > REG(c).intValue;
+        VM_NEXT();
+    VM_CASE(OP_GE_I)
+        REG(a).intValue = REG(b).intValue >= REG(c).intValue;
+        VM_NEXT();
+
+    // Las comparaciones de C ya son falsas con un valor que no es un numero, salvo !=
+    VM_CASE(OP_EQ_R)
+        REG(a).intValue = REG(b).realValue == REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_NE_R)
+        REG(a).intValue = REG(b).realValue != REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_LT_R)
+        REG(a).intValue = REG(b).realValue < REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_LE_R)
+        REG(a).intValue = REG(b).realValue <= REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_GT_R)
+        REG(a).intValue = REG(b).realValue > REG(c).realValue;
+        VM_NEXT();
+    VM_CASE(OP_GE_R)
+        REG(a).intValue = REG(b).realValue >= REG(c).realValue;
+        VM_NEXT();
+
+    VM_CASE(OP_JUMP)
+        VM_JUMP(ip->a);
+    VM_CASE(OP_JUMP_IF)
+        if (REG(b).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JUMP_IF_NOT)
+        if (!REG(b).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+
+    VM_CASE(OP_READ_I)
+    VM_CASE(OP_READ_R)
+    VM_CASE(OP_READ_C)
+        if (!readRuntimeValue((OpCode)ip->opcode, &REG(a))) {
+            reportRuntimeError(program, (unsigned int)(ip - code));
+            success = 0;
+            goto finish;
+        }
+        VM_NEXT();
+    VM_CASE(OP_WRITE_I)
+    VM_CASE(OP_WRITE_R)
+    VM_CASE(OP_WRITE_C)
+        writeRuntimeValue((OpCode)ip->opcode, REG(a).intValue);
+        VM_NEXT();
+
+    // Superinstrucciones: operaciones con una constante y comparaciones que saltan
+    VM_CASE(OP_ADDK_I)
+        REG(a).intValue = (int)((unsigned int)REG(b).intValue + (unsigned int)ip->c);
+        VM_NEXT();
+    VM_CASE(OP_SUBK_I)
+        REG(a).intValue = (int)((unsigned int)REG(b).intValue - (unsigned int)ip->c);
+        VM_NEXT();
+    VM_CASE(OP_MULK_I)
+        REG(a).intValue = (int)((unsigned int)REG(b).intValue * (unsigned int)ip->c);
+        VM_NEXT();
+    VM_CASE(OP_DIVK_I)
+        REG(a).intValue = integerDivide(REG(b).intValue, ip->c);
+        VM_NEXT();
+    VM_CASE(OP_MODK_I)
+        REG(a).intValue = integerRemainder(REG(b).intValue, ip->c);
+        VM_NEXT();
+    VM_CASE(OP_ADDK_R)
+        REG(a).realValue = REG(b).realValue + constantAsReal(ip->c);
+        VM_NEXT();
+    VM_CASE(OP_SUBK_R)
+        REG(a).realValue = REG(b).realValue - constantAsReal(ip->c);
+        VM_NEXT();
+    VM_CASE(OP_MULK_R)
+        REG(a).realValue = REG(b).realValue * constantAsReal(ip->c);
+        VM_NEXT();
+    VM_CASE(OP_DIVK_R)
+        REG(a).realValue = REG(b).realValue / constantAsReal(ip->c);
+        VM_NEXT();
+    VM_CASE(OP_MODK_R)
+        REG(a).realValue = fmodf(REG(b).realValue, constantAsReal(ip->c));
+        VM_NEXT();
+
+    VM_CASE(OP_JEQ_I)
+        if (REG(b).intValue == REG(c).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JNE_I)
+        if (REG(b).intValue != REG(c).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JLT_I)
+        if (REG(b).intValue < REG(c).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JLE_I)
+        if (REG(b).intValue <= REG(c).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JGT_I)
+        if (REG(b).intValue > REG(c).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JGE_I)
+        if (REG(b).intValue >= REG(c).intValue) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JEQK_I)
+        if (REG(b).intValue == ip->c) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JNEK_I)
+        if (REG(b).intValue != ip->c) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JLTK_I)
+        if (REG(b).intValue < ip->c) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JLEK_I)
+        if (REG(b).intValue <= ip->c) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JGTK_I)
+        if (REG(b).intValue > ip->c) VM_JUMP(ip->a);
+        VM_NEXT();
+    VM_CASE(OP_JGEK_I)
+        if (REG(b).intValue >= ip->c) VM_JUMP(ip->a);
+        VM_NEXT();
+
+#if !VM_THREADED
+    default:
+        goto vm_invalid;
+    }
+#endif
+
+vm_invalid:
+    runtimeError(program, (unsigned int)(ip - code), "Instruccion desconocida");
+    success = 0;
+    goto finish;
+divisionByZero:
+    reportRuntimeError(program, (unsigned int)(ip - code));
+    success = 0;
+finish:
+    fflush(stdout);
+    if (stats != NULL) {
+        stats->instructions = executed;
+        stats->checksum = registerChecksum(registers, program->variableCount);
+    }
+    free(code);
+    free(registers);
+    return success;
+}
+
+/**
+ * Obtiene el nombre del despacho con que se compilo la maquina virtual
+ * @return: Nombre para las mediciones
+ */
+const char* vmDispatchName() {
+    return VM_THREADED ? "hilado directo" : "switch";
+}
+
+/**
+ * Muestra los pares de operaciones que mas se ejecutaron una detras de otra
+ * (candidatos a superinstrucciones)
+ * @param pairCounts: Cuentas de executeProgram (OP_COUNT * OP_COUNT)
+ * @param limit: Cantidad maxima de pares a mostrar
+ */
+void printOpcodePairs(const unsigned long long* pairCounts, int limit) {
+    unsigned int pairs[OP_COUNT * OP_COUNT];
+    unsigned int count = 0;
+    unsigned long long total = 0;
+
+    for (unsigned int pair = 0; pair < OP_COUNT * OP_COUNT; pair++) {
+        if (pairCounts[pair] > 0) {
+            pairs[count++] = pair;
+            total += pairCounts[pair];
+        }
+    }
+    // Pocos pares distintos: insercion ordenada de mayor a menor
+    for (unsigned int i = 1; i < count; i++) {
+        unsigned int pair = pairs[i], j = i;
+        while (j > 0 && pairCounts[pairs[j - 1]] < pairCounts[pair]) {
+            pairs[j] = pairs[j - 1];
+            j--;
+        }
+        pairs[j] = pair;
+    }
+
+    printf("\n=== PARES DE OPERACIONES MAS EJECUTADOS ===\n");
+    for (unsigned int i = 0; i < count && (int)i < limit; i++) {
+        unsigned int pair = pairs[i];
+        printf("%-12s -> %-12s %14llu  %5.1f%%\n", opcodeName((OpCode)(pair / OP_COUNT)),
+               opcodeName((OpCode)(pair % OP_COUNT)), pairCounts[pair], 100.0 * pairCounts[pair] / total);
+    }
+    printf("===========================================\n");
+    printf("Pares ejecutados: %llu | Pares distintos: %u\n", total, count);
+}